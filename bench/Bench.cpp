@@ -0,0 +1,223 @@
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <random>
+#include <string_view>
+#include <vector>
+
+#include "Core/Helper/File.h"
+#include "Core/Project/Gesture.h"
+#include "Core/Store/Store.h"
+#include "Core/Store/StoreHistory.h"
+#include "Core/Store/StorePatch.h"
+
+/**
+Microbenchmarks for the state core: store maps, patches, history, action merging, and action JSON.
+
+Usage: `flowgrid-bench [--filter <substring>] [--out <path>] [--sample-ms <ms>]`
+Writes a JSON document with one entry per benchmark to `--out` (or stdout), and a readable summary to stderr.
+Build a release configuration for representative numbers.
+*/
+
+using BenchClock = std::chrono::steady_clock;
+
+// Keep the compiler from optimizing away a computed value.
+template<typename T> void DoNotOptimize(const T &value) { asm volatile("" : : "r,m"(value) : "memory"); }
+
+struct BenchResult {
+    std::string Name;
+    u32 ItemsPerIteration; // Operations performed by each call of the benchmark body.
+    u64 Iterations; // Total calls of the benchmark body, across all samples.
+    double MinNs, MedianNs, MeanNs; // Per item, across samples.
+};
+Json(BenchResult, Name, ItemsPerIteration, Iterations, MinNs, MedianNs, MeanNs);
+
+struct Bench {
+    std::string_view Filter;
+    float SampleMs{20};
+    u32 SampleCount{15};
+    std::vector<BenchResult> Results;
+
+    // Run `body` in samples of at least `SampleMs`, reporting the time per item.
+    void Run(std::string name, u32 items_per_iteration, auto &&body) {
+        if (!Filter.empty() && !name.contains(Filter)) return;
+
+        const auto time_iterations = [&body](u64 iterations) {
+            const auto start = BenchClock::now();
+            for (u64 i = 0; i < iterations; ++i) body();
+            return std::chrono::duration<double, std::nano>(BenchClock::now() - start).count();
+        };
+
+        // Calibrate the iteration count per sample, doubling until a sample takes long enough.
+        const double sample_ns = SampleMs * 1'000'000;
+        u64 iterations = 1;
+        for (double ns = time_iterations(iterations); ns < sample_ns && iterations < (1ull << 40); ns = time_iterations(iterations)) {
+            iterations = ns <= 0 ? iterations * 2 : std::max(iterations * 2, u64(double(iterations) * sample_ns / ns));
+        }
+
+        std::vector<double> item_ns(SampleCount);
+        for (auto &ns : item_ns) ns = time_iterations(iterations) / double(iterations * items_per_iteration);
+        std::ranges::sort(item_ns);
+
+        double sum = 0;
+        for (double ns : item_ns) sum += ns;
+        const auto &result = Results.emplace_back(std::move(name), items_per_iteration, iterations * SampleCount, item_ns.front(), item_ns[item_ns.size() / 2], sum / item_ns.size());
+        std::cerr << std::format("{:<48} {:>14.1f} ns/op (min {:.1f}, mean {:.1f})\n", result.Name, result.MedianNs, result.MinNs, result.MeanNs);
+    }
+};
+
+static constexpr ID FirstId = 1;
+static constexpr u32 OpsPerIteration = 1000;
+
+// A persistent store with `count` float values, keyed by IDs `[FirstId, FirstId + count)`.
+static PersistentStore CreateStore(u32 count) {
+    TransientStore s{PersistentStore{}.Transient()};
+    for (u32 i = 0; i < count; ++i) s.Set(FirstId + i, float(i));
+    return s.Persistent();
+}
+
+// `count` random IDs within a store of `store_size` values.
+static std::vector<ID> RandomIds(u32 count, u32 store_size) {
+    std::mt19937 rng{store_size};
+    std::uniform_int_distribution<ID> dist{FirstId, FirstId + store_size - 1};
+    std::vector<ID> ids(count);
+    for (auto &id : ids) id = dist(rng);
+    return ids;
+}
+
+static std::string SizeLabel(u32 size) {
+    if (size >= 1'000'000) return std::format("{}M", size / 1'000'000);
+    if (size >= 1'000) return std::format("{}k", size / 1'000);
+    return std::to_string(size);
+}
+
+static void BenchStoreMaps(Bench &bench, u32 size) {
+    const auto store = CreateStore(size);
+    const auto ids = RandomIds(OpsPerIteration, size);
+    const auto label = SizeLabel(size);
+
+    bench.Run(std::format("StoreMaps/Get/{}", label), OpsPerIteration, [&] {
+        float sum = 0;
+        for (ID id : ids) sum += store.Get<float>(id);
+        DoNotOptimize(sum);
+    });
+    bench.Run(std::format("StoreMaps/Set/{}", label), OpsPerIteration, [&] {
+        TransientStore s{store.Transient()};
+        for (ID id : ids) s.Set(id, float(id) + 0.5f);
+        DoNotOptimize(s);
+    });
+    bench.Run(std::format("StoreMaps/Erase/{}", label), OpsPerIteration, [&] {
+        TransientStore s{store.Transient()};
+        for (ID id : ids) s.Erase<float>(id);
+        DoNotOptimize(s);
+    });
+    // The round trip `Project` makes for each applied action.
+    bench.Run(std::format("StoreMaps/TransientPersistent/{}", label), 1, [&] {
+        TransientStore s{store.Transient()};
+        s.Set(ids.front(), 0.5f);
+        DoNotOptimize(s.Persistent());
+    });
+}
+
+static void BenchCreatePatch(Bench &bench, u32 size) {
+    const auto before = CreateStore(size);
+    const auto label = SizeLabel(size);
+    for (u32 change_count : {1u, std::max(1u, size / 100)}) {
+        TransientStore s{before.Transient()};
+        for (ID id : RandomIds(change_count, size)) s.Set(id, -float(id));
+        const PersistentStore after{s.Persistent()};
+        bench.Run(std::format("CreatePatch/{}/{}changes", label, change_count), 1, [&] { DoNotOptimize(CreatePatch(before, after, 0)); });
+    }
+}
+
+static void BenchAddGesture(Bench &bench, u32 size) {
+    const auto initial_store = CreateStore(size);
+    const auto ids = RandomIds(OpsPerIteration, size);
+    StoreHistory history{initial_store};
+    u32 i = 0;
+    PersistentStore store = initial_store;
+    bench.Run(std::format("StoreHistory/AddGesture/{}", SizeLabel(size)), 1, [&] {
+        TransientStore s{store.Transient()};
+        const ID id = ids[i++ % ids.size()];
+        s.Set(id, store.Get<float>(id) + 1);
+        store = s.Persistent();
+        history.AddGesture(store, {{{Action::Float::Set{id, store.Get<float>(id)}, Clock::now()}}, Clock::now()}, 0);
+        // Keep the history from growing without bound.
+        if (history.Size() > 1000) history.Clear(store);
+    });
+}
+
+static void BenchMergeActions(Bench &bench) {
+    const auto now = Clock::now();
+    SavedActionMoments same_id, alternating_ids, text_edits;
+    for (u32 i = 0; i < OpsPerIteration; ++i) {
+        same_id.push_back({Action::Float::Set{FirstId, float(i)}, now});
+        alternating_ids.push_back({Action::Float::Set{FirstId + i % 2, float(i)}, now});
+        text_edits.push_back({Action::TextBuffer::ApplyEdits{FirstId, {{i, i, "a"}}, {{{0, i + 1}, {0, i + 1}}}}, now});
+    }
+    bench.Run("MergeActions/SameId", OpsPerIteration, [&] { DoNotOptimize(MergeActions(same_id)); });
+    bench.Run("MergeActions/AlternatingIds", OpsPerIteration, [&] { DoNotOptimize(MergeActions(alternating_ids)); });
+    bench.Run("MergeActions/TextEdits", OpsPerIteration, [&] { DoNotOptimize(MergeActions(text_edits)); });
+}
+
+static void BenchActionJson(Bench &bench) {
+    const auto round_trip = [](const Action::Saved &action) {
+        const std::string serialized = json(action).dump();
+        DoNotOptimize(json::parse(serialized).get<Action::Saved>());
+    };
+
+    const Action::Saved float_set{Action::Float::Set{FirstId, 0.5f}};
+    bench.Run("ActionJson/FloatSet", 1, [&] { round_trip(float_set); });
+
+    PatchOps ops;
+    for (ID id = FirstId; id < FirstId + 100; ++id) ops[id] = {{PatchOpType::Replace, float(id), 0.f}};
+    const Action::Saved apply_patch{Action::Store::ApplyPatch{{0, std::move(ops)}}};
+    bench.Run("ActionJson/ApplyPatch/100ops", 1, [&] { round_trip(apply_patch); });
+
+    const Action::Saved apply_edits{Action::TextBuffer::ApplyEdits{FirstId, {{0, 0, std::string(1000, 'a')}}, {{{0, 1000}, {0, 1000}}}}};
+    bench.Run("ActionJson/ApplyEdits/1000chars", 1, [&] { round_trip(apply_edits); });
+
+    // A saved `.fga` project is a list of gestures.
+    Gesture gesture{{}, Clock::now()};
+    for (u32 i = 0; i < OpsPerIteration; ++i) gesture.Actions.push_back({Action::Float::Set{FirstId + i, float(i)}, Clock::now()});
+    bench.Run("ActionJson/Gesture/1000actions", OpsPerIteration, [&] {
+        const std::string serialized = json(gesture).dump();
+        DoNotOptimize(json::parse(serialized).get<Gesture>());
+    });
+}
+
+int main(int argc, char **argv) {
+    Bench bench;
+    fs::path out_path;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << std::format("Missing value for argument '{}'\n", arg);
+            return 1;
+        }
+        if (arg == "--filter") bench.Filter = argv[++i];
+        else if (arg == "--out") out_path = argv[++i];
+        else if (arg == "--sample-ms") bench.SampleMs = std::stof(argv[++i]);
+        else {
+            std::cerr << std::format("Unknown argument '{}'\n", arg);
+            return 1;
+        }
+    }
+
+    static constexpr u32 StoreSizes[]{1'000, 10'000, 100'000, 1'000'000};
+    for (u32 size : StoreSizes) BenchStoreMaps(bench, size);
+    for (u32 size : StoreSizes) BenchCreatePatch(bench, size);
+    for (u32 size : StoreSizes) BenchAddGesture(bench, size);
+    BenchMergeActions(bench);
+    BenchActionJson(bench);
+
+    const json results{{"benchmarks", bench.Results}};
+    if (out_path.empty()) {
+        std::cout << results.dump(2) << '\n';
+    } else if (!FileIO::write(out_path, results.dump(2))) {
+        std::cerr << std::format("Failed to write results to {}\n", out_path.string());
+        return 1;
+    }
+    return 0;
+}
@@ -24,7 +24,10 @@ void Audio::Apply(TransientStore &s, const ActionType &action) const {
             [this, &s](const Action::AudioGraph::Any &a) { Graph.Apply(s, a); },
             [this, &s](const Action::Faust::DSP::Create &) { Faust.FaustDsps.EmplaceBack(s, FaustDspPathSegment); },
             [this, &s](const Action::Faust::DSP::Delete &a) { Faust.FaustDsps.EraseId(s, a.id); },
+            [this](const Action::Faust::DSP::BenchmarkCompileProfiles &a) { Faust.BenchmarkCompileProfiles(a.id); },
+            [this, &s](const Action::Faust::DSP::Recompile &a) { Faust.Recompile(s, a.id); },
             [this, &s](const Action::Faust::Graph::Any &a) { Faust.Graphs.Apply(s, a); },
+            [this, &s](const Action::Faust::Params::Any &a) { Faust.Paramss.Apply(s, a); },
             [this, &s](const Action::Faust::GraphStyle::ApplyColorPreset &a) {
                 const auto &colors = Faust.Graphs.Style.Colors;
                 switch (a.id) {
@@ -52,6 +55,7 @@ bool Audio::CanApply(const ActionType &action) const {
         Match{
             [this](const Action::AudioGraph::Any &a) { return Graph.CanApply(a); },
             [this](const Action::Faust::Graph::Any &a) { return Faust.Graphs.CanApply(a); },
+            [this](const Action::Faust::Params::Any &a) { return Faust.Paramss.CanApply(a); },
             [](auto &&) { return true; },
         },
         action
@@ -6,6 +6,8 @@
 
 #include "imgui.h"
 
+#include "Core/Profiler.h"
+
 using std::string, std::string_view;
 using std::ranges::any_of, std::ranges::find_if;
 
@@ -240,6 +242,7 @@ void AudioDevice::Init() {
         }
     };
 
+    if (!ProfileRing) ProfileRing = Profiler::ReserveRing(IsInput() ? "Audio input" : "Audio output");
     result = ma_device_start(Device.get());
     if (result != MA_SUCCESS) throw std::runtime_error(std::format("Error starting audio {} device: {}", to_string(Type), int(result)));
 
@@ -278,6 +281,9 @@ void AudioDevice::Uninit() {
     Stop();
     ma_device_uninit(Device.get());
     Device.reset();
+    // The callback thread has exited.
+    Profiler::ReleaseRing(ProfileRing);
+    ProfileRing = nullptr;
 }
 
 void AudioDevice::Stop() {
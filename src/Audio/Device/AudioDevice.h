@@ -9,6 +9,10 @@
 
 #include "miniaudio.h"
 
+namespace Profiler {
+struct ZoneRing;
+}
+
 struct AudioDevice {
     using AudioCallback = void (*)(ma_device *, void *, const void *, u32);
 
@@ -73,6 +77,9 @@ struct AudioDevice {
     IO Type;
     AudioCallback Callback;
     UserData _UserData;
+    // Reserved while the device is initialized, so its callback thread records zones without locking or allocating.
+    // Callbacks record into it with `ProfileThreadRing`. Null if the profiler is compiled out.
+    Profiler::ZoneRing *ProfileRing{nullptr};
 
 private:
     void Init();
@@ -1,19 +1,64 @@
 #include "Faust.h"
 
+#include <atomic>
+#include <thread>
+#include <utility>
+
 #include "imgui.h"
 
 #include "Core/FileDialog/FileDialog.h"
 #include "Core/Helper/File.h"
+#include "Core/Profiler.h"
 #include "Core/Project/ProjectContext.h"
+#include "FaustLibraries.h"
 
 void Faust::Render() const {}
 
-FaustParamss::FaustParamss(ComponentArgs &&args, const FaustParamsStyle &style)
-    : ComponentVector(std::move(args), [](auto &&child_args) {
+FaustParamss::FaustParamss(ArgsT &&args, const FaustParamsStyle &style)
+    : ComponentVector(std::move(args.Args), [this](auto &&child_args) {
           const auto *uis = static_cast<const FaustParamss *>(child_args.Parent);
-          return std::make_unique<FaustParams>(std::move(child_args), uis->Style);
+          return std::make_unique<FaustParams>(FaustParams::ArgsT{std::move(child_args), SubProducer<FaustParams::ProducedActionType>(*this)}, uis->Style);
       }),
+      ActionableProducer(std::move(args.Q)),
       Style(style) {
+    RegisterTickListener(this);
+}
+
+FaustParamss::~FaustParamss() {
+    UnregisterTickListener(this);
+}
+
+void FaustParamss::OnTick() {
+    for (const auto *ui : *this) {
+        if (ui->IsLayoutBuilt()) Q(Action::Faust::Params::AdoptLayout{ui->DspId});
+    }
+}
+
+bool FaustParamss::IsBusy() const {
+    return std::any_of(begin(), end(), [](const auto *ui) { return ui->IsBuildingLayout(); });
+}
+
+void FaustParamss::Apply(TransientStore &s, const ActionType &action) const {
+    std::visit(
+        Match{
+            [this, &s](const Action::Faust::Params::AdoptLayout &a) {
+                if (auto *ui = FindUi(a.dsp_id)) ui->AdoptLayout(s);
+            },
+        },
+        action
+    );
+}
+
+bool FaustParamss::CanApply(const ActionType &action) const {
+    return std::visit(
+        Match{
+            [this](const Action::Faust::Params::AdoptLayout &a) {
+                const auto *ui = FindUi(a.dsp_id);
+                return ui && ui->IsLayoutBuilt();
+            },
+        },
+        action
+    );
 }
 
 FaustParams *FaustParamss::FindUi(ID dsp_id) const {
@@ -41,12 +86,14 @@ FaustGraphs::FaustGraphs(ArgsT &&args, const FaustGraphStyle &style, const Faust
       ),
       ActionableProducer(std::move(args.Q)),
       Style(style), Settings(settings) {
-    Style.FoldComplexity.RegisterChangeListener(this);
+    Style.RegisterChangeListener(this); // Notified on any descendent style change.
+    RegisterTickListener(this);
     AllInstances.insert(this);
 }
 
 FaustGraphs::~FaustGraphs() {
     AllInstances.erase(this);
+    UnregisterTickListener(this);
     UnregisterChangeListener(this);
 }
 
@@ -58,11 +105,24 @@ FaustGraph *FaustGraphs::FindGraph(ID dsp_id) const {
 }
 
 void FaustGraphs::OnComponentChanged() {
+    // Fold complexity changes the node tree structure. Any other style change only affects the layout of the existing tree.
     if (Style.FoldComplexity.IsChanged()) {
         for (auto *graph : *this) graph->ResetBox();
+    } else if (Style.IsChanged(true)) {
+        for (auto *graph : *this) graph->InvalidateLayout();
+    }
+}
+
+void FaustGraphs::OnTick() {
+    for (const auto *graph : *this) {
+        if (graph->IsNodeTreeBuilt()) Q(Action::Faust::Graph::AdoptNodeTree{graph->DspId});
     }
 }
 
+bool FaustGraphs::IsBusy() const {
+    return std::any_of(begin(), end(), [](const auto *graph) { return graph->IsBuildingNodeTree(); });
+}
+
 void FaustGraphs::Apply(TransientStore &, const ActionType &action) const {
     std::visit(
         Match{
@@ -78,6 +138,12 @@ void FaustGraphs::Apply(TransientStore &, const ActionType &action) const {
             [this](const Action::Faust::Graph::SaveSvgFile &a) {
                 if (const auto *graph = FindGraph(a.dsp_id)) graph->SaveBoxSvg(a.dir_path);
             },
+            [this](const Action::Faust::Graph::CancelSaveSvgFile &a) {
+                if (const auto *graph = FindGraph(a.dsp_id)) graph->CancelSvgExport();
+            },
+            [this](const Action::Faust::Graph::AdoptNodeTree &a) {
+                if (auto *graph = FindGraph(a.dsp_id)) graph->AdoptNodeTree();
+            },
         },
         action
     );
@@ -91,6 +157,14 @@ bool FaustGraphs::CanApply(const ActionType &action) const {
                 const auto *graph = FindGraph(a.dsp_id);
                 return graph && graph->RootNode;
             },
+            [this](const Action::Faust::Graph::CancelSaveSvgFile &a) {
+                const auto *graph = FindGraph(a.dsp_id);
+                return graph && graph->IsExportingSvg();
+            },
+            [this](const Action::Faust::Graph::AdoptNodeTree &a) {
+                const auto *graph = FindGraph(a.dsp_id);
+                return graph && graph->IsNodeTreeBuilt();
+            },
         },
         action
     );
@@ -99,21 +173,77 @@ bool FaustGraphs::CanApply(const ActionType &action) const {
 #include "Audio/Sample.h" // Must be included before any Faust includes.
 #include "faust/dsp/llvm-dsp.h"
 
+// Compiles a DSP on a worker thread: Parsing & evaluation, code generation & JIT, and creating and initializing the prototype instance.
+// Initializing the prototype also initializes the class state (e.g. waveform tables) shared by all instances cloned from it,
+// so audio nodes swapping in a clone only need to initialize its instance state.
+struct FaustCompileJob {
+    FaustCompileJob(std::string code, FaustCompileOptions options, u32 sample_rate)
+        : Code(std::move(code)), Options(options), LibrariesGeneration(FaustLibraries::GetGeneration()),
+          Worker([this, sample_rate] { Compile(sample_rate); }) {}
+    ~FaustCompileJob() {
+        Wait();
+        if (Result.Dsp) delete Result.Dsp;
+        if (Result.DspFactory) deleteDSPFactory(Result.DspFactory);
+    }
+
+    bool IsDone() const { return Done; }
+    void Wait() {
+        if (Worker.joinable()) Worker.join();
+    }
+
+    // Ownership of the result's DSP and factory moves to the caller.
+    FaustCompileResult TakeResult() { return std::exchange(Result, {}); }
+
+    const std::string Code;
+    const FaustCompileOptions Options;
+    const unsigned int LibrariesGeneration;
+
+private:
+    void Compile(u32 sample_rate) {
+        ProfileThread("Faust compile");
+        Result = CompileFaust(Code, Options);
+        if (Result.Dsp && sample_rate != 0) {
+            const auto init_start = std::chrono::steady_clock::now();
+            Result.Dsp->init(int(sample_rate));
+            Result.Times.InstanceMs += std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - init_start).count();
+        }
+        Done = true;
+    }
+
+    FaustCompileResult Result{}; // Only accessed by the UI thread once done.
+    std::atomic<bool> Done{false};
+    std::jthread Worker; // Declared last, so it's started after everything it uses is initialized.
+};
+
 FaustDSP::FaustDSP(ArgsT &&args, FaustDSPContainer &container)
     : ActionProducerComponent(std::move(args)), Container(container) {
     Editor.RegisterChangeListener(this);
+    CompileProfile.RegisterChangeListener(this); // Notified on any descendent profile change.
     Init(_S);
 }
 
 FaustDSP::~FaustDSP() {
     Uninit(_S);
+    ReclaimRetiredDsps(true);
     UnregisterChangeListener(this);
 }
 
 void FaustDSP::OnComponentChanged() {
-    if (Editor.IsChanged()) Update(_S);
+    // Profile changes are compiled right away, and code changes when `CompileScheduler` says they're ready.
+    if (CompileProfile.IsChanged(true)) StartCompile();
+    else if (Editor.IsChanged()) CompileScheduler.OnChanged();
+}
+
+void FaustDSP::StartCompile() {
+    std::erase_if(SupersededCompileJobs, [](const auto &job) { return job->IsDone(); });
+    if (CompileJob) SupersededCompileJobs.emplace_back(std::move(CompileJob));
+    CompileJob = std::make_unique<FaustCompileJob>(Editor.GetText(), CompileProfile.Get(), Container.GetSampleRate());
 }
 
+bool FaustDSP::IsCompiling() const { return CompileJob && !CompileJob->IsDone(); }
+bool FaustDSP::IsCompiled() const { return CompileJob && CompileJob->IsDone(); }
+bool FaustDSP::IsCompilePending() const { return CompileJob || CompileScheduler.IsPending(); }
+
 void FaustDSP::DestroyDsp() {
     if (Dsp) {
         delete Dsp;
@@ -125,33 +255,53 @@ void FaustDSP::DestroyDsp() {
     }
 }
 
-void FaustDSP::Init(TransientStore &s) {
+void FaustDSP::ReclaimRetiredDsps(bool force) {
+    std::erase_if(RetiredDsps, [this, force](const auto &retired) {
+        if (!force && Container.IsDspInUse(retired.Dsp)) return false;
+
+        delete retired.Dsp;
+        deleteDSPFactory(retired.DspFactory);
+        return true;
+    });
+}
+
+FaustCompileResult FaustDSP::Compile() const { return CompileFaust(Editor.GetText(), CompileProfile.Get()); }
+
+std::optional<FaustCompileResult> FaustDSP::TakeCompileResult() {
+    std::erase_if(SupersededCompileJobs, [](const auto &job) { return job->IsDone(); });
+    if (!CompileJob) return Compile();
+
+    const auto job = std::move(CompileJob);
+    job->Wait();
+    // Boxes compiled in a library context that has since been destroyed are invalid.
+    if (job->LibrariesGeneration != FaustLibraries::GetGeneration()) return Compile();
+    if (job->Code != Editor.GetText() || job->Options != CompileProfile.Get()) return {};
+    return job->TakeResult();
+}
+
+std::function<std::vector<FaustBenchmarkResult>()> FaustDSP::CreateCompileProfilesBenchmark() const {
+    static constexpr u32 BenchmarkSampleRate = 48000;
+    return [code = Editor.GetText(), options = CompileProfile.GetBenchmarkOptions()] {
+        if (code.empty()) return std::vector<FaustBenchmarkResult>{};
+        return BenchmarkFaustCompileOptions(code, options, BenchmarkSampleRate);
+    };
+}
+
+void FaustDSP::Init(TransientStore &s, float libraries_ms) {
     if (Editor.Empty()) return;
 
-    static const std::string libraries_path = fs::relative("../lib/faust/libraries");
-    std::vector<const char *> argv = {"-I", libraries_path.c_str()};
-    if (std::is_same_v<Sample, double>) argv.push_back("-double");
-    const int argc = argv.size();
-
-    const auto code = Editor.GetText();
-    static int num_inputs, num_outputs;
-    Box = DSPToBoxes("FlowGrid", code, argc, argv.data(), &num_inputs, &num_outputs, ErrorMessage);
-
-    if (Box && ErrorMessage.empty()) {
-        static constexpr int optimize_level = -1;
-        DspFactory = createDSPFactoryFromBoxes("FlowGrid", Box, argc, argv.data(), "", ErrorMessage, optimize_level);
-        if (DspFactory) {
-            if (ErrorMessage.empty()) {
-                Dsp = DspFactory->createDSPInstance();
-                if (!Dsp) ErrorMessage = "Successfully created Faust DSP factory, but could not create the Faust DSP instance.";
-            } else {
-                deleteDSPFactory(DspFactory);
-                DspFactory = nullptr;
-            }
-        }
-    } else if (!Box && ErrorMessage.empty()) {
-        ErrorMessage = "`DSPToBoxes` returned no error but did not produce a result.";
-    }
+    auto result = Compile();
+    result.Times.LibrariesMs = libraries_ms;
+    Init(s, std::move(result));
+}
+
+void FaustDSP::Init(TransientStore &s, FaustCompileResult &&result) {
+    CompileTimes = result.Times;
+    CompileScheduler.OnCompiled(CompileTimes.TotalMs());
+    Box = result.Box;
+    DspFactory = result.DspFactory;
+    Dsp = result.Dsp;
+    ErrorMessage = std::move(result.ErrorMessage);
     if (Box && Dsp) Container.NotifyListeners(s, Added, *this);
 }
 
@@ -162,11 +312,48 @@ void FaustDSP::Uninit(TransientStore &s) {
         if (Box) Box = nullptr;
     }
     ErrorMessage = "";
+    CompileTimes = {};
 }
 
 void FaustDSP::Update(TransientStore &s) {
-    Uninit(s);
-    Init(s);
+    ReclaimRetiredDsps();
+
+    const auto libraries_start = std::chrono::steady_clock::now();
+    // Reloading the library context invalidates all boxes, so all DSPs are recreated.
+    if (FaustLibraries::IsStale()) return static_cast<FaustDSPs *>(Parent)->ReloadLibraries(s);
+    const float libraries_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - libraries_start).count();
+
+    if (Editor.Empty()) {
+        CompileJob.reset();
+        Uninit(s);
+        return;
+    }
+
+    auto result = TakeCompileResult();
+    if (!result) return;
+
+    result->Times.LibrariesMs = libraries_ms;
+    if (!Dsp) {
+        Uninit(s);
+        Init(s, std::move(*result));
+        return;
+    }
+
+    // The current DSP kept running while its replacement compiled.
+    // Listeners swap to the new DSP on `Changed`, and may keep using the old one for a while (e.g. to crossfade).
+    CompileTimes = result->Times;
+    CompileScheduler.OnCompiled(CompileTimes.TotalMs());
+    if (result->Dsp) {
+        RetiredDsps.push_back({Dsp, DspFactory});
+        Box = result->Box;
+        DspFactory = result->DspFactory;
+        Dsp = result->Dsp;
+    } else if (result->DspFactory) {
+        deleteDSPFactory(result->DspFactory);
+    }
+    ErrorMessage = std::move(result->ErrorMessage);
+    Container.NotifyListeners(s, Changed, *this);
+    ReclaimRetiredDsps();
 }
 
 FaustDSPs::FaustDSPs(ArgsT &&args)
@@ -177,13 +364,71 @@ FaustDSPs::FaustDSPs(ArgsT &&args)
           );
       }),
       ActionProducer(std::move(args.Q)) {
-    createLibContext();
+    FaustLibraries::Acquire();
+    RegisterTickListener(this);
     WindowFlags |= ImGuiWindowFlags_MenuBar;
     EmplaceBack_(_S, FaustDspPathSegment);
 }
 
 FaustDSPs::~FaustDSPs() {
-    destroyLibContext();
+    UnregisterTickListener(this);
+    // Compile profile benchmarks run in this component's library context, so join them before releasing it.
+    static_cast<Faust *>(Parent)->Logs.BenchmarkResultsByFaustDspId.clear();
+    FaustLibraries::Release();
+}
+
+void FaustDSPs::OnTick() {
+    // Queue compiles for code changes once their DSP's scheduler says they're ready.
+    auto &logs = static_cast<Faust *>(Parent)->Logs;
+    for (auto *faust_dsp : *this) {
+        auto &scheduler = faust_dsp->CompileScheduler;
+        // Changes made while a compile is in progress are compiled after it's swapped in.
+        if (faust_dsp->IsCompiled()) Q(Action::Faust::DSP::Recompile{faust_dsp->Id});
+        else if (!faust_dsp->IsCompiling() && scheduler.Poll(faust_dsp->Editor.HasSyntaxErrors())) faust_dsp->StartCompile();
+        logs.CompileStatsByFaustDspId[faust_dsp->Id] = scheduler.Stats;
+    }
+}
+
+bool FaustDSPs::IsBusy() const {
+    return std::any_of(begin(), end(), [](const auto *faust_dsp) { return faust_dsp->IsCompilePending(); });
+}
+
+void FaustDSPs::ReloadLibraries(TransientStore &s) {
+    for (auto *faust_dsp : *this) {
+        // Compiles in progress hold the libraries lock, and would produce boxes from the destroyed context.
+        faust_dsp->CompileJob.reset();
+        faust_dsp->SupersededCompileJobs.clear();
+        faust_dsp->Uninit(s);
+    }
+
+    const auto libraries_start = std::chrono::steady_clock::now();
+    FaustLibraries::Reload();
+    const float libraries_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - libraries_start).count();
+
+    for (auto *faust_dsp : *this) faust_dsp->Init(s, libraries_ms);
+}
+
+void Faust::BenchmarkCompileProfiles(ID faust_dsp_id) const {
+    if (const auto *faust_dsp = FaustDsps.Find(faust_dsp_id)) {
+        Logs.BenchmarkResultsByFaustDspId[faust_dsp_id].Start(faust_dsp->CreateCompileProfilesBenchmark());
+    }
+}
+
+void Faust::Recompile(TransientStore &s, ID faust_dsp_id) const {
+    if (auto *faust_dsp = FaustDsps.Find(faust_dsp_id)) faust_dsp->Update(s);
+}
+
+u32 Faust::GetSampleRate() const {
+    for (const auto *listener : DspChangeListeners) {
+        if (const u32 sample_rate = listener->GetFaustSampleRate()) return sample_rate;
+    }
+    return 0;
+}
+
+bool Faust::IsDspInUse(const dsp *dsp) const {
+    // Params keep using the previous DSP until the new DSP's param layout is adopted.
+    return std::any_of(Paramss.begin(), Paramss.end(), [dsp](const auto *ui) { return ui->IsUsingDsp(dsp); }) ||
+        std::ranges::any_of(DspChangeListeners, [dsp](const auto *listener) { return listener->IsFaustDspInUse(dsp); });
 }
 
 void Faust::NotifyListeners(TransientStore &s, NotificationType type, FaustDSP &faust_dsp) {
@@ -194,6 +439,7 @@ void Faust::NotifyListeners(TransientStore &s, NotificationType type, FaustDSP &
         if (auto *ui = Paramss.FindUi(id)) ui->SetDsp(dsp);
         if (auto *graph = Graphs.FindGraph(id)) graph->SetBox(box);
         Logs.ErrorMessageByFaustDspId[id] = faust_dsp.ErrorMessage;
+        Logs.CompileTimesByFaustDspId[id] = faust_dsp.CompileTimes;
         for (auto *listener : DspChangeListeners) listener->OnFaustDspChanged(s, id, dsp);
     } else if (type == Added) {
         // Params
@@ -224,12 +470,16 @@ void Faust::NotifyListeners(TransientStore &s, NotificationType type, FaustDSP &
 
         // Logs
         Logs.ErrorMessageByFaustDspId[id] = faust_dsp.ErrorMessage;
+        Logs.CompileTimesByFaustDspId[id] = faust_dsp.CompileTimes;
 
         // External listeners
         for (auto *listener : DspChangeListeners) listener->OnFaustDspAdded(s, id, dsp);
     } else if (type == Removed) {
         for (auto *listener : DspChangeListeners) listener->OnFaustDspRemoved(s, id);
         Logs.ErrorMessageByFaustDspId.erase(id);
+        Logs.BenchmarkResultsByFaustDspId.erase(id);
+        Logs.CompileTimesByFaustDspId.erase(id);
+        Logs.CompileStatsByFaustDspId.erase(id);
         if (auto *graph = Graphs.FindGraph(id)) Graphs.EraseId_(s, graph->Id);
         if (auto *ui = Paramss.FindUi(id)) Paramss.EraseId_(s, ui->Id);
     }
@@ -284,14 +534,74 @@ void FaustLogs::RenderErrorMessage(std::string_view error_message) const {
     }
 }
 
+void FaustLogs::RenderBenchmarkResults(const std::vector<FaustBenchmarkResult> &results) const {
+    SeparatorText("Compile profile benchmark");
+    if (BeginTable("Benchmark", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_SizingFixedFit)) {
+        TableSetupColumn("Profile");
+        TableSetupColumn("Compile");
+        TableSetupColumn("Compute per block");
+        TableSetupColumn("Error", ImGuiTableColumnFlags_WidthStretch);
+        TableHeadersRow();
+        for (const auto &result : results) {
+            TableNextRow();
+            TableNextColumn();
+            TextUnformatted(result.Options.GetLabel());
+            if (!result.ErrorMessage.empty()) {
+                TableSetColumnIndex(3);
+                TextUnformatted(result.ErrorMessage);
+                continue;
+            }
+            TableNextColumn();
+            Text("%.1f ms", result.CompileMs);
+            TableNextColumn();
+            Text("%.2f us", result.ComputeNsPerBlock / 1000);
+        }
+        EndTable();
+    }
+}
+
+void FaustLogs::RenderCompileTimes(const FaustCompileTimes &times) const {
+    Text("Compiled in %.1f ms", times.TotalMs());
+    Indent();
+    Text("Library check: %.1f ms", times.LibrariesMs);
+    Text("Parse & evaluate: %.1f ms", times.BoxesMs);
+    Text("Signals, codegen & JIT: %.1f ms", times.FactoryMs);
+    Text("Instantiate: %.1f ms", times.InstanceMs);
+    Unindent();
+}
+
+void FaustLogs::RenderCompileStats(const FaustCompileStats &stats) const {
+    Text("Code changes: %u, compiled: %u, avoided: %u", stats.ChangeCount, stats.CompileCount, stats.AvoidedCount());
+    Indent();
+    Text("Held back for syntax errors: %u", stats.SyntaxErrorDeferCount);
+    Unindent();
+}
+
+void FaustLogs::RenderLog(ID faust_dsp_id, std::string_view error_message) const {
+    RenderErrorMessage(error_message);
+    if (auto it = CompileTimesByFaustDspId.find(faust_dsp_id); it != CompileTimesByFaustDspId.end()) {
+        RenderCompileTimes(it->second);
+    }
+    if (auto it = CompileStatsByFaustDspId.find(faust_dsp_id); it != CompileStatsByFaustDspId.end()) {
+        RenderCompileStats(it->second);
+    }
+    if (auto it = BenchmarkResultsByFaustDspId.find(faust_dsp_id); it != BenchmarkResultsByFaustDspId.end()) {
+        if (it->second.IsRunning()) TextUnformatted("Benchmarking compile profiles...");
+        if (const auto results = it->second.Get()) RenderBenchmarkResults(*results);
+    }
+}
+
 void FaustLogs::Render() const {
     if (ErrorMessageByFaustDspId.empty()) return TextUnformatted("No Faust DSPs created yet.");
-    if (ErrorMessageByFaustDspId.size() == 1) return RenderErrorMessage(ErrorMessageByFaustDspId.begin()->second);
+    if (ErrorMessageByFaustDspId.size() == 1) {
+        const auto &[faust_dsp_id, error_message] = *ErrorMessageByFaustDspId.begin();
+        return RenderLog(faust_dsp_id, error_message);
+    }
 
     if (BeginTabBar("")) {
         for (const auto &[faust_dsp_id, error_message] : ErrorMessageByFaustDspId) {
             if (BeginTabItem(std::format("{}", faust_dsp_id).c_str())) {
-                RenderErrorMessage(error_message);
+                RenderLog(faust_dsp_id, error_message);
                 EndTabItem();
             }
         }
@@ -335,6 +645,11 @@ void FaustDSP::Render() const {
             if (BeginMenu("Current DSP")) {
                 if (MenuItem("Create audio node")) Q(Action::AudioGraph::CreateFaustNode{Id});
                 if (MenuItem("Delete")) Q(Action::Faust::DSP::Delete{Id});
+                if (BeginMenu("Compile profile")) {
+                    CompileProfile.Draw();
+                    if (MenuItem("Benchmark all modes")) Q(Action::Faust::DSP::BenchmarkCompileProfiles{Id});
+                    EndMenu();
+                }
                 EndMenu();
             }
             EndMenu();
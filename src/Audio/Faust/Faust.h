@@ -1,6 +1,8 @@
 #pragma once
 
 #include "FaustAction.h"
+#include "FaustCompileProfile.h"
+#include "FaustCompileScheduler.h"
 #include "FaustDSPListener.h"
 #include "FaustGraph.h"
 #include "FaustGraphStyle.h"
@@ -11,15 +13,21 @@
 #include "Core/Action/ActionMenuItem.h"
 #include "Core/ActionProducerComponent.h"
 #include "Core/Container/ComponentVector.h"
+#include "Core/Helper/BackgroundResult.h"
 #include "Core/TextEditor/TextEditor.h"
 
 /**
 - `Audio.Faust.FaustGraphs` (listens to `FaustDSP::Box`): Extensively configurable, live-updating block diagrams for all Faust DSP instances.
+  - Node trees are built from boxes on background threads, and adopted by the UI thread once built.
   - By default, `FaustGraph` matches the FlowGrid style (which is ImGui's dark style), but it can be configured to exactly match the Faust SVG diagram style.
     `FaustGraph` can also be rendered as an SVG diagram.
     When the graph style is set to the 'Faust' preset, it should look the same as the one produced by `faust2svg` with the same DSP code.
 - `Audio.Faust.Params` (listens to `FaustDsp::Dsp`): Interfaces for the params for each Faust DSP instance. TODO: Not undoable yet.
-- `Audio.Faust.Logs` (listens to `FaustDSP`, accesses error messages): A window to display Faust compilation errors.
+  - Param layouts are built on background threads. Adopting a layout keeps the params with unchanged paths.
+- `Audio.Faust.Logs` (listens to `FaustDSP`, accesses error messages and compile times): A window to display Faust compilation errors, compile time breakdowns, and compile profile benchmarks.
+
+Code changes are compiled when each DSP's `FaustCompileScheduler` says they're ready, rather than on every edit.
+Finished compiles are swapped in by a saved `Recompile` action, so replaying a project's actions recompiles at the same points.
 
 Here is the chain of notifications/updates in response to a Faust DSP code change:
 ```
@@ -32,11 +40,20 @@ Audio.Faust.FaustDsp.Code -> Audio.Faust.FaustDsp
 ```
 **/
 
-struct FaustParamss : ComponentVector<FaustParams> {
-    FaustParamss(ComponentArgs &&, const FaustParamsStyle &);
+struct FaustParamss : ComponentVector<FaustParams>, ActionableProducer<Action::Faust::Params::Any>, TickListener {
+    using ArgsT = ProducerComponentArgs<ProducedActionType>;
+
+    FaustParamss(ArgsT &&, const FaustParamsStyle &);
+    ~FaustParamss();
+
+    void Apply(TransientStore &, const ActionType &) const override;
+    bool CanApply(const ActionType &) const override;
 
     FaustParams *FindUi(ID dsp_id) const;
 
+    void OnTick() override; // Adopt built layouts, whether or not their windows are visible.
+    bool IsBusy() const override;
+
     const FaustParamsStyle &Style;
 
 protected:
@@ -46,7 +63,8 @@ protected:
 struct FaustGraphs
     : ComponentVector<FaustGraph>,
       ActionableProducer<Action::Faust::Graph::Any, FaustGraph::ProducedActionType>,
-      ChangeListener {
+      ChangeListener,
+      TickListener {
     using ArgsT = ProducerComponentArgs<ProducedActionType>;
 
     FaustGraphs(ArgsT &&, const FaustGraphStyle &, const FaustGraphSettings &);
@@ -58,6 +76,8 @@ struct FaustGraphs
     FaustGraph *FindGraph(ID dsp_id) const;
 
     void OnComponentChanged() override;
+    void OnTick() override; // Adopt built node trees, whether or not their windows are visible.
+    bool IsBusy() const override;
 
     ActionMenuItem<ActionType>
         ShowSaveSvgDialogMenuItem{*this, SubProducer<ActionType>(*this), Action::Faust::Graph::ShowSaveSvgDialog{}};
@@ -75,15 +95,22 @@ struct FaustLogs : Component {
     using Component::Component;
 
     std::map<ID, std::string> ErrorMessageByFaustDspId;
+    std::map<ID, FaustCompileTimes> CompileTimesByFaustDspId;
+    std::map<ID, FaustCompileStats> CompileStatsByFaustDspId;
+    mutable std::map<ID, BackgroundResult<std::vector<FaustBenchmarkResult>>> BenchmarkResultsByFaustDspId;
 
 private:
     void Render() const override;
+    void RenderLog(ID faust_dsp_id, std::string_view error_message) const;
     void RenderErrorMessage(std::string_view error_message) const;
+    void RenderCompileTimes(const FaustCompileTimes &) const;
+    void RenderCompileStats(const FaustCompileStats &) const;
+    void RenderBenchmarkResults(const std::vector<FaustBenchmarkResult> &) const;
 };
 
 class llvm_dsp_factory;
 enum NotificationType {
-    Changed, // Note: This isn't actually used yet. When the DSP changes, we always Remove/Add the FaustDSP.
+    Changed, // The DSP was hot-swapped with a recompiled one, or failed to recompile (keeping the previous DSP).
     Added,
     Removed
 };
@@ -93,12 +120,18 @@ inline static constexpr std::string_view FaustDspPathSegment{"FaustDSP"};
 struct FaustDSP;
 struct FaustDSPContainer {
     virtual void NotifyListeners(TransientStore &, NotificationType, FaustDSP &) = 0;
+    virtual bool IsDspInUse(const dsp *) const = 0;
+    virtual u32 GetSampleRate() const = 0; // Zero if unknown.
 };
 
+struct FaustCompileJob;
+
 using FaustDspProducedActionType = Action::Append<Action::Faust::DSP::Any, typename Action::AudioGraph::CreateFaustNode>;
 
 // `FaustDSP` is a wrapper around a Faust DSP and Box.
 // It owns a Faust DSP code buffer, and updates its DSP and Box instances to reflect the current code.
+// `Dsp` is a prototype instance: It holds the param values (controlled by `FaustParams`), but is never computed.
+// Audio graph nodes compute their own `FaustInstance`s cloned from it, sharing its factory.
 struct FaustDSP : ActionProducerComponent<FaustDspProducedActionType>, ChangeListener {
     FaustDSP(ArgsT &&, FaustDSPContainer &);
     ~FaustDSP();
@@ -107,31 +140,74 @@ struct FaustDSP : ActionProducerComponent<FaustDspProducedActionType>, ChangeLis
 
     inline static const std::string FaustDspFileExtension = ".dsp";
 
+    // Returns a benchmark that compiles each profile, and measures its compute time in a headless harness.
+    // It holds its own copy of the code, so it can run on a background thread.
+    std::function<std::vector<FaustBenchmarkResult>()> CreateCompileProfilesBenchmark() const;
+
+    // Compile the current code and profile on a background thread, superseding any compile in progress.
+    // The current DSP keeps running until `Update` swaps in the result.
+    void StartCompile();
+    bool IsCompiling() const;
+    bool IsCompiled() const; // Returns true if a background compile finished, and is waiting to be swapped in by `Update`.
+    bool IsCompilePending() const; // Returns true if a code change is scheduled to compile, compiling, or waiting to be swapped in.
+
     FaustDSPContainer &Container;
     Prop(TextEditor, Editor, fs::path("./res") / "pitch_shifter.dsp");
+    Prop(FaustCompileProfile, CompileProfile);
 
     Box Box{nullptr};
     dsp *Dsp{nullptr};
     std::string ErrorMessage{""};
+    FaustCompileTimes CompileTimes{}; // Of the most recent compile.
+    FaustCompileScheduler CompileScheduler{};
 
 private:
+    friend struct FaustDSPs; // For reloading all DSPs when the Faust libraries change.
+    friend struct Faust; // For swapping in compiled code changes.
+
     void Render() const override;
 
-    void Init(TransientStore &);
+    // A replaced DSP (and its factory) is kept alive until no listener is using it.
+    struct RetiredDsp {
+        dsp *Dsp;
+        llvm_dsp_factory *DspFactory;
+    };
+
+    FaustCompileResult Compile() const;
+    // Returns the result of compiling the current code and profile: The background compile's result if there is one
+    // (waiting for it to finish if needed, e.g. when replaying actions), or else a compile on this thread.
+    // Returns `std::nullopt` if the background compile is for code or options that have since changed, in which case a newer compile is pending.
+    std::optional<FaustCompileResult> TakeCompileResult();
+
+    void Init(TransientStore &, float libraries_ms = 0);
+    void Init(TransientStore &, FaustCompileResult &&);
     void Uninit(TransientStore &);
-    void Update(TransientStore &); // Sets `Box`, `Dsp`, and `ErrorMessage` based on the current `Code`.
+    // Sets `Box`, `Dsp`, and `ErrorMessage` based on the current `Code` and `CompileProfile`, using the background compile's result if there is one.
+    // If there is a current DSP and the code compiles, the new DSP replaces it without removing it from listeners.
+    void Update(TransientStore &);
 
     void DestroyDsp();
+    void ReclaimRetiredDsps(bool force = false); // Delete retired DSPs no longer in use (or all of them, if `force` is true).
 
     llvm_dsp_factory *DspFactory{nullptr};
+    std::vector<RetiredDsp> RetiredDsps{};
+    std::unique_ptr<FaustCompileJob> CompileJob{};
+    // Compiles can't be interrupted, so superseded compiles are kept until they finish, and their results are discarded.
+    std::vector<std::unique_ptr<FaustCompileJob>> SupersededCompileJobs{};
 };
 
-struct FaustDSPs : ComponentVector<FaustDSP>, ActionProducer<FaustDspProducedActionType> {
+struct FaustDSPs : ComponentVector<FaustDSP>, ActionProducer<FaustDspProducedActionType>, TickListener {
     using ArgsT = ProducerComponentArgs<ProducedActionType>;
 
     FaustDSPs(ArgsT &&);
     ~FaustDSPs();
 
+    // Recreate the Faust library context (e.g. after a library file changed), and recompile all DSPs in it.
+    void ReloadLibraries(TransientStore &);
+
+    void OnTick() override; // Start scheduled compiles and swap in finished ones, whether or not any window is visible.
+    bool IsBusy() const override;
+
 private:
     void Render() const override;
 };
@@ -152,6 +228,8 @@ struct Faust
     }
 
     void NotifyListeners(TransientStore &, NotificationType, FaustDSP &) override;
+    bool IsDspInUse(const dsp *) const override;
+    u32 GetSampleRate() const override;
 
     inline static std::unordered_set<FaustDSPListener *> DspChangeListeners;
 
@@ -160,10 +238,13 @@ struct Faust
     Prop(FaustParamsStyle, ParamsStyle);
 
     ProducerProp_(FaustGraphs, Graphs, "Faust graphs", GraphStyle, GraphSettings);
-    Prop_(FaustParamss, Paramss, "Faust params", ParamsStyle);
+    ProducerProp_(FaustParamss, Paramss, "Faust params", ParamsStyle);
     Prop_(FaustLogs, Logs, "Faust logs");
     ProducerProp(FaustDSPs, FaustDsps);
 
+    void BenchmarkCompileProfiles(ID faust_dsp_id) const;
+    void Recompile(TransientStore &, ID faust_dsp_id) const;
+
 protected:
     void Render() const override;
 };
@@ -3,8 +3,9 @@
 #include "FaustDSPAction.h"
 #include "FaustGraphAction.h"
 #include "FaustGraphStyleAction.h"
+#include "FaustParamsAction.h"
 
 DefineActionType(
     Faust,
-    using Any = Combine<Faust::DSP::Any, Faust::Graph::Any, Faust::GraphStyle::Any>;
+    using Any = Combine<Faust::DSP::Any, Faust::Graph::Any, Faust::GraphStyle::Any, Faust::Params::Any>;
 );
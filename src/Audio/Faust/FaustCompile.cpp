@@ -0,0 +1,164 @@
+#include "FaustCompileProfile.h"
+
+#include <random>
+#include <unordered_map>
+
+#include "Core/Profiler.h"
+#include "FaustLibraries.h"
+
+#include "Audio/Sample.h" // Must be included before any Faust includes.
+#include "faust/dsp/llvm-dsp.h"
+
+std::vector<std::string> FaustCompileOptions::GetArgs() const {
+    std::vector<std::string> args;
+    if (std::is_same_v<Sample, double>) args.emplace_back("-double");
+    switch (Mode) {
+        case FaustCompileMode_Vector: args.emplace_back("-vec"); break;
+        case FaustCompileMode_OpenMP: args.emplace_back("-omp"); break;
+        case FaustCompileMode_Scheduler: args.emplace_back("-sch"); break;
+        default: break;
+    }
+    if (Mode != FaustCompileMode_Scalar) {
+        args.emplace_back("-vs");
+        args.emplace_back(std::to_string(VectorSize));
+    }
+    return args;
+}
+
+std::string FaustCompileOptions::GetLabel() const {
+    static const std::vector<std::string> ModeNames{"Scalar", "Vector", "OpenMP", "Scheduler"};
+    const auto &mode_name = ModeNames[Mode];
+    const auto optimize_label = OptimizeLevel < 0 ? "max" : std::to_string(OptimizeLevel);
+    if (Mode == FaustCompileMode_Scalar) return std::format("{} (opt {})", mode_name, optimize_label);
+    return std::format("{} {} (opt {})", mode_name, VectorSize, optimize_label);
+}
+
+static float MillisSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+namespace {
+// Keys hold the full code, so distinct code with colliding hashes never shares a compile.
+struct CompileCacheKey {
+    std::string Code;
+    FaustCompileOptions Options;
+
+    bool operator==(const CompileCacheKey &) const = default;
+};
+
+struct CompileCacheKeyHash {
+    size_t operator()(const CompileCacheKey &key) const {
+        size_t hash = std::hash<std::string>{}(key.Code);
+        for (const auto value : {size_t(key.Options.Mode), size_t(key.Options.VectorSize), size_t(key.Options.OptimizeLevel)}) {
+            hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+        }
+        return hash;
+    }
+};
+
+// A cached box is valid for the lifetime of its library context.
+// The factory is looked up by its libfaust SHA key, since it's deleted once all of its users release it.
+struct CompileCacheEntry {
+    unsigned int LibrariesGeneration;
+    Box Box;
+    std::string FactoryShaKey;
+};
+
+std::unordered_map<CompileCacheKey, CompileCacheEntry, CompileCacheKeyHash> CompileCache;
+constexpr size_t MaxCompileCacheSize = 256;
+} // namespace
+
+FaustCompileResult CompileFaust(const std::string &code, const FaustCompileOptions &options) {
+    ProfileZone("CompileFaust");
+    const auto args = options.GetArgs();
+    std::vector<const char *> argv = {"-I", FaustLibraries::GetPath().c_str()};
+    for (const auto &arg : args) argv.push_back(arg.c_str());
+    const int argc = argv.size();
+
+    const auto libraries_lock = FaustLibraries::Lock(); // Boxes may be traversed concurrently (e.g. when building a graph's node tree).
+    CompileCacheKey cache_key{code, options};
+    const CompileCacheEntry *cached = nullptr;
+    if (auto it = CompileCache.find(cache_key); it != CompileCache.end()) {
+        if (it->second.LibrariesGeneration == FaustLibraries::GetGeneration()) cached = &it->second;
+        else CompileCache.erase(it);
+    }
+
+    FaustCompileResult result;
+    static int num_inputs, num_outputs;
+    auto phase_start = std::chrono::steady_clock::now();
+    result.Box = cached ? cached->Box : DSPToBoxes("FlowGrid", code, argc, argv.data(), &num_inputs, &num_outputs, result.ErrorMessage);
+    result.Times.BoxesMs = MillisSince(phase_start);
+
+    if (result.Box && result.ErrorMessage.empty()) {
+        phase_start = std::chrono::steady_clock::now();
+        if (cached) result.DspFactory = getDSPFactoryFromSHAKey(cached->FactoryShaKey); // Adds a reference.
+        result.FromCache = result.DspFactory != nullptr;
+        if (!result.DspFactory) {
+            result.DspFactory = createDSPFactoryFromBoxes("FlowGrid", result.Box, argc, argv.data(), "", result.ErrorMessage, options.OptimizeLevel);
+        }
+        result.Times.FactoryMs = MillisSince(phase_start);
+        if (result.DspFactory) {
+            if (result.ErrorMessage.empty()) {
+                phase_start = std::chrono::steady_clock::now();
+                result.Dsp = result.DspFactory->createDSPInstance();
+                result.Times.InstanceMs = MillisSince(phase_start);
+                if (result.Dsp) {
+                    result.Dsp->instanceResetUserInterface(); // Param values are needed even if the instance is never `init`ed.
+                    if (CompileCache.size() >= MaxCompileCacheSize) CompileCache.clear();
+                    CompileCache[std::move(cache_key)] = {FaustLibraries::GetGeneration(), result.Box, result.DspFactory->getSHAKey()};
+                } else {
+                    result.ErrorMessage = "Successfully created Faust DSP factory, but could not create the Faust DSP instance.";
+                }
+            } else {
+                deleteDSPFactory(result.DspFactory);
+                result.DspFactory = nullptr;
+            }
+        }
+    } else if (!result.Box && result.ErrorMessage.empty()) {
+        result.ErrorMessage = "`DSPToBoxes` returned no error but did not produce a result.";
+    }
+    return result;
+}
+
+std::vector<FaustBenchmarkResult> BenchmarkFaustCompileOptions(
+    const std::string &code, const std::vector<FaustCompileOptions> &options_list, u32 sample_rate, u32 block_frames, u32 block_count
+) {
+    using std::chrono::steady_clock;
+
+    std::vector<FaustBenchmarkResult> results;
+    for (const auto &options : options_list) {
+        auto &result = results.emplace_back(FaustBenchmarkResult{.Options = options});
+        auto compiled = CompileFaust(code, options);
+        if (!compiled.Dsp) {
+            result.ErrorMessage = compiled.ErrorMessage;
+            if (compiled.DspFactory) deleteDSPFactory(compiled.DspFactory);
+            continue;
+        }
+        result.CompileMs = compiled.Times.TotalMs();
+
+        auto *dsp = compiled.Dsp;
+        dsp->init(sample_rate);
+
+        // Deterministic noise input, so all options compute the same signal.
+        const u32 in_channels = dsp->getNumInputs(), out_channels = dsp->getNumOutputs();
+        std::vector<std::vector<Sample>> inputs(in_channels, std::vector<Sample>(block_frames)), outputs(out_channels, std::vector<Sample>(block_frames));
+        std::minstd_rand rng{0};
+        std::uniform_real_distribution<Sample> noise{-1, 1};
+        for (auto &channel : inputs) std::ranges::generate(channel, [&] { return noise(rng); });
+        std::vector<Sample *> input_ptrs, output_ptrs;
+        for (auto &channel : inputs) input_ptrs.push_back(channel.data());
+        for (auto &channel : outputs) output_ptrs.push_back(channel.data());
+
+        const u32 warmup_block_count = std::max(block_count / 10, 1u);
+        for (u32 i = 0; i < warmup_block_count; i++) dsp->compute(block_frames, input_ptrs.data(), output_ptrs.data());
+
+        const auto compute_start = steady_clock::now();
+        for (u32 i = 0; i < block_count; i++) dsp->compute(block_frames, input_ptrs.data(), output_ptrs.data());
+        const auto compute_ns = std::chrono::duration<float, std::nano>(steady_clock::now() - compute_start).count();
+        result.ComputeNsPerBlock = compute_ns / float(std::max(block_count, 1u));
+
+        delete dsp;
+        deleteDSPFactory(compiled.DspFactory);
+    }
+    return results;
+}
@@ -0,0 +1,26 @@
+#include "FaustCompileProfile.h"
+
+#include "imgui.h"
+
+FaustCompileOptions FaustCompileProfile::Get() const { return {Mode, VectorSize, OptimizeLevel}; }
+
+std::vector<FaustCompileOptions> FaustCompileProfile::GetBenchmarkOptions() const {
+    std::vector<FaustCompileOptions> options_list;
+    for (const auto mode : {FaustCompileMode_Scalar, FaustCompileMode_Vector, FaustCompileMode_OpenMP, FaustCompileMode_Scheduler}) {
+        options_list.push_back({mode, VectorSize, OptimizeLevel});
+    }
+    return options_list;
+}
+
+using namespace ImGui;
+
+void FaustCompileProfile::Render() const {
+    SetNextItemWidth(GetFontSize() * 9);
+    Mode.Draw();
+    BeginDisabled(Mode == FaustCompileMode_Scalar);
+    SetNextItemWidth(GetFontSize() * 9);
+    VectorSize.Draw();
+    EndDisabled();
+    SetNextItemWidth(GetFontSize() * 9);
+    OptimizeLevel.Draw();
+}
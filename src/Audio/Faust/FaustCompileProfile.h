@@ -0,0 +1,99 @@
+#pragma once
+
+#include "Core/Primitive/Enum.h"
+#include "Core/Primitive/Int.h"
+#include "Core/Primitive/UInt.h"
+
+class CTreeBase;
+typedef CTreeBase *Box;
+
+class dsp;
+class llvm_dsp_factory;
+
+enum FaustCompileMode_ {
+    FaustCompileMode_Scalar,
+    FaustCompileMode_Vector, // `-vec`
+    FaustCompileMode_OpenMP, // `-omp` (implies `-vec`)
+    FaustCompileMode_Scheduler, // `-sch`, work-stealing scheduler (implies `-vec`)
+};
+using FaustCompileMode = int;
+
+// Plain compile options, usable without a component (e.g. in headless benchmarks).
+// Compiling (`FaustCompile.cpp`) doesn't depend on any components or UI, so it can be built into tests.
+struct FaustCompileOptions {
+    FaustCompileMode Mode{FaustCompileMode_Scalar};
+    u32 VectorSize{32}; // `-vs`. Only used in non-scalar modes.
+    int OptimizeLevel{-1}; // LLVM optimization level. -1 uses the highest available level.
+
+    bool operator==(const FaustCompileOptions &) const = default;
+
+    // Compiler arguments, in addition to library include paths.
+    std::vector<std::string> GetArgs() const;
+    std::string GetLabel() const;
+};
+
+// Wall-clock durations of each phase of a compile.
+// libfaust doesn't report its internal phases, so parsing & evaluation are timed together, as are signal compilation, code generation & JIT.
+struct FaustCompileTimes {
+    float LibrariesMs{0}; // Checking library files for changes, and reloading the library context if any changed.
+    float BoxesMs{0}; // Parsing the code and its imports, and evaluating it to a box (`DSPToBoxes`).
+    float FactoryMs{0}; // Compiling the box to signals, generating code, and JIT-compiling it (`createDSPFactoryFromBoxes`).
+    float InstanceMs{0}; // Creating the DSP instance.
+
+    float TotalMs() const { return LibrariesMs + BoxesMs + FactoryMs + InstanceMs; }
+};
+
+struct FaustCompileResult {
+    Box Box{nullptr};
+    llvm_dsp_factory *DspFactory{nullptr};
+    dsp *Dsp{nullptr};
+    std::string ErrorMessage{""};
+    FaustCompileTimes Times{};
+    bool FromCache{false}; // The box and factory were reused from an earlier compile of the same code and options.
+};
+
+// Compile Faust code to a box, DSP factory, and DSP instance, with param zones set to their defaults.
+// On success, all result pointers are set and `ErrorMessage` is empty.
+// The result's factory is owned by the caller, who must release it with `deleteDSPFactory`.
+// Successful compiles are cached by source and options (for the lifetime of the library context).
+// Compiling cached source shares the cached box and factory, only creating a new DSP instance (as long as the factory is still alive).
+FaustCompileResult CompileFaust(const std::string &code, const FaustCompileOptions &);
+
+// Headless A/B benchmark: Compiles the same code under each set of options, and measures the time to compute `block_count` blocks of
+// `block_frames` frames (of noise input) at `sample_rate`, after a warm-up pass.
+// The caller must hold a library context reference (`FaustLibraries::Acquire`) until the benchmark returns.
+struct FaustBenchmarkResult {
+    FaustCompileOptions Options;
+    std::string ErrorMessage{""}; // Nonempty if compilation failed, in which case the times are zero.
+    float CompileMs{0};
+    float ComputeNsPerBlock{0};
+};
+
+std::vector<FaustBenchmarkResult> BenchmarkFaustCompileOptions(
+    const std::string &code, const std::vector<FaustCompileOptions> &, u32 sample_rate, u32 block_frames = 512, u32 block_count = 1000
+);
+
+// The compile options for a single Faust DSP.
+struct FaustCompileProfile : Component {
+    using Component::Component;
+
+    FaustCompileOptions Get() const;
+
+    Prop_(
+        Enum, Mode,
+        "?Scalar: One sample at a time.\n"
+        "Vector: Loops over vectors of samples, which compilers can auto-vectorize.\n"
+        "OpenMP: Vector mode, with parallel loops using OpenMP.\n"
+        "Scheduler: Vector mode, with parallel loops using a work-stealing scheduler.",
+        {"Scalar", "Vector", "OpenMP", "Scheduler"},
+        FaustCompileMode_Scalar
+    );
+    Prop_(UInt, VectorSize, "?The vector size used in all non-scalar modes.", 32, 4, 1024);
+    Prop_(Int, OptimizeLevel, "?LLVM optimization level.\n-1 uses the highest available level.", -1, -1, 4);
+
+    // All modes at the current vector size and optimization level.
+    std::vector<FaustCompileOptions> GetBenchmarkOptions() const;
+
+protected:
+    void Render() const override;
+};
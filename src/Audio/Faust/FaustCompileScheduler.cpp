@@ -0,0 +1,39 @@
+#include "FaustCompileScheduler.h"
+
+#include <algorithm>
+#include <cmath>
+
+static constexpr float MinDelayMs = 100, MaxDelayMs = 1500;
+static constexpr float ParseWaitMs = 500; // Compile without the parse result if it hasn't arrived by then (e.g. the editor is hidden).
+static constexpr float SyntaxErrorIdleMs = 2000;
+static constexpr float CompileMsSmoothing = 0.3; // Weight of the latest compile time in the average.
+
+void FaustCompileScheduler::OnChanged(Clock::time_point now) {
+    ++Stats.ChangeCount;
+    LastChangeTime = now;
+    IsDeferred = false;
+}
+
+float FaustCompileScheduler::GetDelayMs() const { return std::clamp(AverageCompileMs, MinDelayMs, MaxDelayMs); }
+
+bool FaustCompileScheduler::Poll(std::optional<bool> has_syntax_errors, Clock::time_point now) {
+    if (!LastChangeTime) return false;
+
+    const float idle_ms = std::chrono::duration<float, std::milli>(now - *LastChangeTime).count();
+    const float delay_ms = GetDelayMs();
+    if (idle_ms < delay_ms) return false;
+    if (!has_syntax_errors && idle_ms < delay_ms + ParseWaitMs) return false;
+    if (has_syntax_errors.value_or(false) && idle_ms < delay_ms + SyntaxErrorIdleMs) {
+        if (!IsDeferred) ++Stats.SyntaxErrorDeferCount;
+        IsDeferred = true;
+        return false;
+    }
+
+    LastChangeTime.reset();
+    ++Stats.CompileCount;
+    return true;
+}
+
+void FaustCompileScheduler::OnCompiled(float compile_ms) {
+    AverageCompileMs = AverageCompileMs == 0 ? compile_ms : std::lerp(AverageCompileMs, compile_ms, CompileMsSmoothing);
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <chrono>
+#include <optional>
+
+using u32 = unsigned int;
+
+struct FaustCompileStats {
+    u32 ChangeCount{0}; // Code changes.
+    u32 CompileCount{0}; // Compiles run for code changes.
+    u32 SyntaxErrorDeferCount{0}; // Changes whose compile was held back since their code had syntax errors.
+
+    // Each compile covers at least one change, and the rest were coalesced or superseded.
+    u32 AvoidedCount() const { return ChangeCount - CompileCount; }
+};
+
+// Decides when to recompile a DSP after its code changes.
+// - Each change restarts a debounce delay, so a burst of edits (e.g. typing a word) is compiled once, after the burst.
+// - The delay follows recent compile times, so slower programs wait longer for typing to pause.
+// - Code with syntax errors is held back until it's left unchanged for a while,
+//   so compiles don't run on every keystroke of a half-typed expression, but libfaust's error message still shows up.
+struct FaustCompileScheduler {
+    using Clock = std::chrono::steady_clock;
+
+    void OnChanged(Clock::time_point now = Clock::now());
+    // Call once per frame. `has_syntax_errors` is `std::nullopt` while the latest code is being parsed.
+    // Returns true if the changed code should be compiled now.
+    bool Poll(std::optional<bool> has_syntax_errors, Clock::time_point now = Clock::now());
+    void OnCompiled(float compile_ms);
+
+    bool IsPending() const { return LastChangeTime.has_value(); }
+    float GetDelayMs() const;
+
+    FaustCompileStats Stats{};
+
+private:
+    std::optional<Clock::time_point> LastChangeTime{};
+    bool IsDeferred{false}; // Whether the pending change was held back for syntax errors.
+    float AverageCompileMs{0};
+};
@@ -6,9 +6,12 @@ DefineNestedActionType(
     Faust, DSP,
     DefineAction(Create, Saved, NoMerge, "");
     DefineAction(Delete, Saved, NoMerge, "", ID id;);
+    DefineAction(BenchmarkCompileProfiles, Unsaved, NoMerge, "", ID id;);
+    DefineAction(Recompile, Saved, NoMerge, "", ID id;);
 
     Json(Create);
     Json(Delete, id);
+    Json(Recompile, id);
 
-    using Any = ActionVariant<Create, Delete>;
+    using Any = ActionVariant<Create, Delete, BenchmarkCompileProfiles, Recompile>;
 );
@@ -1,6 +1,7 @@
 #pragma once
 
 using ID = unsigned int;
+using u32 = unsigned int;
 
 struct TransientStore;
 
@@ -9,4 +10,9 @@ struct FaustDSPListener {
     virtual void OnFaustDspChanged(TransientStore &, ID, dsp *) = 0;
     virtual void OnFaustDspAdded(TransientStore &, ID, dsp *) = 0;
     virtual void OnFaustDspRemoved(TransientStore &, ID) = 0;
+
+    // Returns true if the listener may still be using the DSP (e.g. on the audio thread), in which case it must not be deleted yet.
+    virtual bool IsFaustDspInUse(const dsp *) const = 0;
+    // The sample rate DSPs are computed at, or zero if unknown. Compiled DSPs are initialized at this rate off of the UI thread.
+    virtual u32 GetFaustSampleRate() const = 0;
 };
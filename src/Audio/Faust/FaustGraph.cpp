@@ -1,7 +1,11 @@
 #include "FaustGraph.h"
 
+#include <array>
+#include <atomic>
+#include <bit>
+#include <fstream>
 #include <ranges>
-#include <sstream>
+#include <thread>
 
 #include "faust/dsp/libfaust-box.h"
 #include "faust/dsp/libfaust-signal.h"
@@ -12,15 +16,62 @@
 #include "Core/Helper/Color.h"
 #include "Core/Helper/File.h"
 #include "Core/Helper/String.h"
-#include "Core/Helper/basen.h"
+#include "Core/Profiler.h"
 #include "Core/UI/InvisibleButton.h"
 
 #include "Audio/AudioIO.h"
 #include "FaustGraphStyle.h"
+#include "FaustLibraries.h"
 
 using std::min, std::max, std::pair;
 using std::ranges::to, std::views::take, std::views::take_while;
 
+namespace flowgrid {
+// A copy of the style values used to lay out and draw a node tree.
+// Style components read from the store, which is only safe on the UI thread, so each tree reads from a snapshot owned by
+// whoever owns the tree: The graph (refreshed on the UI thread whenever the style changes), or an SVG export job (taken on creation).
+struct GraphStyleValues {
+    explicit GraphStyleValues(const FaustGraphStyle &style)
+        : ScaleFillHeight(style.ScaleFillHeight), DetailMinHeight(style.DetailMinHeight), Direction(style.Direction),
+          RouteFrame(style.RouteFrame), SequentialConnectionZigzag(style.SequentialConnectionZigzag),
+          OrientationMark(style.OrientationMark), OrientationMarkRadius(style.OrientationMarkRadius),
+          DecorateRootNode(style.DecorateRootNode), DecorateMargin(style.DecorateMargin), DecoratePadding(style.DecoratePadding),
+          DecorateLineWidth(style.DecorateLineWidth), DecorateCornerRadius(style.DecorateCornerRadius),
+          GroupMargin(style.GroupMargin), GroupPadding(style.GroupPadding), GroupLineWidth(style.GroupLineWidth), GroupCornerRadius(style.GroupCornerRadius),
+          NodeMargin(style.NodeMargin), NodePadding(style.NodePadding), NodeMinSize(style.NodeMinSize),
+          BoxCornerRadius(style.BoxCornerRadius), BinaryHorizontalGapRatio(style.BinaryHorizontalGapRatio),
+          WireThickness(style.WireThickness), WireGap(style.WireGap), ArrowSize(style.ArrowSize), InverterRadius(style.InverterRadius) {
+        for (u32 i = 0; i < FlowGridGraphCol_COUNT; i++) Colors[i] = style.Colors[i];
+    }
+
+    bool ScaleFillHeight;
+    float DetailMinHeight;
+    int Direction;
+    bool RouteFrame, SequentialConnectionZigzag, OrientationMark;
+    float OrientationMarkRadius;
+    bool DecorateRootNode;
+    ImVec2 DecorateMargin, DecoratePadding;
+    float DecorateLineWidth, DecorateCornerRadius;
+    ImVec2 GroupMargin, GroupPadding;
+    float GroupLineWidth, GroupCornerRadius;
+    ImVec2 NodeMargin, NodePadding, NodeMinSize;
+    float BoxCornerRadius, BinaryHorizontalGapRatio, WireThickness, WireGap;
+    ImVec2 ArrowSize;
+    float InverterRadius;
+    std::array<u32, FlowGridGraphCol_COUNT> Colors;
+};
+
+// Passed down through node tree construction.
+// `FoldComplexity` is passed in rather than read from the graph style, since trees are built off of the UI thread.
+struct TreeContext {
+    const FaustGraph &Graph;
+    const GraphStyleValues &Style; // Must outlive the tree.
+    const u32 FoldComplexity;
+};
+} // namespace flowgrid
+
+using flowgrid::GraphStyleValues, flowgrid::TreeContext;
+
 namespace {
 constexpr string_view SvgFileExtension{".svg"};
 
@@ -33,13 +84,13 @@ enum GraphOrientation {
     GraphReverse
 };
 
-ImGuiDir GlobalDirection(const FaustGraphStyle &style, GraphOrientation orientation) {
+ImGuiDir GlobalDirection(const GraphStyleValues &style, GraphOrientation orientation) {
     auto dir = ImGuiDir(int(style.Direction));
     return (dir == ImGuiDir_Right && orientation == GraphForward) || (dir == ImGuiDir_Left && orientation == GraphReverse) ?
         ImGuiDir_Right :
         ImGuiDir_Left;
 }
-bool IsLr(const FaustGraphStyle &style, GraphOrientation orientation) {
+bool IsLr(const GraphStyleValues &style, GraphOrientation orientation) {
     return GlobalDirection(style, orientation) == ImGuiDir_Right;
 }
 
@@ -59,7 +110,8 @@ struct TextStyle {
 struct Device {
     static constexpr float RectLabelPaddingLeft = 3;
 
-    Device(const FaustGraph &context, ImVec2 position = {0, 0}) : Context(context), Style(Context.Style), Position(position) {}
+    Device(const GraphStyleValues &style, float scale, ImVec2 position = {0, 0})
+        : Style(style), ScaleFactor(scale), Position(position) {}
     virtual ~Device() = default;
 
     virtual DeviceType Type() = 0;
@@ -77,17 +129,20 @@ struct Device {
     virtual void Text(ImVec2 pos, string_view text, const TextStyle &) = 0;
     virtual void Dot(ImVec2 pos, u32 fill_color) = 0;
 
+    // Returns `false` if nothing drawn within the local rect can be seen, in which case drawing it can be skipped.
+    virtual bool IsVisible(const ImRect &) const { return true; }
+
     virtual void SetCursorPos(ImVec2 scaled_cursor_pos) { CursorPosition = scaled_cursor_pos; }
     void AdvanceCursor(ImVec2 unscaled_pos) { SetCursorPos(CursorPosition + Scale(unscaled_pos)); }
 
     ImVec2 At(ImVec2 local_pos) const { return Position + CursorPosition + Scale(local_pos); }
     ImRect At(const ImRect &local_rect) const { return {At(local_rect.Min), At(local_rect.Max)}; }
 
-    ImVec2 Scale(ImVec2 p) const { return p * Context.GetScale(); }
-    float Scale(const float f) const { return f * Context.GetScale(); }
+    ImVec2 Scale(ImVec2 p) const { return p * ScaleFactor; }
+    float Scale(const float f) const { return f * ScaleFactor; }
 
-    const FaustGraph &Context;
-    const FaustGraphStyle &Style;
+    const GraphStyleValues &Style;
+    const float ScaleFactor; // Captured at construction, since `FaustGraph::GetScale` reads from the current ImGui window.
 
     ImVec2 Position{}; // Absolute window position of device
     ImVec2 CursorPosition{}; // In local coordinates, relative to `Position`
@@ -95,51 +150,45 @@ struct Device {
 
 using namespace ImGui;
 
-// ImGui saves font name as "{Name}.{Ext}, {Size}px"
-string GetFontName() {
-    const string name = GetFont()->GetDebugName();
-    return name.substr(0, name.find_first_of('.'));
-}
-fs::path GetFontPath() {
-    const string name = GetFont()->GetDebugName();
-    return fs::path("./res") / "fonts" / name.substr(0, name.find_first_of(','));
-}
-string GetFontBase64() {
-    static std::unordered_map<string, string> base64_for_font_name; // avoid recomputing
-    const string font_name = GetFontName();
-    if (!base64_for_font_name.contains(font_name)) {
-        const string ttf_contents = FileIO::read(GetFontPath());
-        string ttf_base64;
-        bn::encode_b64(ttf_contents.begin(), ttf_contents.end(), back_inserter(ttf_base64));
-        base64_for_font_name[font_name] = ttf_base64;
-    }
-    return base64_for_font_name.at(font_name);
-}
+// Font info captured on the UI thread, so SVG files can be written from worker threads without touching the ImGui context.
+// (The font atlas is built once at startup, so reading glyph metrics from any thread is safe.)
+struct SvgFont {
+    SvgFont() : Font(GetFont()), Size(GetFontSize()) {
+        // ImGui saves font name as "{Name}.{Ext}, {Size}px"
+        const string name = Font->GetDebugName();
+        Name = name.substr(0, name.find_first_of('.'));
+        FileName = name.substr(0, name.find_first_of(','));
+    }
+
+    fs::path GetPath() const { return fs::path("./res") / "fonts" / FileName; }
+    ImVec2 CalcTextSize(string_view text) const { return Font->CalcTextSizeA(Size, FLT_MAX, 0, text.data(), text.data() + text.size()); }
+
+    const ImFont *Font;
+    float Size;
+    string Name, FileName;
+};
 
 // todo: Fix rendering SVG with `DecorateRootNode = false` (and generally get it back to its former self).
 struct SVGDevice : Device {
-    SVGDevice(const FaustGraph &context, fs::path Directory, string FileName, ImVec2 size)
-        : Device(context), Directory(std::move(Directory)), FileName(std::move(FileName)) {
+    SVGDevice(const GraphStyleValues &style, float scale, const SvgFont &font, const fs::path &path, ImVec2 size)
+        : Device(style, scale), Font(font), Stream(path) {
         const auto &[w, h] = Scale(size);
         Stream << std::format(R"(<svg xmlns="http://www.w3.org/2000/svg" viewBox="0 0 {} {}")", w, h);
         Stream << (Style.ScaleFillHeight ? R"( height="100%">)" : std::format(R"( width="{}" height="{}">)", w, h));
 
-        // Embed the current font as a base64-encoded string.
+        // Reference the font file copied once into the export directory, rather than embedding it in every file.
         Stream << std::format(R"(
         <defs><style>
             @font-face{{
                 font-family:"{}";
-                src:url(data:application/font-woff;charset=utf-8;base64,{}) std::format("woff");
+                src:url("{}") format("truetype");
                 font-weight:normal;font-style:normal;
             }}
         </style></defs>)",
-                              GetFontName(), GetFontBase64());
+                              Font.Name, Font.FileName);
     }
 
-    ~SVGDevice() override {
-        Stream << "</svg>\n";
-        FileIO::write(Directory / FileName, Stream.str());
-    }
+    ~SVGDevice() override { Stream << "</svg>\n"; }
 
     DeviceType Type() override { return DeviceType_SVG; }
 
@@ -162,7 +211,7 @@ struct SVGDevice : Device {
     }
     // Scale factor to convert between ImGui font pixel height and SVG `font-size` attr value.
     // Determined empirically to make the two renderings look the same.
-    float GetFontSize() const { return Scale(GetTextLineHeight()) * 0.8f; }
+    float GetFontSize() const { return Scale(Font.Size) * 0.8f; }
 
     void Rect(const ImRect &local_rect, const RectStyle &style) override {
         const auto &rect = At(local_rect);
@@ -186,7 +235,7 @@ struct SVGDevice : Device {
         const auto &tr = rect.GetTR();
         const float label_offset = Scale(max(8.f, rect_style.CornerRadius) + text_style.Padding.Left);
         const float text_x = tl.x + label_offset;
-        const ImVec2 text_right{min(text_x + CalcTextSize(label_view).x, tr.x), tr.y};
+        const ImVec2 text_right{min(text_x + Font.CalcTextSize(label_view).x, tr.x), tr.y};
         const float r = Scale(rect_style.CornerRadius);
         // Going counter-clockwise instead of clockwise, like in the ImGui implementation, since that's what paths expect for corner rounding to work.
         Stream << std::format(
@@ -199,7 +248,7 @@ struct SVGDevice : Device {
         );
         string label{label_view};
         XmlSanitize(label);
-        Stream << std::format(R"(<text x="{}" y="{}" font-family="{}" font-size="{}" fill="{}" dominant-baseline="middle">{}</text>)", text_x, tl.y, GetFontName(), GetFontSize(), RgbColor(text_style.Color), label);
+        Stream << std::format(R"(<text x="{}" y="{}" font-family="{}" font-size="{}" fill="{}" dominant-baseline="middle">{}</text>)", text_x, tl.y, Font.Name, GetFontSize(), RgbColor(text_style.Color), label);
     }
 
     void Triangle(ImVec2 p1, ImVec2 p2, ImVec2 p3, u32 color) override {
@@ -231,7 +280,7 @@ struct SVGDevice : Device {
         const auto &p = At(pos - ImVec2{style.Padding.Right, style.Padding.Bottom});
         string text{text_view};
         XmlSanitize(text);
-        Stream << std::format(R"(<text x="{}" y="{}" font-family="{}" font-style="{}" font-weight="{}" font-size="{}" text-anchor="{}" fill="{}" dominant-baseline="middle">{}</text>)", p.x, p.y, GetFontName(), font_formatted, weight, GetFontSize(), anchor, RgbColor(color), text);
+        Stream << std::format(R"(<text x="{}" y="{}" font-family="{}" font-style="{}" font-weight="{}" font-size="{}" text-anchor="{}" fill="{}" dominant-baseline="middle">{}</text>)", p.x, p.y, Font.Name, font_formatted, weight, GetFontSize(), anchor, RgbColor(color), text);
     }
 
     // Only SVG device has a text-with-link method
@@ -249,19 +298,24 @@ struct SVGDevice : Device {
         Stream << std::format(R"(<circle cx="{}" cy="{}" r="{}" fill="{}"/>)", p.x, p.y, radius, RgbColor(fill_color));
     }
 
-    fs::path Directory;
-    string FileName;
+    const SvgFont &Font;
 
 private:
-    std::stringstream Stream;
+    std::ofstream Stream; // Streamed straight to the file, rather than buffering the whole document in memory.
 };
 
 struct ImGuiDevice : Device {
     ImGuiDevice(const FaustGraph &context)
-        : Device(context, GetCursorScreenPos()), DC(GetCurrentWindow()->DC), DrawList(GetWindowDrawList()) {}
+        : Device(*context.StyleValues, context.GetScale(), GetCursorScreenPos()), DC(GetCurrentWindow()->DC), DrawList(GetWindowDrawList()),
+          // Expand the clip rect by a wire gap, to account for arrows and wire ends drawn slightly outside of node bounds.
+          VisibleRect(GetCurrentWindow()->ClipRect) {
+        VisibleRect.Expand(Scale(Style.WireGap));
+    }
 
     DeviceType Type() override { return DeviceType_ImGui; }
 
+    bool IsVisible(const ImRect &local_rect) const override { return VisibleRect.Overlaps(At(local_rect)); }
+
     void SetCursorPos(ImVec2 scaled_cursor_pos) override {
         Device::SetCursorPos(scaled_cursor_pos);
         DC.CursorPos = At({0, 0});
@@ -351,6 +405,7 @@ struct ImGuiDevice : Device {
 
     ImGuiWindowTempData &DC; // Safe to store directly, since the device is recreated each frame.
     ImDrawList *DrawList;
+    ImRect VisibleRect;
 };
 
 string GetTreeName(Tree tree) {
@@ -455,6 +510,17 @@ string GetBoxType(Box t) {
 } // namespace
 
 namespace flowgrid {
+// Box-derived data shared by all nodes created for the same box, across all occurrences of the box in the tree.
+// Faust boxes are hash-consed (structurally identical boxes are the same pointer), so these are keyed on the box pointer.
+struct BoxInfo {
+    BoxInfo(Box box, bool is_pure_routing)
+        : Id(UniqueId(box)), Name(GetTreeName(box)), TypeLabel(GetBoxType(box)), IsPureRouting(is_pure_routing) {}
+
+    const string Id, Name, TypeLabel;
+    // Pure routing trees are only made of cuts, wires, or slots.
+    const bool IsPureRouting;
+};
+
 // An abstract block graph node.
 struct Node {
     static constexpr u32
@@ -466,26 +532,46 @@ struct Node {
         TypeTextColor = Col32(255, 0, 0, 255);
 
     const FaustGraph &Context;
-    const FaustGraphStyle &Style;
+    const GraphStyleValues &Style;
     const Tree FaustTree;
-    const string Id, Text, BoxTypeLabel; // TODO can we get rid of `Id` now that we have `ImGuiId`?
+    const std::shared_ptr<const BoxInfo> Info;
+    const string Text;
     const u32 InCount, OutCount;
     const u32 Descendents = 0; // The number of boxes within this node (recursively).
     Node *A{}, *B{}; // Nodes have at most two children.
+    // Hash of everything the layout of this subtree depends on, other than the layout key.
+    // Node types with layout-affecting state beyond the base fields mix it in with `HashStructure`.
+    size_t StructureHash{0};
 
     u32 Index{0}; // Position in the parent's list of children.
-    ID ImGuiId;
+    ID ImGuiId{0};
 
     ImVec2 Size;
     ImVec2 Position; // Relative to parent.
     GraphOrientation Orientation = GraphForward;
 
-    Node(const FaustGraph &context, Tree tree, u32 in_count, u32 out_count, Node *a = nullptr, Node *b = nullptr, string_view text = "", bool is_block = false)
-        : Context(context), Style(context.Style), FaustTree(tree), Id(UniqueId(FaustTree)), Text(!text.empty() ? std::move(text) : GetTreeName(FaustTree)),
-          BoxTypeLabel(GetBoxType(FaustTree)), InCount(in_count), OutCount(out_count),
+    struct LayoutKey {
+        u32 Version;
+        DeviceType Device;
+        GraphOrientation Orientation;
+        float FontSize;
+
+        bool operator==(const LayoutKey &) const = default;
+    };
+    std::optional<LayoutKey> PlacedKey{};
+
+    Node(const TreeContext &context, Tree tree, u32 in_count, u32 out_count, Node *a = nullptr, Node *b = nullptr, string_view text = "", bool is_block = false)
+        : Context(context.Graph), Style(context.Style), FaustTree(tree), Info(context.Graph.GetBoxInfo(tree)), Text(!text.empty() ? string(text) : Info->Name),
+          InCount(in_count), OutCount(out_count),
           Descendents((is_block ? 1 : 0) + (a ? a->Descendents : 0) + (b ? b->Descendents : 0)), A(a), B(b) {
         if (A) A->Index = 0;
         if (B) B->Index = 1;
+        HashStructure(size_t(tree));
+        HashStructure(InCount);
+        HashStructure(OutCount);
+        HashStructure(std::hash<string>{}(Text));
+        if (A) HashStructure(A->StructureHash);
+        if (B) HashStructure(B->StructureHash);
         // cout << tree2str(tree) << '\n';
     }
 
@@ -496,7 +582,7 @@ struct Node {
     virtual void GenerateIds(ID parent_id) {
         ImGuiId = GenerateId(parent_id, Index);
         Context.NodeByImGuiId[ImGuiId] = this;
-        HelpInfo::ById.emplace(ImGuiId, HelpInfo{.Name = GetBoxType(FaustTree), .Help = ""});
+        HelpInfo::ById.emplace(ImGuiId, HelpInfo{.Name = Info->TypeLabel, .Help = ""});
         if (A) A->GenerateIds(ImGuiId);
         if (B) B->GenerateIds(ImGuiId);
     }
@@ -513,13 +599,51 @@ struct Node {
     // IO point relative to parent.
     ImVec2 ChildPoint(IO io, u32 channel) const { return Position + Point(io, channel); }
 
-    virtual void Place(const DeviceType) = 0;
+    // Layout is memoized per node, keyed on the graph's layout version (bumped on any style change),
+    // the device type, the orientation assigned by the parent, and the font size used for text measurement.
+    // The box tree itself is immutable for the lifetime of the node, so it doesn't need to be part of the key.
+    // Repeated subtrees (e.g. the voices of a `par` expansion) are only placed once per key.
+    // Every other occurrence copies the layout of the first one placed.
+    void Place(const DeviceType type) {
+        const LayoutKey key{Context.LayoutVersion, type, Orientation, GetFontSize()};
+        if (PlacedKey == key) return;
+
+        size_t layout_hash = StructureHash;
+        for (const size_t value : {size_t(key.Version), size_t(key.Device), size_t(key.Orientation), size_t(std::bit_cast<u32>(key.FontSize))}) {
+            layout_hash ^= value + 0x9e3779b9 + (layout_hash << 6) + (layout_hash >> 2);
+        }
+        auto &placed = Context.PlacedNodeByLayoutHash[layout_hash];
+        if (placed && placed != this && placed->StructureHash == StructureHash && placed->PlacedKey == key) {
+            CopyLayout(*placed);
+        } else {
+            PlaceInner(type);
+            placed = this;
+        }
+        PlacedKey = key;
+    }
+
+    // Copy the layout of an identically structured, already placed subtree.
+    // This node's own position and orientation are assigned by its parent.
+    virtual void CopyLayout(const Node &placed) {
+        Size = placed.Size;
+        PlacedKey = placed.PlacedKey;
+        for (auto [child, placed_child] : {std::pair{A, placed.A}, std::pair{B, placed.B}}) {
+            if (!child) continue;
+            child->Position = placed_child->Position;
+            child->Orientation = placed_child->Orientation;
+            child->CopyLayout(*placed_child);
+        }
+    }
 
     void Draw(Device &device) const {
         const bool is_imgui = device.Type() == DeviceType_ImGui;
         const auto before_cursor = device.CursorPosition;
         device.AdvanceCursor(Position);
 
+        // Children (and the wires between them) are contained within their parent's bounds,
+        // so the node tree doubles as a bounding volume hierarchy, and culling a node culls its entire subtree.
+        if (!device.IsVisible(*this)) return device.SetCursorPos(before_cursor);
+
         InteractionFlags flags = InteractionFlags_None;
         if (is_imgui) {
             PushOverrideID(ImGuiId);
@@ -531,9 +655,14 @@ struct Node {
             device.SetCursorPos(before_cursor_inner);
         }
 
-        Render(device, flags);
-        if (A) A->Draw(device);
-        if (B) B->Draw(device);
+        // Level of detail: Draw subtrees too small to be legible as a single labeled block.
+        if (is_imgui && A && device.Scale(H()) < Style.DetailMinHeight) {
+            DrawCollapsed(device);
+        } else {
+            Render(device, flags);
+            if (A) A->Draw(device);
+            if (B) B->Draw(device);
+        }
 
         if (flags & InteractionFlags_Hovered) {
             const auto &flags = Context.Settings.HoverFlags;
@@ -572,7 +701,7 @@ struct Node {
     }
     void DrawType(Device &device) const {
         static constexpr float padding = 2;
-        const auto label = std::format("{}: {}", BoxTypeLabel, Descendents);
+        const auto label = std::format("{}: {}", Info->TypeLabel, Descendents);
         device.Rect({{0, 0}, CalcTextSize(label) + padding * 2}, {.FillColor = TypeLabelBgColor});
         device.Text({padding, padding}, label, {.Color = TypeTextColor, .Justify = {HJustify_Left, VJustify_Top}});
     }
@@ -604,26 +733,41 @@ struct Node {
         }
     }
 
+    void DrawCollapsed(Device &device) const {
+        const auto &rect = GetFrameRect();
+        device.Rect(rect, {.FillColor = Style.Colors[FlowGridGraphCol_Normal], .CornerRadius = Style.BoxCornerRadius});
+        const auto &label = Text.empty() ? Info->TypeLabel : Text;
+        // `CalcTextSize` is already scaled by the window font scale.
+        const auto &label_size = CalcTextSize(label);
+        if (label_size.x <= device.Scale(rect.GetWidth()) && label_size.y <= device.Scale(rect.GetHeight())) {
+            device.Text(rect.GetCenter(), label, {.Color = Style.Colors[FlowGridGraphCol_Text]});
+        }
+    }
+
     // Get a unique, length-limited, alphanumeric file name.
     // If this is not the (singular) process node, append its tree's hex address (without the '0x' prefix) to make the file name unique.
     string SvgFileName() const {
         if (!FaustTree) return "";
 
-        const string tree_name = GetTreeName(FaustTree);
+        const string &tree_name = Info->Name;
         if (tree_name == "process") return std::format("{}{}", tree_name, SvgFileExtension);
 
         const auto name_limited = take_while(tree_name, [](char c) { return std::isalnum(c); }) | take(16) | to<string>();
-        return std::format("{}-{}{}", name_limited, Id, SvgFileExtension);
+        return std::format("{}-{}{}", name_limited, Info->Id, SvgFileExtension);
     }
 
-    void WriteSvg(const fs::path &path) const {
-        SVGDevice device(Context, path, SvgFileName(), Size);
+    // Assumes the node has already been placed for `DeviceType_SVG`.
+    void WriteSvg(const fs::path &dir_path, float scale, const SvgFont &font) const {
+        SVGDevice device(Style, scale, font, dir_path / SvgFileName(), Size);
         // todo this should be done in both cases
         device.Rect(*this, {.FillColor = Style.Colors[FlowGridGraphCol_Bg], .StrokeColor = Style.Colors[FlowGridGraphCol_Line]});
         Draw(device);
     }
 
 protected:
+    void HashStructure(size_t value) { StructureHash ^= value + 0x9e3779b9 + (StructureHash << 6) + (StructureHash >> 2); }
+
+    virtual void PlaceInner(const DeviceType) = 0;
     virtual void Render(Device &, InteractionFlags flags = InteractionFlags_None) const = 0;
 
     ImRect GetFrameRect() const { return {Margin(), Size - Margin()}; }
@@ -646,9 +790,12 @@ using Node = flowgrid::Node;
 
 // A simple rectangular box with text and inputs/outputs.
 struct BlockNode : Node {
-    BlockNode(const FaustGraph &context, Tree tree, u32 in_count, u32 out_count, string_view text, FlowGridGraphCol color = FlowGridGraphCol_Normal, Node *inner = nullptr)
+    BlockNode(const TreeContext &context, Tree tree, u32 in_count, u32 out_count, string_view text, FlowGridGraphCol color = FlowGridGraphCol_Normal, Node *inner = nullptr)
         : Node(context, tree, in_count, out_count, nullptr, nullptr, text, true), Color(color), Inner(inner) {
-        if (Inner) Inner->Index = 0;
+        if (Inner) {
+            Inner->Index = 0;
+            HashStructure(Inner->StructureHash);
+        }
     }
 
     void GenerateIds(ID parent_id) override {
@@ -656,12 +803,21 @@ struct BlockNode : Node {
         if (Inner) Inner->GenerateIds(ImGuiId);
     }
 
-    void Place(const DeviceType type) override {
+    void CopyLayout(const Node &placed) override {
+        Node::CopyLayout(placed);
+        if (Inner) {
+            const auto *placed_inner = static_cast<const BlockNode &>(placed).Inner;
+            Inner->Orientation = placed_inner->Orientation;
+            Inner->CopyLayout(*placed_inner);
+        }
+    }
+
+    void PlaceInner(const DeviceType type) override {
         const auto text_size = CalcTextSize(Text);
         Size = Margin() * 2 +
             ImVec2{
-                max(float(Style.NodeMinSize.X), text_size.x + Padding().x * 2),
-                max(float(Style.NodeMinSize.Y), max(text_size.y, float(max(InCount, OutCount)) * WireGap())),
+                max(float(Style.NodeMinSize.x), text_size.x + Padding().x * 2),
+                max(float(Style.NodeMinSize.y), max(text_size.y, float(max(InCount, OutCount)) * WireGap())),
             };
         if (Inner && type == DeviceType_SVG) Inner->Place(type);
     }
@@ -675,8 +831,8 @@ struct BlockNode : Node {
         device.AdvanceCursor(local_rect.Min); // todo this pattern should be RIAA style
 
         if (device.Type() == DeviceType_SVG) {
+            // The inner node is written to its own file by the export job. Link to it.
             auto &svg_device = static_cast<SVGDevice &>(device);
-            if (Inner && !fs::exists(svg_device.Directory / Inner->SvgFileName())) Inner->WriteSvg(svg_device.Directory);
             const string link = Inner ? SvgFileName() : "";
             svg_device.Rect({{0, 0}, size}, {.FillColor = fill_color, .CornerRadius = Style.BoxCornerRadius}, link);
             svg_device.Text(size / 2, Text, {.Color = text_color}, link);
@@ -696,7 +852,7 @@ struct BlockNode : Node {
 
         for (IO io : IO_All) {
             const bool in = io == IO_In;
-            const float arrow_width = in ? Style.ArrowSize.X : 0.f;
+            const float arrow_width = in ? Style.ArrowSize.x : 0.f;
             for (u32 channel = 0; channel < IoCount(io); channel++) {
                 const auto &channel_point = Point(io, channel);
                 const auto &b = channel_point + ImVec2{(XMargin() - arrow_width) * DirUnit(io), 0};
@@ -712,10 +868,10 @@ struct BlockNode : Node {
 
 // Simple cables (identity box) in parallel.
 struct CableNode : Node {
-    CableNode(const FaustGraph &context, Tree tree, u32 n = 1) : Node(context, tree, n, n) {}
+    CableNode(const TreeContext &context, Tree tree, u32 n = 1) : Node(context, tree, n, n) {}
 
     // The width of a cable is null, so its input and output connection points are the same.
-    void Place(const DeviceType) override { Size = {0, float(InCount) * WireGap()}; }
+    void PlaceInner(const DeviceType) override { Size = {0, float(InCount) * WireGap()}; }
     void Render(Device &, InteractionFlags) const override {}
 
     // Cable points are vertically spaced by `WireGap`.
@@ -728,9 +884,9 @@ struct CableNode : Node {
 // An inverter is a circle followed by a triangle.
 // It corresponds to '*(-1)', and it's used to create more compact graphs.
 struct InverterNode : BlockNode {
-    InverterNode(const FaustGraph &context, Tree tree) : BlockNode(context, tree, 1, 1, "-1", FlowGridGraphCol_Inverter) {}
+    InverterNode(const TreeContext &context, Tree tree) : BlockNode(context, tree, 1, 1, "-1", FlowGridGraphCol_Inverter) {}
 
-    void Place(const DeviceType) override { Size = ImVec2{2.5f, 1} * WireGap(); }
+    void PlaceInner(const DeviceType) override { Size = ImVec2{2.5f, 1} * WireGap(); }
 
     void Render(Device &device, InteractionFlags) const override {
         const float radius = Style.InverterRadius;
@@ -747,10 +903,10 @@ struct InverterNode : BlockNode {
 struct CutNode : Node {
     // A Cut is represented by a small black dot.
     // It has 1 input and no output.
-    CutNode(const FaustGraph &context, Tree tree) : Node(context, tree, 1, 0) {}
+    CutNode(const TreeContext &context, Tree tree) : Node(context, tree, 1, 0) {}
 
     // 0 width and 1 height, for the wire.
-    void Place(const DeviceType) override { Size = {0, 1}; }
+    void PlaceInner(const DeviceType) override { Size = {0, 1}; }
 
     // A cut is represented by a small black dot.
     void Render(Device &, InteractionFlags) const override {
@@ -775,14 +931,14 @@ enum BinaryNodeType {
 };
 
 struct BinaryNode : Node {
-    BinaryNode(const FaustGraph &context, Tree tree, Node *a, Node *b, BinaryNodeType type)
+    BinaryNode(const TreeContext &context, Tree tree, Node *a, Node *b, BinaryNodeType type)
         : Node(
               context, tree,
               type == ParallelNode ? a->InCount + b->InCount : (type == RecursiveNode ? a->InCount - b->OutCount : a->InCount),
               type == ParallelNode ? a->OutCount + b->OutCount : (type == RecursiveNode ? a->OutCount : b->OutCount),
               a, b
           ),
-          Type(type) {}
+          Type(type) { HashStructure(Type); }
 
     ImVec2 Point(IO io, u32 i) const override {
         if (Type == ParallelNode) {
@@ -799,7 +955,7 @@ struct BinaryNode : Node {
     }
 
     // Place the two components horizontally, centered, with enough space for the connections.
-    void Place(const DeviceType device_type) override {
+    void PlaceInner(const DeviceType device_type) override {
         if (Type == ParallelNode || Type == RecursiveNode) {
             // For parallel, A is top and B is bottom. For recursive, this is reversed.
             // In both cases, flip the order if this node is oriented in reverse.
@@ -951,7 +1107,7 @@ struct BinaryNode : Node {
     BinaryNodeType Type;
 };
 
-Node *MakeSequential(const FaustGraph &context, Tree tree, Node *a, Node *b) {
+Node *MakeSequential(const TreeContext &context, Tree tree, Node *a, Node *b) {
     const u32 o = a->OutCount, i = b->InCount;
     return new BinaryNode(
         context, tree,
@@ -997,20 +1153,15 @@ and additional half-text-height Y-offset to center top border line with label.
     * To: My right
 */
 struct GroupNode : Node {
-    GroupNode(const FaustGraph &context, NodeType type, Tree tree, Node *inner, string_view text = "")
-        : Node(context, tree, inner->InCount, inner->OutCount, inner, nullptr, text), Type(type) {}
+    GroupNode(const TreeContext &context, NodeType type, Tree tree, Node *inner, string_view text = "")
+        : Node(context, tree, inner->InCount, inner->OutCount, inner, nullptr, text), Type(type) { HashStructure(Type); }
     ~GroupNode() override = default;
 
-    void Place(const DeviceType type) override {
+    void PlaceInner(const DeviceType type) override {
+        A->Orientation = Orientation; // Set before placing, since orientation is part of the child's layout key.
         A->Place(type);
         Size = A->Size + (Margin() + Padding()) * 2 + ImVec2{LineWidth() * 2, LineWidth() * 2 + GetFontSize()};
-
-        if (!ShouldDecorate()) {
-            A->Orientation = Orientation;
-        } else {
-            A->Position = Margin() + Padding() + ImVec2{LineWidth(), LineWidth() + GetFontSize() / 2};
-            A->Orientation = Orientation;
-        }
+        if (ShouldDecorate()) A->Position = Margin() + Padding() + ImVec2{LineWidth(), LineWidth() + GetFontSize() / 2};
     }
 
     void Render(Device &device, InteractionFlags) const override {
@@ -1030,7 +1181,7 @@ struct GroupNode : Node {
         for (IO io : IO_All) {
             const bool in = io == IO_In;
             const bool has_arrow = Type == NodeType_Decorate && !in;
-            const float arrow_width = has_arrow ? Style.ArrowSize.X : 0.f;
+            const float arrow_width = has_arrow ? Style.ArrowSize.x : 0.f;
             for (u32 channel = 0; channel < IoCount(io); channel++) {
                 const auto &channel_point = A->ChildPoint(io, channel);
                 const ImVec2 a{in ? 0 : (Size - offset).x, channel_point.y};
@@ -1056,12 +1207,12 @@ private:
 struct RouteNode : Node {
     static constexpr u32 RouteFrameBgColor = Col32(237, 237, 166, 255);
 
-    RouteNode(const FaustGraph &context, Tree tree, u32 in_count, u32 out_count, std::vector<int> routes)
+    RouteNode(const TreeContext &context, Tree tree, u32 in_count, u32 out_count, std::vector<int> routes)
         : Node(context, tree, in_count, out_count), Routes(std::move(routes)) {}
 
-    void Place(const DeviceType) override {
-        const float h = 2 * YMargin() + max(float(Style.NodeMinSize.Y), float(max(InCount, OutCount)) * WireGap());
-        Size = {2 * XMargin() + max(float(Style.NodeMinSize.X), h * 0.75f), h};
+    void PlaceInner(const DeviceType) override {
+        const float h = 2 * YMargin() + max(float(Style.NodeMinSize.y), float(max(InCount, OutCount)) * WireGap());
+        Size = {2 * XMargin() + max(float(Style.NodeMinSize.x), h * 0.75f), h};
     }
 
     void Render(Device &device, InteractionFlags) const override {
@@ -1111,7 +1262,7 @@ string GetUiDescription(Box box) {
 }
 
 // Generate a 1->0 block node for an input slot.
-Node *MakeInputSlot(const FaustGraph &context, Tree tree) { return new BlockNode(context, tree, 1, 0, "", FlowGridGraphCol_Slot); }
+Node *MakeInputSlot(const TreeContext &context, Tree tree) { return new BlockNode(context, tree, 1, 0, "", FlowGridGraphCol_Slot); }
 
 // Collect the leaf numbers `tree` into `v`.
 // Return `true` if `tree` is a number or a parallel tree of numbers.
@@ -1133,71 +1284,192 @@ bool isBoxInts(Box box, std::vector<int> &v) {
 
     throw std::runtime_error("Not a valid list of numbers : " + PrintTree(box));
 }
+} // namespace
 
-// Track trees only made of cut, wires, or slots ("pure routing" trees).
-std::unordered_map<Tree, bool> IsTreePureRouting{};
-bool IsPureRouting(Tree t) {
-    if (IsTreePureRouting.contains(t)) return IsTreePureRouting[t];
+namespace flowgrid {
+// Writes an SVG file for the root node and for each folded sub-diagram, in parallel on worker threads.
+// The node tree, layout, and font measurement happen on the constructing (UI) thread, since they read from the ImGui context.
+// The tree is drawn with the job's own copy of the style values, so the workers never read the style while it may be changing.
+struct SvgExportJob {
+    SvgExportJob(const FaustGraph &graph, Box box, u32 fold_complexity, const FaustGraphStyle &style, fs::path dir_path, float scale)
+        : Style(style), DirPath(std::move(dir_path)), Scale(scale) {
+        {
+            const auto libraries_lock = FaustLibraries::Lock();
+            const TreeContext context{graph, Style, fold_complexity};
+            Root = std::make_unique<GroupNode>(context, NodeType_Decorate, box, graph.Tree2NodeInner(box, context));
+        }
+        Root->Place(DeviceType_SVG);
+        std::erase_if(graph.PlacedNodeByLayoutHash, [](const auto &entry) { return entry.second->PlacedKey->Device == DeviceType_SVG; });
+        FileNodes.emplace_back(Root.get());
+        std::unordered_set<string> file_names{Root->SvgFileName()};
+        CollectFileNodes(*Root, file_names);
+        fs::copy_file(Font.GetPath(), DirPath / Font.FileName, fs::copy_options::overwrite_existing);
+
+        const u32 worker_count = std::clamp(std::thread::hardware_concurrency(), 1u, u32(FileNodes.size()));
+        ActiveWorkerCount = worker_count;
+        for (u32 i = 0; i < worker_count; i++) Workers.emplace_back([this] { Work(); });
+    }
+    ~SvgExportJob() { Cancel(); } // Workers are joined on destruction.
 
-    Tree x, y;
-    const bool is_pure_routing = isBoxCut(t) || isBoxWire(t) || isBoxInverter(t) || isBoxSlot(t) || (isBoxBinary(t, x, y) && IsPureRouting(x) && IsPureRouting(y));
-    IsTreePureRouting.emplace(t, is_pure_routing);
-    return is_pure_routing;
+    void Cancel() { Cancelled = true; }
+    bool IsDone() const { return ActiveWorkerCount == 0; }
+    u32 GetWrittenCount() const { return WrittenCount; }
+    u32 GetFileCount() const { return FileNodes.size(); }
+
+private:
+    // Folded blocks link to their inner node's file, so each inner node needs its own file.
+    // Boxes are hash-consed, so blocks with the same box share a file name, and only need to be written once.
+    void CollectFileNodes(const Node &node, std::unordered_set<string> &file_names) {
+        if (const auto *block = dynamic_cast<const BlockNode *>(&node); block && block->Inner) {
+            if (file_names.insert(block->Inner->SvgFileName()).second) {
+                FileNodes.emplace_back(block->Inner);
+                CollectFileNodes(*block->Inner, file_names);
+            }
+        }
+        if (node.A) CollectFileNodes(*node.A, file_names);
+        if (node.B) CollectFileNodes(*node.B, file_names);
+    }
+
+    void Work() {
+        ProfileThread("Faust SVG export");
+        ProfileZone("Export SVGs");
+        for (u32 i = NextIndex++; i < FileNodes.size() && !Cancelled; i = NextIndex++) {
+            FileNodes[i]->WriteSvg(DirPath, Scale, Font);
+            WrittenCount++;
+        }
+        ActiveWorkerCount--;
+    }
+
+    const GraphStyleValues Style; // Declared before the tree, which references it.
+    std::unique_ptr<Node> Root;
+    const fs::path DirPath;
+    const float Scale;
+    const SvgFont Font{};
+    std::vector<const Node *> FileNodes{};
+
+    std::atomic<u32> NextIndex{0}, WrittenCount{0}, ActiveWorkerCount{0};
+    std::atomic<bool> Cancelled{false};
+    std::vector<std::jthread> Workers{}; // Declared last, so workers are joined before anything they use is destroyed.
+};
+
+// Builds the node tree for a box on a worker thread.
+// Traversing the box reads (and caches properties on) libfaust's shared trees, so the worker holds the Faust libraries lock
+// for the duration of the build, and never runs concurrently with a compile.
+// Only the node tree is built here. Generating ImGui IDs and updating the navigation history happen when the UI thread adopts it.
+// The job snapshots the style on creation, and the tree is built against the snapshot, never the live style.
+// The graph takes ownership of the snapshot along with the tree it's bound to.
+struct NodeTreeBuildJob {
+    NodeTreeBuildJob(const FaustGraph &graph, Box box, const FaustGraphStyle &style)
+        : Style(std::make_unique<GraphStyleValues>(style)), FoldComplexity(style.FoldComplexity),
+          LibrariesGeneration(FaustLibraries::GetGeneration()), Worker([this, &graph, box] { Build(graph, box); }) {}
+    ~NodeTreeBuildJob() = default; // The worker is joined on destruction.
+
+    void Cancel() { Cancelled = true; } // Only takes effect if the build hasn't started.
+    bool IsDone() const { return Done; }
+
+    // Only accessed by the UI thread once done.
+    std::unique_ptr<GraphStyleValues> Style; // Must outlive `Root`.
+    std::unique_ptr<Node> Root{}; // Null if the box couldn't be converted.
+
+private:
+    void Build(const FaustGraph &graph, Box box) {
+        ProfileThread("Faust graph build");
+        ProfileZone("Build node tree");
+        {
+            const auto lock = FaustLibraries::Lock();
+            // The box was freed if the library context was destroyed or reloaded while waiting for the lock.
+            if (!Cancelled && FaustLibraries::GetGeneration() == LibrariesGeneration) {
+                try {
+                    const TreeContext context{graph, *Style, FoldComplexity};
+                    Root = std::make_unique<GroupNode>(context, NodeType_Decorate, box, graph.Tree2NodeInner(box, context));
+                } catch (const std::exception &) {
+                    // Unrecognized box expression. Leave the tree empty.
+                }
+            }
+        }
+        Done = true;
+    }
+
+    const u32 FoldComplexity;
+    const unsigned int LibrariesGeneration;
+    std::atomic<bool> Cancelled{false}, Done{false};
+    std::jthread Worker; // Declared last, so it's started after everything it uses is initialized.
+};
+} // namespace flowgrid
+
+std::shared_ptr<const flowgrid::BoxInfo> FaustGraph::GetBoxInfo(Box box) const {
+    {
+        const std::lock_guard lock{BoxInfoMutex};
+        if (auto it = BoxInfoByBox.find(box); it != BoxInfoByBox.end()) return it->second;
+    }
+
+    Box x, y;
+    const bool is_pure_routing = isBoxCut(box) || isBoxWire(box) || isBoxInverter(box) || isBoxSlot(box) ||
+        (isBoxBinary(box, x, y) && GetBoxInfo(x)->IsPureRouting && GetBoxInfo(y)->IsPureRouting);
+    auto info = std::make_shared<const flowgrid::BoxInfo>(box, is_pure_routing);
+    const std::lock_guard lock{BoxInfoMutex};
+    return BoxInfoByBox.try_emplace(box, std::move(info)).first->second;
+}
+
+void FaustGraph::EraseUnusedBoxInfo() const {
+    // Keep box info for boxes still referenced by live nodes (in this tree, an in-progress build, or an in-progress SVG export),
+    // so the next tree built from an edited program reuses the info for all of its unchanged sub-expressions.
+    const std::lock_guard lock{BoxInfoMutex};
+    std::erase_if(BoxInfoByBox, [](const auto &entry) { return entry.second.use_count() == 1; });
 }
-} // namespace
 
 // Generate the inside node of a block graph according to its type.
-Node *FaustGraph::Tree2NodeInner(Tree t) const {
-    if (getUserData(t) != nullptr) return new BlockNode(*this, t, xtendedArity(t), 1, xtendedName(t));
-    if (isBoxInverter(t)) return new InverterNode(*this, t);
-    if (isBoxButton(t) || isBoxCheckbox(t) || isBoxVSlider(t) || isBoxHSlider(t) || isBoxNumEntry(t)) return new BlockNode(*this, t, 0, 1, GetUiDescription(t), FlowGridGraphCol_Ui);
-    if (isBoxVBargraph(t) || isBoxHBargraph(t)) return new BlockNode(*this, t, 1, 1, GetUiDescription(t), FlowGridGraphCol_Ui);
-    if (isBoxWaveform(t)) return new BlockNode(*this, t, 0, 2, "waveform{...}");
-    if (isBoxWire(t)) return new CableNode(*this, t);
-    if (isBoxCut(t)) return new CutNode(*this, t);
-    if (isBoxEnvironment(t)) return new BlockNode(*this, t, 0, 0, "environment{...}");
-    if (const auto count_and_name = GetBoxPrimCountAndName(t)) return new BlockNode(*this, t, (*count_and_name).first, 1, (*count_and_name).second);
+Node *FaustGraph::Tree2NodeInner(Tree t, const TreeContext &context) const {
+    if (getUserData(t) != nullptr) return new BlockNode(context, t, xtendedArity(t), 1, xtendedName(t));
+    if (isBoxInverter(t)) return new InverterNode(context, t);
+    if (isBoxButton(t) || isBoxCheckbox(t) || isBoxVSlider(t) || isBoxHSlider(t) || isBoxNumEntry(t)) return new BlockNode(context, t, 0, 1, GetUiDescription(t), FlowGridGraphCol_Ui);
+    if (isBoxVBargraph(t) || isBoxHBargraph(t)) return new BlockNode(context, t, 1, 1, GetUiDescription(t), FlowGridGraphCol_Ui);
+    if (isBoxWaveform(t)) return new BlockNode(context, t, 0, 2, "waveform{...}");
+    if (isBoxWire(t)) return new CableNode(context, t);
+    if (isBoxCut(t)) return new CutNode(context, t);
+    if (isBoxEnvironment(t)) return new BlockNode(context, t, 0, 0, "environment{...}");
+    if (const auto count_and_name = GetBoxPrimCountAndName(t)) return new BlockNode(context, t, (*count_and_name).first, 1, (*count_and_name).second);
 
     Tree a, b;
-    if (isBoxMetadata(t, a, b)) return Tree2Node(a);
-    if (isBoxSeq(t, a, b)) return MakeSequential(*this, t, Tree2Node(a), Tree2Node(b));
-    if (isBoxPar(t, a, b)) return new BinaryNode(*this, t, Tree2Node(a), Tree2Node(b), ParallelNode);
-    if (isBoxSplit(t, a, b)) return new BinaryNode(*this, t, Tree2Node(a), Tree2Node(b), SplitNode);
-    if (isBoxMerge(t, a, b)) return new BinaryNode(*this, t, Tree2Node(a), Tree2Node(b), MergeNode);
-    if (isBoxRec(t, a, b)) return new BinaryNode(*this, t, Tree2Node(a), Tree2Node(b), RecursiveNode);
+    if (isBoxMetadata(t, a, b)) return Tree2Node(a, context);
+    if (isBoxSeq(t, a, b)) return MakeSequential(context, t, Tree2Node(a, context), Tree2Node(b, context));
+    if (isBoxPar(t, a, b)) return new BinaryNode(context, t, Tree2Node(a, context), Tree2Node(b, context), ParallelNode);
+    if (isBoxSplit(t, a, b)) return new BinaryNode(context, t, Tree2Node(a, context), Tree2Node(b, context), SplitNode);
+    if (isBoxMerge(t, a, b)) return new BinaryNode(context, t, Tree2Node(a, context), Tree2Node(b, context), MergeNode);
+    if (isBoxRec(t, a, b)) return new BinaryNode(context, t, Tree2Node(a, context), Tree2Node(b, context), RecursiveNode);
     if (isBoxSymbolic(t, a, b)) {
         // Generate an abstraction node by placing the input slots and body in sequence.
-        auto *input_slots = MakeInputSlot(*this, a);
+        auto *input_slots = MakeInputSlot(context, a);
         Tree _a, _b;
         while (isBoxSymbolic(b, _a, _b)) {
-            input_slots = new BinaryNode(*this, b, input_slots, MakeInputSlot(*this, _a), ParallelNode);
+            input_slots = new BinaryNode(context, b, input_slots, MakeInputSlot(context, _a), ParallelNode);
             b = _b;
         }
-        auto *abstraction = MakeSequential(*this, b, input_slots, Tree2Node(b));
-        return !GetTreeName(t).empty() ? abstraction : new GroupNode(*this, NodeType_Group, t, abstraction, "Abstraction");
+        auto *abstraction = MakeSequential(context, b, input_slots, Tree2Node(b, context));
+        return !GetBoxInfo(t)->Name.empty() ? abstraction : new GroupNode(context, NodeType_Group, t, abstraction, "Abstraction");
     }
 
     int i;
-    if (double r; isBoxInt(t, &i) || isBoxReal(t, &r)) return new BlockNode(*this, t, 0, 1, isBoxInt(t) ? std::to_string(i) : std::to_string(r), FlowGridGraphCol_Number);
-    if (isBoxSlot(t, &i)) return new BlockNode(*this, t, 0, 1, "", FlowGridGraphCol_Slot);
+    if (double r; isBoxInt(t, &i) || isBoxReal(t, &r)) return new BlockNode(context, t, 0, 1, isBoxInt(t) ? std::to_string(i) : std::to_string(r), FlowGridGraphCol_Number);
+    if (isBoxSlot(t, &i)) return new BlockNode(context, t, 0, 1, "", FlowGridGraphCol_Slot);
 
-    if (Tree ff; isBoxFFun(t, ff)) return new BlockNode(*this, t, ffarity(ff), 1, ffname(ff));
-    if (Tree type, name, file; isBoxFConst(t, type, name, file) || isBoxFVar(t, type, name, file)) return new BlockNode(*this, t, 0, 1, tree2str(name));
+    if (Tree ff; isBoxFFun(t, ff)) return new BlockNode(context, t, ffarity(ff), 1, ffname(ff));
+    if (Tree type, name, file; isBoxFConst(t, type, name, file) || isBoxFVar(t, type, name, file)) return new BlockNode(context, t, 0, 1, tree2str(name));
 
     Tree label, chan;
-    if (isBoxSoundfile(t, label, chan)) return new BlockNode(*this, t, 2, 2 + tree2int(chan), GetUiDescription(t), FlowGridGraphCol_Ui);
+    if (isBoxSoundfile(t, label, chan)) return new BlockNode(context, t, 2, 2 + tree2int(chan), GetUiDescription(t), FlowGridGraphCol_Ui);
 
     const bool is_vgroup = isBoxVGroup(t, label, a), is_hgroup = isBoxHGroup(t, label, a), is_tgroup = isBoxTGroup(t, label, a);
     if (is_vgroup || is_hgroup || is_tgroup) {
         const char prefix = is_vgroup ? 'v' : (is_hgroup ? 'h' : 't');
-        return new GroupNode(*this, NodeType_Group, t, Tree2Node(a), std::format("{}group({})", prefix, extractName(label)));
+        return new GroupNode(context, NodeType_Group, t, Tree2Node(a, context), std::format("{}group({})", prefix, extractName(label)));
     }
 
     if (Tree route; isBoxRoute(t, a, b, route)) {
         int ins, outs;
         std::vector<int> routes;
         // Build `ins`x`outs` cable routing.
-        if (isBoxInt(a, &ins) && isBoxInt(b, &outs) && isBoxInts(route, routes)) return new RouteNode(*this, t, ins, outs, routes);
+        if (isBoxInt(a, &ins) && isBoxInt(b, &outs) && isBoxInts(route, routes)) return new RouteNode(context, t, ins, outs, routes);
         throw std::runtime_error("Invalid route expression : " + PrintTree(t));
     }
 
@@ -1206,21 +1478,23 @@ Node *FaustGraph::Tree2NodeInner(Tree t) const {
 
 // This method calls itself through `Tree2NodeInner`.
 // (Keeping these bad names to remind me to clean this up, likely into a `Node` ctor.)
-Node *FaustGraph::Tree2Node(Tree t) const {
-    auto *node = Tree2NodeInner(t);
-    if (GetTreeName(t).empty()) return node; // Normal case
+Node *FaustGraph::Tree2Node(Tree t, const TreeContext &context) const {
+    auto *node = Tree2NodeInner(t, context);
+    // Read the info for `t` rather than `node->Info`, which is for a different box when `t` is a metadata box.
+    const auto info = GetBoxInfo(t);
+    if (info->Name.empty()) return node; // Normal case
 
     // `FoldComplexity == 0` means no folding.
-    if (Style.FoldComplexity != 0u && node->Descendents >= u32(Style.FoldComplexity)) {
+    if (context.FoldComplexity != 0u && node->Descendents >= context.FoldComplexity) {
         int ins, outs;
         getBoxType(t, &ins, &outs);
-        return new BlockNode(*this, t, ins, outs, "", FlowGridGraphCol_Link, new GroupNode(*this, NodeType_Decorate, t, node));
+        return new BlockNode(context, t, ins, outs, "", FlowGridGraphCol_Link, new GroupNode(context, NodeType_Decorate, t, node));
     }
-    return IsPureRouting(t) ? node : new GroupNode(*this, NodeType_Group, t, node);
+    return info->IsPureRouting ? node : new GroupNode(context, NodeType_Group, t, node);
 }
 
 FaustGraph::FaustGraph(ArgsT &&args, const FaustGraphStyle &style, const FaustGraphSettings &settings)
-    : ActionProducerComponent(std::move(args)), Style(style), Settings(settings) {}
+    : ActionProducerComponent(std::move(args)), Style(style), Settings(settings), StyleValues(std::make_unique<flowgrid::GraphStyleValues>(style)) {}
 
 FaustGraph::~FaustGraph() {}
 
@@ -1232,32 +1506,75 @@ float FaustGraph::GetScale() const {
 void FaustGraph::SaveBoxSvg(const fs::path &dir_path) const {
     if (!RootNode) return;
 
+    SvgExport.reset(); // Cancel and join any export in progress before clearing its directory.
     fs::remove_all(dir_path);
     fs::create_directory(dir_path);
 
-    GroupNode node{*this, NodeType_Decorate, RootNode->FaustTree, Tree2NodeInner(RootNode->FaustTree)};
-    node.Place(DeviceType_SVG);
-    node.WriteSvg(dir_path);
+    SvgExport = std::make_unique<flowgrid::SvgExportJob>(*this, RootNode->FaustTree, Style.FoldComplexity, Style, dir_path, GetScale());
 }
 
-void FaustGraph::SetBox(Box box) {
-    IsTreePureRouting.clear();
-    NodeNavigationHistory.IssueClear();
-    RootNode.reset();
+void FaustGraph::CancelSvgExport() const {
+    if (SvgExport) SvgExport->Cancel();
+}
+
+bool FaustGraph::IsExportingSvg() const { return SvgExport && !SvgExport->IsDone(); }
+
+void FaustGraph::SetBox(Box box, bool force) {
+    // Faust boxes are hash-consed, so pointer equality is structural equality.
+    // An identical box produces an identical node tree, so keep the current tree, its cached layout, and navigation history.
+    if (!force && box == _Box && (RootNode || NodeTreeBuild || !box)) return;
+
+    _Box = box;
+    std::erase_if(SupersededNodeTreeBuilds, [](const auto &build) { return build->IsDone(); });
+    if (NodeTreeBuild) {
+        NodeTreeBuild->Cancel();
+        SupersededNodeTreeBuilds.emplace_back(std::move(NodeTreeBuild));
+    }
     if (box) {
-        RootNode = std::make_unique<GroupNode>(*this, NodeType_Decorate, box, Tree2NodeInner(box));
+        NodeTreeBuild = std::make_unique<flowgrid::NodeTreeBuildJob>(*this, box, Style);
+    } else {
+        NodeNavigationHistory.IssueClear();
         NodeByImGuiId.clear();
+        PlacedNodeByLayoutHash.clear();
+        RootNode.reset();
+        EraseUnusedBoxInfo();
+    }
+}
+
+bool FaustGraph::IsNodeTreeBuilt() const { return NodeTreeBuild && NodeTreeBuild->IsDone(); }
+bool FaustGraph::IsBuildingNodeTree() const { return bool(NodeTreeBuild); }
+
+void FaustGraph::AdoptNodeTree() {
+    if (!IsNodeTreeBuilt()) return;
+
+    // The previous tree is destroyed before generating IDs for the new one, since unchanged nodes have the same IDs.
+    PlacedNodeByLayoutHash.clear();
+    RootNode = std::move(NodeTreeBuild->Root);
+    StyleValues = std::move(NodeTreeBuild->Style);
+    NodeTreeBuild.reset();
+    *StyleValues = GraphStyleValues{Style}; // The style may have changed since the build started.
+    NodeNavigationHistory.IssueClear();
+    NodeByImGuiId.clear();
+    if (RootNode) {
         RootNode->GenerateIds(Id);
         NodeNavigationHistory.IssuePush(RootNode->ImGuiId);
     }
+    EraseUnusedBoxInfo();
 }
 
 void FaustGraph::ResetBox() {
-    if (RootNode) SetBox(RootNode->FaustTree);
+    if (_Box) SetBox(_Box, true);
+}
+
+void FaustGraph::InvalidateLayout() {
+    *StyleValues = flowgrid::GraphStyleValues{Style};
+    LayoutVersion++;
+    PlacedNodeByLayoutHash.clear();
 }
 
 void FaustGraph::Render() const {
     if (!RootNode) {
+        if (NodeTreeBuild) return TextUnformatted("Building graph...");
         // todo don't show empty menu bar in this case
         TextUnformatted("Enter a valid Faust program into the 'Faust editor' window to view its graph."); // todo link to window?
         return;
@@ -1283,6 +1600,15 @@ void FaustGraph::Render() const {
         if (!can_step_forward) BeginDisabled();
         if (Button("Forward")) NodeNavigationHistory.IssueStepForward();
         if (!can_step_forward) EndDisabled();
+
+        if (SvgExport && SvgExport->IsDone()) SvgExport.reset();
+        if (SvgExport) {
+            SameLine();
+            const u32 written = SvgExport->GetWrittenCount(), total = SvgExport->GetFileCount();
+            ProgressBar(float(written) / float(total), {GetContentRegionAvail().x * 0.5f, 0}, std::format("Exporting SVG: {}/{}", written, total).c_str());
+            SameLine();
+            if (Button("Cancel")) Q(Action::Faust::Graph::CancelSaveSvgFile{DspId});
+        }
     }
 
     auto *focused = NodeByImGuiId.at(*NodeNavigationHistory);
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <mutex>
+
 #include "Core/ActionProducerComponent.h"
 #include "Core/Container/Navigable.h"
 #include "FaustGraphAction.h"
@@ -9,7 +11,12 @@ typedef CTreeBase *Box;
 
 namespace flowgrid {
 struct Node;
-}
+struct BoxInfo;
+struct GraphStyleValues;
+struct TreeContext;
+struct SvgExportJob;
+struct NodeTreeBuildJob;
+} // namespace flowgrid
 
 struct FaustGraphStyle;
 struct FaustGraphSettings;
@@ -20,9 +27,22 @@ struct FaustGraph : ActionProducerComponent<Action::Faust::Graph::Any> {
 
     float GetScale() const;
 
+    // Writes the SVG files on background threads, replacing any export in progress.
     void SaveBoxSvg(const fs::path &dir_path) const;
-    void SetBox(Box);
-    void ResetBox(); // Set to the box of the current root node.
+    void CancelSvgExport() const;
+    bool IsExportingSvg() const;
+    // Builds the node tree for the box on a background thread, replacing any build in progress.
+    // The current tree is shown until the new one is adopted.
+    // No-op if the box is unchanged, unless `force` is true.
+    void SetBox(Box, bool force = false);
+    void ResetBox(); // Rebuild the node tree from the current box.
+    bool IsNodeTreeBuilt() const; // Returns true if a built node tree is waiting to be adopted.
+    bool IsBuildingNodeTree() const; // Returns true if a node tree is being built, or waiting to be adopted.
+    void AdoptNodeTree(); // Replace the current node tree with the built one.
+    void InvalidateLayout(); // Refresh the style values used by the node tree, and mark all cached node layouts as stale.
+
+    // Returns the (memoized) info for the box, shared across all nodes for the box.
+    std::shared_ptr<const flowgrid::BoxInfo> GetBoxInfo(Box) const;
 
     Prop(UInt, DspId);
     Prop(Navigable<u32>, NodeNavigationHistory);
@@ -30,13 +50,31 @@ struct FaustGraph : ActionProducerComponent<Action::Faust::Graph::Any> {
     const FaustGraphStyle &Style;
     const FaustGraphSettings &Settings;
 
-    Box _Box;
+    // Copy of `Style` read by the node tree, so building a tree off of the UI thread never reads the style.
+    // Adopted from the build job along with the tree, and refreshed on the UI thread whenever the style changes.
+    std::unique_ptr<flowgrid::GraphStyleValues> StyleValues;
+    Box _Box{nullptr};
+    u32 LayoutVersion{0}; // Incremented whenever a style change may affect node layout.
     mutable std::unordered_map<ID, flowgrid::Node *> NodeByImGuiId;
     std::unique_ptr<flowgrid::Node> RootNode{};
+    // The first node placed for each subtree structure and layout key. Other occurrences of the subtree copy its layout.
+    // Points into `RootNode`, or transiently into an SVG export tree while it's being placed, and is cleared when either is replaced.
+    mutable std::unordered_map<size_t, const flowgrid::Node *> PlacedNodeByLayoutHash;
+    mutable std::unordered_map<Box, std::shared_ptr<const flowgrid::BoxInfo>> BoxInfoByBox{};
+    mutable std::mutex BoxInfoMutex; // Node trees are built on both the UI thread and background threads.
+    mutable std::unique_ptr<flowgrid::SvgExportJob> SvgExport{};
+    // Declared after everything the builds use, so they're joined first on destruction.
+    std::unique_ptr<flowgrid::NodeTreeBuildJob> NodeTreeBuild{};
+    // Replaced builds can't be interrupted once they've started, so they're kept (rather than joined) until they finish.
+    std::vector<std::unique_ptr<flowgrid::NodeTreeBuildJob>> SupersededNodeTreeBuilds{};
 
 private:
+    friend struct flowgrid::NodeTreeBuildJob;
+    friend struct flowgrid::SvgExportJob;
+
     void Render() const override;
 
-    flowgrid::Node *Tree2Node(Box) const;
-    flowgrid::Node *Tree2NodeInner(Box) const;
+    flowgrid::Node *Tree2Node(Box, const flowgrid::TreeContext &) const;
+    flowgrid::Node *Tree2NodeInner(Box, const flowgrid::TreeContext &) const;
+    void EraseUnusedBoxInfo() const;
 };
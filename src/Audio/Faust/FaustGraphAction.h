@@ -8,6 +8,8 @@ DefineNestedActionType(
     Json(ShowSaveSvgDialog);
 
     DefineAction(SaveSvgFile, Unsaved, NoMerge, "", ID dsp_id; fs::path dir_path;);
+    DefineAction(CancelSaveSvgFile, Unsaved, NoMerge, "", ID dsp_id;);
+    DefineAction(AdoptNodeTree, Unsaved, NoMerge, "", ID dsp_id;);
 
-    using Any = ActionVariant<ShowSaveSvgDialog, SaveSvgFile>;
+    using Any = ActionVariant<ShowSaveSvgDialog, SaveSvgFile, CancelSaveSvgFile, AdoptNodeTree>;
 );
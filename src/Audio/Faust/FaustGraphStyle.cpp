@@ -150,6 +150,7 @@ void FaustGraphStyle::Render() const {
                 TextUnformatted(std::format("Uncheck '{}' to manually edit graph scale.", ScaleFillHeight.Name));
                 EndDisabled();
             }
+            DetailMinHeight.Draw();
             Direction.Draw();
             OrientationMark.Draw();
             if (OrientationMark) {
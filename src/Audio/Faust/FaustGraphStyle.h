@@ -55,6 +55,12 @@ struct FaustGraphStyle : ActionProducerComponent<Action::Faust::GraphStyle::Any>
     );
     Prop_(Bool, ScaleFillHeight, "?Automatically scale to fill the full height of the graph window, keeping the same aspect ratio.");
     Prop(Float, Scale, 1, 0.1, 5);
+    Prop_(
+        Float, DetailMinHeight,
+        "?Nodes with children rendered shorter than this height (in pixels) are drawn as a single labeled block.\n"
+        "Setting to zero always draws full detail.",
+        16, 0, 128
+    );
     Prop(Enum, Direction, {"Left", "Right"}, Dir_Right);
     Prop(Bool, RouteFrame);
     Prop(Bool, SequentialConnectionZigzag); // `false` uses diagonal lines instead of zigzags instead of zigzags
@@ -0,0 +1,117 @@
+#include "FaustInstance.h"
+
+#include <algorithm>
+#include <map>
+
+#include "faust/gui/PathBuilder.h"
+#include "faust/gui/UI.h"
+
+namespace {
+// Collects the zones of a DSP's active and passive params by full path, and the ranges of its active params.
+struct ZonesUI : UI, PathBuilder {
+    struct Range {
+        Real Min, Max, Init;
+    };
+
+    std::map<std::string, Real *> ActiveZoneByPath, PassiveZoneByPath;
+    std::map<std::string, Range> ActiveRangeByPath;
+
+    void openTabBox(const char *label) override { pushLabel(label); }
+    void openHorizontalBox(const char *label) override { pushLabel(label); }
+    void openVerticalBox(const char *label) override { pushLabel(label); }
+    void closeBox() override { popLabel(); }
+
+    void addButton(const char *label, Real *zone) override { AddActive(label, zone, 0, 1, 0); }
+    void addCheckButton(const char *label, Real *zone) override { AddActive(label, zone, 0, 1, 0); }
+    void addVerticalSlider(const char *label, Real *zone, Real init, Real min, Real max, Real) override { AddActive(label, zone, min, max, init); }
+    void addHorizontalSlider(const char *label, Real *zone, Real init, Real min, Real max, Real) override { AddActive(label, zone, min, max, init); }
+    void addNumEntry(const char *label, Real *zone, Real init, Real min, Real max, Real) override { AddActive(label, zone, min, max, init); }
+
+    void addHorizontalBargraph(const char *label, Real *zone, Real, Real) override { PassiveZoneByPath[buildPath(label)] = zone; }
+    void addVerticalBargraph(const char *label, Real *zone, Real, Real) override { PassiveZoneByPath[buildPath(label)] = zone; }
+
+    void addSoundfile(const char *, const char *, Soundfile **) override {}
+    void declare(Real *, const char *, const char *) override {}
+
+private:
+    void AddActive(const char *label, Real *zone, Real min, Real max, Real init) {
+        const auto path = buildPath(label);
+        ActiveZoneByPath[path] = zone;
+        ActiveRangeByPath[path] = {min, max, init};
+    }
+};
+} // namespace
+
+FaustInstance::FaustInstance(dsp *prototype) : decorator_dsp(prototype->clone()), Prototype(prototype) {
+    ZonesUI prototype_zones, instance_zones;
+    Prototype->buildUserInterface(&prototype_zones);
+    fDSP->buildUserInterface(&instance_zones);
+
+    const auto count_links = [](const auto &zone_by_path, const auto &source_zone_by_path) {
+        return std::ranges::count_if(zone_by_path, [&](const auto &entry) { return source_zone_by_path.contains(entry.first); });
+    };
+    ActiveLinks = std::vector<ZoneLink>(count_links(instance_zones.ActiveZoneByPath, prototype_zones.ActiveZoneByPath));
+    PassiveLinks = std::vector<ZoneLink>(count_links(instance_zones.PassiveZoneByPath, prototype_zones.PassiveZoneByPath));
+
+    auto active_link = ActiveLinks.begin();
+    for (const auto &[path, zone] : instance_zones.ActiveZoneByPath) {
+        ZoneByPath[path] = zone;
+        const auto &range = instance_zones.ActiveRangeByPath.at(path);
+        auto &param = ActiveParams.emplace_back(ActiveParam{path, zone, nullptr, range.Min, range.Max, range.Init});
+        if (auto it = prototype_zones.ActiveZoneByPath.find(path); it != prototype_zones.ActiveZoneByPath.end()) {
+            param.PrototypeZone = it->second;
+            active_link->Source = it->second;
+            active_link->Destination = zone;
+            ++active_link;
+        }
+    }
+    auto passive_link = PassiveLinks.begin();
+    for (const auto &[path, zone] : instance_zones.PassiveZoneByPath) {
+        ZoneByPath[path] = zone;
+        if (auto it = prototype_zones.PassiveZoneByPath.find(path); it != prototype_zones.PassiveZoneByPath.end()) {
+            passive_link->Source = zone;
+            passive_link->Destination = it->second;
+            ++passive_link;
+        }
+    }
+}
+
+void FaustInstance::compute(int count, FAUSTFLOAT **inputs, FAUSTFLOAT **outputs) {
+    for (const auto &link : ActiveLinks) {
+        if (link.Attached.load(std::memory_order_relaxed)) *link.Destination = *link.Source;
+    }
+    fDSP->compute(count, inputs, outputs);
+    for (const auto &link : PassiveLinks) *link.Destination = *link.Source;
+}
+
+Real *FaustInstance::GetZone(const std::string &path) const {
+    if (auto it = ZoneByPath.find(path); it != ZoneByPath.end()) return it->second;
+    return nullptr;
+}
+
+std::string FaustInstance::FindPath(std::string_view label) const {
+    for (const auto &[path, _] : ZoneByPath) {
+        if (path.ends_with(label) && path.size() > label.size() && path[path.size() - label.size() - 1] == '/') return path;
+    }
+    return "";
+}
+
+void FaustInstance::SetAttached(const std::string &path, bool attached) {
+    if (auto *zone = GetZone(path)) {
+        for (auto &link : ActiveLinks) {
+            if (link.Destination == zone) link.Attached = attached;
+        }
+    }
+}
+
+void FaustInstance::Detach(const std::string &path) { SetAttached(path, false); }
+void FaustInstance::Attach(const std::string &path) { SetAttached(path, true); }
+
+void CopyParamValues(dsp &from, dsp &to) {
+    ZonesUI from_zones, to_zones;
+    from.buildUserInterface(&from_zones);
+    to.buildUserInterface(&to_zones);
+    for (const auto &[path, zone] : to_zones.ActiveZoneByPath) {
+        if (auto it = from_zones.ActiveZoneByPath.find(path); it != from_zones.ActiveZoneByPath.end()) *zone = *it->second;
+    }
+}
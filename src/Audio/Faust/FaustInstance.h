@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "Audio/Sample.h" // Must be included before any Faust includes.
+#include "faust/dsp/dsp.h"
+
+// A DSP instance with its own state, cloned from a prototype DSP whose param values it follows.
+// All instances of a prototype share its factory (and JIT-compiled code), so each instance only costs its DSP state.
+// Before each `compute`, active (input) param values are copied from the prototype (unless detached),
+// and after each `compute`, passive (output) param values are copied back to it.
+struct FaustInstance : decorator_dsp {
+    struct ActiveParam {
+        std::string Path;
+        Real *Zone;
+        const Real *PrototypeZone; // The zone of the prototype's param at the same path, or `nullptr` if it has none.
+        Real Min, Max, Init;
+    };
+
+    FaustInstance(dsp *prototype);
+
+    void compute(int count, FAUSTFLOAT **inputs, FAUSTFLOAT **outputs) override;
+    void compute(double, int count, FAUSTFLOAT **inputs, FAUSTFLOAT **outputs) override { compute(count, inputs, outputs); }
+
+    // Returns the zone of the param with the given full path (e.g. "/FlowGrid/freq"), or `nullptr` if there is none.
+    Real *GetZone(const std::string &path) const;
+    // Returns the full path of a param with the given label (its last path segment), or an empty string if there is none.
+    std::string FindPath(std::string_view label) const;
+    // The instance's active (input) params, ordered by path.
+    const std::vector<ActiveParam> &GetActiveParams() const { return ActiveParams; }
+
+    // Stop following the prototype's value for the param with the given full path, so it can be controlled directly through its zone.
+    // Safe to call while the instance is being computed on another thread.
+    void Detach(const std::string &path);
+    // Follow the prototype's value for a detached param again.
+    void Attach(const std::string &path);
+
+    dsp *const Prototype;
+
+private:
+    struct ZoneLink {
+        Real *Source{nullptr}, *Destination{nullptr};
+        std::atomic<bool> Attached{true};
+    };
+
+    void SetAttached(const std::string &path, bool attached);
+
+    std::vector<ActiveParam> ActiveParams{};
+    // Allocated once on construction, since links aren't movable.
+    std::vector<ZoneLink> ActiveLinks{}, PassiveLinks{};
+    std::unordered_map<std::string, Real *> ZoneByPath{};
+};
+
+// Copy the values of active (input) params from one DSP to the params at the same full paths in another
+// (e.g. from a DSP to its recompiled replacement).
+void CopyParamValues(dsp &from, dsp &to);
@@ -0,0 +1,106 @@
+#include "FaustLibraries.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <thread>
+#include <unordered_map>
+
+#include "Core/Helper/File.h"
+
+#include "Audio/Sample.h" // Must be included before any Faust includes.
+#include "faust/dsp/libfaust-box.h"
+
+namespace FaustLibraries {
+using ModifiedTimes = std::unordered_map<std::string, fs::file_time_type>;
+
+// The reference count and the watcher are guarded by `Mutex`.
+static int ContextRefCount = 0;
+static std::atomic<unsigned int> Generation{0}; // Read by compile jobs without the lock, to discard stale results.
+static ModifiedTimes ModifiedTimesSnapshot{};
+static unsigned int SnapshotVersion = 0; // Incremented with each new snapshot, so scans started before it are discarded.
+static std::mutex Mutex, SnapshotMutex;
+static std::atomic<bool> Stale{false};
+static std::jthread Watcher;
+
+const std::string &GetPath() {
+    static const std::string path = fs::relative("../lib/faust/libraries");
+    return path;
+}
+
+static ModifiedTimes GetModifiedTimes() {
+    ModifiedTimes modified_times;
+    std::error_code error;
+    for (auto it = fs::recursive_directory_iterator(GetPath(), error); !error && it != fs::recursive_directory_iterator(); it.increment(error)) {
+        if (it->is_regular_file() && it->path().extension() == ".lib") {
+            modified_times[it->path().string()] = it->last_write_time(error);
+        }
+    }
+    return modified_times;
+}
+
+static void TakeSnapshot() {
+    auto modified_times = GetModifiedTimes();
+    std::scoped_lock lock{SnapshotMutex};
+    ModifiedTimesSnapshot = std::move(modified_times);
+    SnapshotVersion++;
+    Stale = false;
+}
+
+static void Watch(std::stop_token stop_token) {
+    std::mutex mutex;
+    std::condition_variable_any stopped;
+    while (!stop_token.stop_requested()) {
+        unsigned int version;
+        {
+            std::scoped_lock lock{SnapshotMutex};
+            version = SnapshotVersion;
+        }
+        auto modified_times = GetModifiedTimes();
+        {
+            std::scoped_lock lock{SnapshotMutex};
+            if (version == SnapshotVersion && modified_times != ModifiedTimesSnapshot) Stale = true;
+        }
+        std::unique_lock lock{mutex};
+        stopped.wait_for(lock, stop_token, WatchInterval, [] { return false; });
+    }
+}
+
+void Acquire() {
+    const auto lock = Lock();
+    if (ContextRefCount++ > 0) return;
+
+    createLibContext();
+    Generation++;
+    TakeSnapshot();
+    Watcher = std::jthread{Watch};
+}
+
+void Release() {
+    const auto lock = Lock();
+    if (--ContextRefCount > 0) return;
+
+    Watcher = {}; // Stop and join. The watcher never takes `Mutex`.
+    destroyLibContext();
+    Generation++;
+    std::scoped_lock snapshot_lock{SnapshotMutex};
+    ModifiedTimesSnapshot.clear();
+    Stale = false;
+}
+
+// `Stale` is only set by the watcher, which only runs while the context exists, and is cleared when the context is destroyed.
+bool IsStale() { return Stale; }
+
+void Reload() {
+    const auto lock = Lock();
+    if (ContextRefCount == 0) return;
+
+    destroyLibContext();
+    createLibContext();
+    Generation += 2; // Destroyed and created.
+    TakeSnapshot();
+}
+
+unsigned int GetGeneration() { return Generation; }
+
+std::unique_lock<std::mutex> Lock() { return std::unique_lock{Mutex}; }
+} // namespace FaustLibraries
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <string>
+
+// Owns the libfaust library context, in which all Faust boxes are created.
+// The context is shared by all compiles in the process. It's created by the first `Acquire` and destroyed by the last `Release`.
+// Destroying the context frees all boxes created within it.
+// libfaust's global state (including the hash-consed box table and the properties cached on boxes) is not thread-safe,
+// so any thread creating or traversing boxes must hold `Lock()`.
+// libfaust has no API for reusing parsed library files across compiles, so each compile still parses the libraries it imports.
+// Retaining the context only avoids recreating it (and its box table) for each compile.
+namespace FaustLibraries {
+const std::string &GetPath(); // The Faust libraries directory (`-I` include path).
+
+void Acquire();
+void Release();
+
+// Returns true if any library file was added, removed, or modified since the context was (re)created.
+// Library files are scanned on a background thread every `WatchInterval` while the context exists, so this is cheap to call,
+// and may take up to `WatchInterval` to notice a change.
+bool IsStale();
+inline constexpr std::chrono::milliseconds WatchInterval{1000};
+// Recreate the context and take a new snapshot of library modification times. All existing boxes are invalidated.
+void Reload();
+
+// Incremented each time the context is created or destroyed, so boxes cached from a destroyed context can be detected.
+unsigned int GetGeneration();
+
+std::unique_lock<std::mutex> Lock();
+} // namespace FaustLibraries
@@ -1,17 +1,55 @@
 #include "FaustNode.h"
 
+#include "imgui.h"
+
 #include "Audio/Graph/AudioGraph.h"
+#include "Core/Primitive/Bool.h"
+#include "Core/Primitive/Float.h"
 
 #include "Faust.h"
 
 #include "Audio/Graph/ma_faust_node/ma_faust_node.h"
 
+#include "FaustInstance.h"
+
+static std::unique_ptr<FaustInstance> CreateInstance(dsp *prototype) { return prototype ? std::make_unique<FaustInstance>(prototype) : nullptr; }
+
+// A param of one node's own instance, detached from the DSP's param at the same path.
+struct FaustInstanceParam : Float {
+    FaustInstanceParam(ComponentArgs &&args, const FaustInstance::ActiveParam &param, Real value)
+        : Float(std::move(args), float(value), float(param.Min), float(param.Max)), FaustPath(param.Path), Zone(param.Zone) {
+        WriteZone();
+    }
+
+    void Refresh() override {
+        Float::Refresh();
+        WriteZone();
+    }
+
+    const std::string FaustPath;
+    Real *Zone;
+
+private:
+    void WriteZone() const { *Zone = std::clamp(Real(Value), Real(Min), Real(Max)); }
+};
+
+// Faust paths (e.g. "/FlowGrid/freq") as single path segments.
+static std::string ToPathSegment(std::string_view faust_path) {
+    std::string segment{faust_path.starts_with('/') ? faust_path.substr(1) : faust_path};
+    std::ranges::replace(segment, '/', '.');
+    return segment;
+}
+
+// Each node computes its own instance of its Faust DSP, following the param values of the DSP's (prototype) instance.
 struct FaustMaNode : MaNode, Component, ChangeListener {
     FaustMaNode(ComponentArgs &&args, AudioGraph *graph, ID dsp_id = 0)
         : MaNode(), Component(std::move(args)), Graph(graph), ParentNode(static_cast<AudioGraphNode *>(Parent)) {
         if (dsp_id != 0 && DspId == 0u) DspId.Set_(_S, dsp_id);
-        Init(Graph->GetFaustDsp(DspId), Graph->SampleRate);
+        Init(CreateInstance(Graph->GetFaustDsp(DspId)), Graph->SampleRate);
+        UpdateInstanceParams();
         DspId.RegisterChangeListener(this);
+        OwnParams.RegisterChangeListener(this);
+        Graph->FaustCrossfadeMs.RegisterChangeListener(this);
     }
     ~FaustMaNode() {
         UnregisterChangeListener(this);
@@ -20,34 +58,79 @@ struct FaustMaNode : MaNode, Component, ChangeListener {
 
     void OnComponentChanged() override {
         if (DspId.IsChanged()) UpdateDsp();
+        if (OwnParams.IsChanged()) UpdateInstanceParams();
+        if (Graph->FaustCrossfadeMs.IsChanged()) UpdateCrossfadeFrames();
     }
 
-    void Init(dsp *dsp, u32 sample_rate) {
-        auto config = ma_faust_node_config_init(dsp, sample_rate, Graph->GetBufferFrames());
+    // Create a param for each of the instance's active params if it has its own params, or else follow the DSP's params.
+    // Params at unchanged paths keep their values when the instance is replaced.
+    void UpdateInstanceParams() {
+        std::unordered_map<std::string, float> value_by_path;
+        for (const auto &param : InstanceParams) value_by_path[param->FaustPath] = float(*param);
+        InstanceParams.clear();
+        if (!Instance) return;
+
+        for (const auto &param : Instance->GetActiveParams()) {
+            if (!OwnParams) {
+                Instance->Attach(param.Path);
+                continue;
+            }
+            Instance->Detach(param.Path);
+            // New params start at the value they were following.
+            const auto it = value_by_path.find(param.Path);
+            const Real value = it != value_by_path.end() ? Real(it->second) : param.PrototypeZone ? *param.PrototypeZone : param.Init;
+            auto &instance_param = InstanceParams.emplace_back(std::make_unique<FaustInstanceParam>(ComponentArgs{this, ToPathSegment(param.Path), param.Path}, param, value));
+            if (it != value_by_path.end()) instance_param->Set_(_S, it->second);
+        }
+    }
+
+    void Init(std::unique_ptr<FaustInstance> instance, u32 sample_rate) {
+        Instance = std::move(instance);
+        auto config = ma_faust_node_config_init(Instance.get(), sample_rate, Graph->GetBufferFrames());
         ma_result result = ma_faust_node_init(Graph->Get(), &config, nullptr, &_Node);
         if (result != MA_SUCCESS) throw std::runtime_error(std::format("Failed to initialize the Faust audio graph node: {}", int(result)));
 
         Node = &_Node;
+        UpdateCrossfadeFrames();
     }
     void Uninit() {
         ma_faust_node_uninit(&_Node, nullptr);
+        // The audio thread is no longer processing this node.
+        Instance.reset();
+        RetiredInstances.clear();
+    }
+
+    void UpdateCrossfadeFrames() {
+        ma_faust_node_set_crossfade_frames(&_Node, u32(Graph->FaustCrossfadeMs * float(ma_faust_node_get_sample_rate(&_Node)) / 1000.f));
     }
 
     void UpdateDsp() {
-        auto *new_dsp = Graph->GetFaustDsp(DspId);
-        auto *current_dsp = ma_faust_node_get_dsp(&_Node);
-        if (!new_dsp && !current_dsp) return;
+        auto *new_prototype = Graph->GetFaustDsp(DspId);
+        const auto *current_prototype = Instance ? Instance->Prototype : nullptr;
+        if (new_prototype == current_prototype) return;
 
-        auto new_in_channels = ma_faust_dsp_get_in_channels(new_dsp);
-        auto new_out_channels = ma_faust_dsp_get_out_channels(new_dsp);
+        auto new_instance = CreateInstance(new_prototype);
+        auto new_in_channels = ma_faust_dsp_get_in_channels(new_instance.get());
+        auto new_out_channels = ma_faust_dsp_get_out_channels(new_instance.get());
         auto current_in_channels = ma_faust_node_get_in_channels(&_Node);
         auto current_out_channels = ma_faust_node_get_out_channels(&_Node);
-        if ((new_dsp && !current_dsp) || (!new_dsp && current_dsp) || current_in_channels != new_in_channels || current_out_channels != new_out_channels) {
+        if (!new_instance || !Instance || current_in_channels != new_in_channels || current_out_channels != new_out_channels) {
+            const u32 sample_rate = ma_faust_node_get_sample_rate(&_Node);
             Uninit();
-            Init(new_dsp, ma_faust_node_get_sample_rate(&_Node));
+            Init(std::move(new_instance), sample_rate);
+            UpdateInstanceParams();
             ParentNode->NotifyConnectionsChanged();
         } else {
-            ma_faust_node_set_dsp(&_Node, new_dsp);
+            // Hot-swap: Initialize the new instance here rather than on the audio thread.
+            // It picks up the current param values from its prototype, and the audio thread crossfades from the current instance to it.
+            // Prototypes compiled at this rate already initialized the class state shared with their clones.
+            const u32 sample_rate = ma_faust_node_get_sample_rate(&_Node);
+            if (new_prototype->getSampleRate() == int(sample_rate)) new_instance->instanceInit(sample_rate);
+            else new_instance->init(sample_rate);
+            RetiredInstances.emplace_back(std::move(Instance));
+            Instance = std::move(new_instance);
+            UpdateInstanceParams(); // Before the audio thread computes it.
+            ma_faust_node_set_dsp(&_Node, Instance.get());
         }
     }
 
@@ -56,12 +139,23 @@ struct FaustMaNode : MaNode, Component, ChangeListener {
         UpdateDsp();
     }
 
+    // Returns true if this node's instance, or any retired instance still in use by the audio thread, was cloned from the prototype.
+    bool IsUsingPrototype(const dsp *prototype) {
+        std::erase_if(RetiredInstances, [this](const auto &instance) { return !ma_faust_node_is_using_dsp(&_Node, instance.get()); });
+        if (Instance && Instance->Prototype == prototype) return true;
+        return std::ranges::any_of(RetiredInstances, [prototype](const auto &instance) { return instance->Prototype == prototype; });
+    }
+
     AudioGraph *Graph;
     AudioGraphNode *ParentNode; // Type-casted parent, for convenience.
 
     Prop(UInt, DspId);
+    Prop_(Bool, OwnParams, "?Control this node's params separately from its DSP's params.\nOtherwise, all nodes of a DSP follow its params.", false);
 
     ma_faust_node _Node;
+    std::unique_ptr<FaustInstance> Instance;
+    std::vector<std::unique_ptr<FaustInstance>> RetiredInstances; // Swapped-out instances, possibly still crossfading out.
+    std::vector<std::unique_ptr<FaustInstanceParam>> InstanceParams; // Only created if `OwnParams` is set.
 };
 
 FaustNode::FaustNode(ComponentArgs &&args, ID dsp_id) : AudioGraphNode(std::move(args), [this, dsp_id] { return CreateNode(dsp_id); }) {}
@@ -71,7 +165,22 @@ std::unique_ptr<MaNode> FaustNode::CreateNode(ID dsp_id) { return std::make_uniq
 void FaustNode::OnSampleRateChanged() {
     AudioGraphNode::OnSampleRateChanged();
     ma_faust_node_set_sample_rate((ma_faust_node *)Get(), Graph->SampleRate);
+    reinterpret_cast<FaustMaNode *>(Node.get())->UpdateCrossfadeFrames();
 }
 
 ID FaustNode::GetDspId() const { return reinterpret_cast<FaustMaNode *>(Node.get())->DspId; }
 void FaustNode::SetDsp(TransientStore &s, ID id) { reinterpret_cast<FaustMaNode *>(Node.get())->SetDsp(s, id); }
+bool FaustNode::IsUsingDsp(const dsp *dsp) const { return reinterpret_cast<FaustMaNode *>(Node.get())->IsUsingPrototype(dsp); }
+
+using namespace ImGui;
+
+void FaustNode::Render() const {
+    const auto *node = reinterpret_cast<const FaustMaNode *>(Node.get());
+    node->OwnParams.Draw();
+    if (!node->InstanceParams.empty() && TreeNodeEx("Params", ImGuiTreeNodeFlags_DefaultOpen)) {
+        for (const auto &param : node->InstanceParams) param->Draw();
+        TreePop();
+    }
+    Spacing();
+    AudioGraphNode::Render();
+}
@@ -13,7 +13,10 @@ struct FaustNode : AudioGraphNode {
 
     ID GetDspId() const;
     void SetDsp(TransientStore &, ID);
+    bool IsUsingDsp(const dsp *) const;
 
 private:
     std::unique_ptr<MaNode> CreateNode(ID dsp_id = 0);
+
+    void Render() const override;
 };
@@ -14,8 +14,8 @@ using enum FaustParamType;
 using std::min, std::max, std::accumulate;
 using std::views::transform, std::ranges::fold_left;
 
-FaustParam::FaustParam(ComponentArgs &&args, const FaustParamsStyle &style, const FaustParamType type, std::string_view label, Real *zone, Real min, Real max, Real init, Real step, const char *tooltip, NamesAndValues names_and_values)
-    : FaustParamBase(style, type, label), Float(std::move(args), init), Zone(zone), Min(min), Max(max), Init(init), Step(step), Tooltip(tooltip), names_and_values(std::move(names_and_values)) {}
+FaustParam::FaustParam(ComponentArgs &&args, const FaustParamsStyle &style, const FaustParamType type, std::string_view label, Real *zone, Real min, Real max, Real init, Real step, std::string tooltip, NamesAndValues names_and_values)
+    : FaustParamBase(style, type, label), Float(std::move(args), init), Zone(zone), Min(min), Max(max), Init(init), Step(step), Tooltip(std::move(tooltip)), names_and_values(std::move(names_and_values)) {}
 
 // todo config to place labels above horizontal params
 float FaustParam::CalcWidth(bool include_label) const {
@@ -127,12 +127,12 @@ void FaustParam::Render(float suggested_height, bool no_label) const {
 
     Ctx.UpdateWidgetGesturing();
 
-    if (Tooltip && IsItemHovered()) {
+    if (!Tooltip.empty() && IsItemHovered()) {
         // todo only leaf params, so group tooltips don't work.
         // todo hook up to Info pane hover info.
         BeginTooltip();
         PushTextWrapPos(GetFontSize() * 35);
-        TextUnformatted(Tooltip);
+        TextUnformatted(Tooltip.c_str());
         EndTooltip();
     }
 }
@@ -7,14 +7,14 @@
 #include "FaustParamBase.h"
 
 struct FaustParam : FaustParamBase, Float {
-    FaustParam(ComponentArgs &&, const FaustParamsStyle &style, const FaustParamType type = Type_None, std::string_view label = "", Real *zone = nullptr, Real min = 0, Real max = 0, Real init = 0, Real step = 0, const char *tooltip = nullptr, NamesAndValues names_and_values = {});
+    FaustParam(ComponentArgs &&, const FaustParamsStyle &style, const FaustParamType type = Type_None, std::string_view label = "", Real *zone = nullptr, Real min = 0, Real max = 0, Real init = 0, Real step = 0, std::string tooltip = "", NamesAndValues names_and_values = {});
 
     void Render(const float suggested_height, bool no_label = false) const override;
 
-    Real *Zone; // Only meaningful for widget params (not groups).
+    Real *Zone; // Only meaningful for widget params (not groups). Retargeted when the param is reused for a recompiled DSP.
     const Real Min, Max; // Only meaningful for sliders, num-entries, and bar graphs.
     const Real Init, Step; // Only meaningful for sliders and num-entries.
-    const char *Tooltip; // Only populated for params (not groups).
+    const std::string Tooltip; // Only populated for params (not groups).
     const NamesAndValues names_and_values; // Only nonempty for menus and radio buttons.
 
     float CalcWidth(bool include_label) const override;
@@ -1,4 +1,5 @@
 #include "FaustParams.h"
+#include "FaustInstance.h"
 #include "FaustParamsUI.h"
 
 #include "Audio/Sample.h" // Must be included before any Faust includes.
@@ -6,27 +7,173 @@
 
 #include <imgui.h>
 
-FaustParams::FaustParams(ComponentArgs &&args, const FaustParamsStyle &style)
-    : Component(std::move(args)), Style(style) {}
+#include <atomic>
+#include <map>
+#include <stack>
+#include <thread>
+
+#include "Core/Profiler.h"
+
+bool FaustParamDescriptor::IsReusableFor(const FaustParamDescriptor &other) const {
+    return Type == other.Type && Label == other.Label && ShortLabel == other.ShortLabel && IsGroup() == other.IsGroup() &&
+        Min == other.Min && Max == other.Max && Init == other.Init && Step == other.Step && Tooltip == other.Tooltip &&
+        names_and_values.names == other.names_and_values.names && names_and_values.values == other.names_and_values.values;
+}
+
+namespace {
+// Records the params declared by `FaustParamsUI` into a layout.
+struct FaustParamsLayoutRecorder : FaustParamsContainer {
+    void Add(FaustParamType type, const char *label, std::string_view short_label, Real *zone, Real min, Real max, Real init, Real step, const char *tooltip, NamesAndValues names_and_values) override {
+        const std::optional<u32> parent_index = GroupIndices.empty() ? std::nullopt : std::optional{GroupIndices.top()};
+        Layout.push_back({type, label, std::string(short_label), zone, min, max, init, step, tooltip ? tooltip : "", std::move(names_and_values), parent_index});
+        if (zone == nullptr) GroupIndices.push(Layout.size() - 1);
+    }
+
+    void PopGroup() override { GroupIndices.pop(); }
+
+    FaustParamsLayout Layout{};
+    std::stack<u32> GroupIndices{};
+};
+} // namespace
+
+// Builds a DSP's param layout on a worker thread.
+// Only the layout is built here. Param components are created when the UI thread adopts it.
+struct FaustParamsLayoutBuildJob {
+    FaustParamsLayoutBuildJob(dsp &dsp) : Worker([this, &dsp] { Build(dsp); }) {}
+    ~FaustParamsLayoutBuildJob() = default; // The worker is joined on destruction.
+
+    bool IsDone() const { return Done; }
+
+    FaustParamsLayout Layout{}; // Only accessed by the UI thread once done.
+
+private:
+    void Build(dsp &dsp) {
+        ProfileThread("Faust params layout");
+        ProfileZone("Build params layout");
+        FaustParamsLayoutRecorder recorder;
+        FaustParamsUI ui{recorder};
+        dsp.buildUserInterface(&ui);
+        Layout = std::move(recorder.Layout);
+        Done = true;
+    }
+
+    std::atomic<bool> Done{false};
+    std::jthread Worker; // Declared last, so it's started after everything it uses is initialized.
+};
+
+FaustParams::FaustParams(ArgsT &&args, const FaustParamsStyle &style)
+    : ActionProducerComponent(std::move(args)), Style(style) {}
 
 FaustParams::~FaustParams() {
     if (Dsp) Dsp->instanceResetUserInterface();
 }
 
+void FaustParams::Clear() {
+    // Destroy params in reverse creation order, so children are destroyed before their groups.
+    while (!AllParams.empty()) AllParams.pop_back();
+    Layout.clear();
+    LayoutDsp = nullptr;
+}
+
 void FaustParams::SetDsp(dsp *dsp) {
-    if (Dsp) {
-        Dsp->instanceResetUserInterface();
-        if (!dsp) Impl.reset();
-    }
+    if (dsp == Dsp) return;
+
+    LayoutBuild.reset(); // Any layout still being built is for a replaced DSP.
+    // When replacing a DSP (e.g. after recompiling), params with unchanged paths keep their values.
+    // The values are copied right away, so the new DSP doesn't run with default values until its layout is adopted.
+    if (LayoutDsp && dsp) CopyParamValues(*LayoutDsp, *dsp);
+    if (Dsp && !dsp) Dsp->instanceResetUserInterface();
+
     Dsp = dsp;
-    if (Dsp) {
-        Impl = std::make_unique<FaustParamsUI>(*this);
-        Dsp->buildUserInterface(Impl.get());
+    if (Dsp) LayoutBuild = std::make_unique<FaustParamsLayoutBuildJob>(*Dsp);
+    else Clear();
+}
+
+bool FaustParams::IsUsingDsp(const dsp *dsp) const { return dsp && (dsp == Dsp || dsp == LayoutDsp); }
+
+bool FaustParams::IsLayoutBuilt() const { return LayoutBuild && LayoutBuild->IsDone(); }
+bool FaustParams::IsBuildingLayout() const { return bool(LayoutBuild); }
+
+void FaustParams::AdoptLayout(TransientStore &s) {
+    if (!IsLayoutBuilt()) return;
+
+    auto layout = std::move(LayoutBuild->Layout);
+    LayoutBuild.reset();
+
+    // Reuse the param for each unchanged descriptor at the same path. Since a component's parent can't change,
+    // a param is only reused if its group is also reused.
+    static constexpr int RootIndex = -1;
+    std::map<std::pair<int, std::string_view>, u32> prev_index_by_parent_and_label;
+    for (u32 i = 0; i < Layout.size(); i++) {
+        const auto &prev = Layout[i];
+        prev_index_by_parent_and_label.try_emplace({prev.ParentIndex ? int(*prev.ParentIndex) : RootIndex, prev.ShortLabel}, i);
+    }
+    std::vector<std::optional<u32>> reused_index(layout.size());
+    std::vector<bool> is_reused(Layout.size(), false);
+    for (u32 i = 0; i < layout.size(); i++) {
+        const auto &descriptor = layout[i];
+        if (descriptor.ParentIndex && !reused_index[*descriptor.ParentIndex]) continue;
+
+        const int prev_parent_index = descriptor.ParentIndex ? int(*reused_index[*descriptor.ParentIndex]) : RootIndex;
+        if (auto it = prev_index_by_parent_and_label.find({prev_parent_index, descriptor.ShortLabel}); it != prev_index_by_parent_and_label.end()) {
+            const u32 prev_index = it->second;
+            if (!is_reused[prev_index] && Layout[prev_index].IsReusableFor(descriptor)) {
+                reused_index[i] = prev_index;
+                is_reused[prev_index] = true;
+            }
+        }
+    }
+
+    // Destroy the params that aren't reused before creating new ones, since a new param may have the same path as a destroyed one.
+    // Children come after their groups, so iterating in reverse destroys children first.
+    std::map<StorePath, float> value_by_path;
+    for (u32 i = AllParams.size(); i-- > 0;) {
+        if (is_reused[i]) continue;
+        if (const auto *param = dynamic_cast<const FaustParam *>(AllParams[i].get())) value_by_path[param->Path] = float(*param);
+        AllParams[i].reset();
+    }
+
+    std::vector<std::unique_ptr<FaustParamBase>> params(layout.size());
+    for (u32 i = 0; i < layout.size(); i++) {
+        const auto &d = layout[i];
+        auto &group = d.ParentIndex ? *static_cast<FaustParamGroup *>(params[*d.ParentIndex].get()) : RootGroup;
+        if (reused_index[i]) {
+            params[i] = std::move(AllParams[*reused_index[i]]);
+        } else if (d.IsGroup()) {
+            params[i] = std::make_unique<FaustParamGroup>(ComponentArgs{&group, d.ShortLabel, d.Label}, Style, d.Type, d.Label);
+        } else {
+            params[i] = std::make_unique<FaustParam>(ComponentArgs{&group, d.ShortLabel, d.Label}, Style, d.Type, d.Label, d.Zone, d.Min, d.Max, d.Init, d.Step, d.Tooltip, d.names_and_values);
+        }
+
+        auto *param = dynamic_cast<FaustParam *>(params[i].get());
+        if (!param) continue;
+
+        param->Zone = d.Zone;
+        if (reused_index[i]) {
+            *param->Zone = std::clamp(Real(float(*param)), param->Min, param->Max);
+        } else if (auto it = value_by_path.find(param->Path); it != value_by_path.end()) {
+            param->Set_(s, it->second);
+            *param->Zone = std::clamp(Real(it->second), param->Min, param->Max);
+        }
     }
+
+    // New params were appended to their groups, so restore the declaration order of each group's children.
+    RootGroup.Children.clear();
+    for (const auto &param : params) {
+        if (auto *group = dynamic_cast<FaustParamGroup *>(param.get())) group->Children.clear();
+    }
+    for (u32 i = 0; i < layout.size(); i++) {
+        auto &group = layout[i].ParentIndex ? *static_cast<FaustParamGroup *>(params[*layout[i].ParentIndex].get()) : RootGroup;
+        group.Children.push_back(dynamic_cast<Component *>(params[i].get()));
+    }
+
+    Layout = std::move(layout);
+    AllParams = std::move(params);
+    LayoutDsp = Dsp;
 }
 
 void FaustParams::Render() const {
-    if (!Impl) return;
+    if (!LayoutDsp) return;
 
     RootGroup.Render(ImGui::GetContentRegionAvail().y, true);
 
@@ -1,50 +1,68 @@
 #pragma once
 
+#include "Core/ActionProducerComponent.h"
 #include "Core/Primitive/UInt.h"
 
 #include "FaustParam.h"
 #include "FaustParamGroup.h"
-#include "FaustParamsContainer.h"
+#include "FaustParamsAction.h"
 
-#include <stack>
+#include <optional>
 
 class dsp;
-class FaustParamsUI;
 struct FaustParamsStyle;
-struct NamesAndValues;
+
+// An immutable description of a param or group, as declared by a DSP's `buildUserInterface`.
+struct FaustParamDescriptor {
+    FaustParamType Type;
+    std::string Label, ShortLabel;
+    Real *Zone; // `nullptr` for groups.
+    Real Min, Max, Init, Step;
+    std::string Tooltip;
+    NamesAndValues names_and_values;
+    std::optional<u32> ParentIndex; // The index of the containing group's descriptor, if any.
+
+    bool IsGroup() const { return Zone == nullptr; }
+    // A param created for one descriptor can be reused for another if they only differ by zone.
+    bool IsReusableFor(const FaustParamDescriptor &) const;
+};
+
+// Descriptors in declaration order, so each group comes before its children.
+using FaustParamsLayout = std::vector<FaustParamDescriptor>;
+
+struct FaustParamsLayoutBuildJob;
 
 // Label, shortname, or complete path (to discriminate between possibly identical labels
 // at different locations in the UI hierarchy) can be used to access any created widget.
 // See Faust's `APIUI` for possible extensions (response curves, gyro, ...).
-struct FaustParams : Component, FaustParamsContainer {
-    FaustParams(ComponentArgs &&, const FaustParamsStyle &);
+//
+// A DSP's param layout is built on a background thread, and adopted on the UI thread.
+// Adopting a layout keeps the param components for unchanged paths, and only creates the ones that are new or changed.
+// Until then, the params keep controlling the previous DSP, which is kept alive while they use it.
+struct FaustParams : ActionProducerComponent<Action::Faust::Params::Any> {
+    FaustParams(ArgsT &&, const FaustParamsStyle &);
     ~FaustParams() override;
 
     void SetDsp(dsp *);
+    bool IsUsingDsp(const dsp *) const;
+    bool IsLayoutBuilt() const; // Returns true if a built layout is waiting to be adopted.
+    bool IsBuildingLayout() const; // Returns true if a layout is being built, or waiting to be adopted.
+    void AdoptLayout(TransientStore &);
 
     Prop(UInt, DspId);
 
 private:
     void Render() const override;
 
-    void Add(FaustParamType type, const char *label, std::string_view short_label, Real *zone = nullptr, Real min = 0, Real max = 0, Real init = 0, Real step = 0, const char *tooltip = nullptr, NamesAndValues names_and_values = {}) override {
-        FaustParamGroup &active_group = Groups.empty() ? RootGroup : *Groups.top();
-        if (zone == nullptr) { // Group
-            AllParams.emplace_back(std::make_unique<FaustParamGroup>(ComponentArgs{&active_group, short_label, label}, Style, type, label));
-            Groups.push((FaustParamGroup *)AllParams.back().get());
-        } else { // Param
-            AllParams.emplace_back(std::make_unique<FaustParam>(ComponentArgs{&active_group, short_label, label}, Style, type, label, zone, min, max, init, step, tooltip, std::move(names_and_values)));
-        }
-    }
-
-    void PopGroup() override { Groups.pop(); }
+    void Clear(); // Destroy all params.
 
     const FaustParamsStyle &Style;
-    std::unique_ptr<FaustParamsUI> Impl;
 
     FaustParamGroup RootGroup{ComponentArgs{this, "Param"}, Style};
-    std::stack<FaustParamGroup *> Groups{};
     dsp *Dsp{nullptr};
+    dsp *LayoutDsp{nullptr}; // The DSP whose zones the params control.
 
+    FaustParamsLayout Layout{}; // The adopted layout. Each descriptor's param is at the same index in `AllParams`.
     std::vector<std::unique_ptr<FaustParamBase>> AllParams{};
+    std::unique_ptr<FaustParamsLayoutBuildJob> LayoutBuild{}; // Declared last, so it's joined first on destruction.
 };
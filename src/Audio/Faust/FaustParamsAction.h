@@ -0,0 +1,10 @@
+#pragma once
+
+#include "Core/Action/DefineAction.h"
+
+DefineNestedActionType(
+    Faust, Params,
+    DefineAction(AdoptLayout, Unsaved, NoMerge, "", ID dsp_id;);
+
+    using Any = ActionVariant<AdoptLayout>;
+);
@@ -0,0 +1,262 @@
+#include "FaustPolyNode.h"
+
+#include <array>
+#include <chrono>
+#include <cmath>
+
+#include "imgui.h"
+
+#include "Audio/Graph/AudioGraph.h"
+
+#include "Audio/Graph/ma_faust_poly_node/ma_faust_poly_node.h"
+
+#include "FaustInstance.h"
+
+namespace {
+// Voice instances cloned from a prototype, with their `freq`/`gate`/`gain` params detached from it.
+struct FaustPolyVoices {
+    FaustPolyVoices(dsp *prototype = nullptr, u32 voice_count = 0) : Prototype(prototype) {
+        if (!prototype) return;
+
+        for (u32 i = 0; i < voice_count; i++) {
+            auto &instance = Instances.emplace_back(std::make_unique<FaustInstance>(prototype));
+            Configs.push_back({instance.get(), DetachZone(*instance, "freq"), DetachZone(*instance, "gate"), DetachZone(*instance, "gain")});
+        }
+    }
+
+    static Real *DetachZone(FaustInstance &instance, std::string_view label) {
+        const auto path = instance.FindPath(label);
+        if (path.empty()) return nullptr;
+
+        instance.Detach(path);
+        return instance.GetZone(path);
+    }
+
+    dsp *Prototype;
+    std::vector<std::unique_ptr<FaustInstance>> Instances{};
+    std::vector<ma_faust_poly_voice_config> Configs{};
+};
+
+float DbToAmplitude(float db) { return std::pow(10.f, db / 20.f); }
+} // namespace
+
+struct FaustPolyMaNode : MaNode, Component, ChangeListener {
+    FaustPolyMaNode(ComponentArgs &&args, AudioGraph *graph, ID dsp_id = 0)
+        : MaNode(), Component(std::move(args)), Graph(graph), ParentNode(static_cast<AudioGraphNode *>(Parent)) {
+        if (dsp_id != 0 && DspId == 0u) DspId.Set_(_S, dsp_id);
+        Init(Graph->SampleRate);
+        DspId.RegisterChangeListener(this);
+        VoiceCount.RegisterChangeListener(this);
+        SilenceThreshold.RegisterChangeListener(this);
+    }
+    ~FaustPolyMaNode() {
+        UnregisterChangeListener(this);
+        Uninit();
+    }
+
+    void OnComponentChanged() override {
+        if (DspId.IsChanged() || VoiceCount.IsChanged()) UpdateVoices();
+        if (SilenceThreshold.IsChanged()) ma_faust_poly_node_set_silence_threshold(&_Node, DbToAmplitude(SilenceThreshold));
+    }
+
+    void Init(u32 sample_rate) {
+        Voices = FaustPolyVoices(Graph->GetFaustDsp(DspId), VoiceCount);
+        auto config = ma_faust_poly_node_config_init(Voices.Configs.data(), u32(Voices.Configs.size()), sample_rate, Graph->GetBufferFrames());
+        config.silence_threshold = DbToAmplitude(SilenceThreshold);
+        ma_result result = ma_faust_poly_node_init(Graph->Get(), &config, nullptr, &_Node);
+        if (result != MA_SUCCESS) throw std::runtime_error(std::format("Failed to initialize the Faust polyphonic audio graph node: {}", int(result)));
+
+        Node = &_Node;
+    }
+    void Uninit() {
+        ma_faust_poly_node_uninit(&_Node, nullptr);
+        // The audio thread is no longer processing this node.
+        Voices = {};
+    }
+
+    // Voices can't be hot-swapped, since held notes would need to move to the new voices.
+    // Changing the DSP or voice count reinitializes the node instead, which stops all notes.
+    void UpdateVoices() {
+        auto *prototype = Graph->GetFaustDsp(DspId);
+        if (prototype == Voices.Prototype && Voices.Instances.size() == (prototype ? u32(VoiceCount) : 0u)) return;
+
+        const u32 sample_rate = ma_faust_poly_node_get_sample_rate(&_Node);
+        Uninit();
+        Init(sample_rate);
+        ParentNode->NotifyConnectionsChanged();
+    }
+
+    void SetDsp(TransientStore &s, ID dsp_id) {
+        DspId.Set_(s, dsp_id);
+        UpdateVoices();
+    }
+
+    AudioGraph *Graph;
+    AudioGraphNode *ParentNode; // Type-casted parent, for convenience.
+
+    Prop(UInt, DspId);
+    Prop_(UInt, VoiceCount, "?The number of voices.\nA note played while all voices are in use steals the oldest voice.", 8, 1, 64);
+    Prop_(
+        Float, SilenceThreshold,
+        "?Released voices stop being computed once their output level stays below this level (in dB), until they play another note.",
+        -80, -140, -20
+    );
+    Prop_(Float, Velocity, "?The velocity of notes played with the keyboard.", 1, 0, 1);
+
+    ma_faust_poly_node _Node;
+    FaustPolyVoices Voices{};
+};
+
+std::vector<FaustPolyBenchmarkResult> BenchmarkFaustPolyVoices(dsp *prototype, u32 voice_count, u32 sample_rate, u32 block_frames, u32 block_count) {
+    using std::chrono::steady_clock;
+
+    std::vector<FaustPolyBenchmarkResult> results;
+    if (!prototype || voice_count == 0 || prototype->getNumOutputs() == 0) return results;
+
+    std::vector<u32> held_note_counts{0};
+    for (u32 count = 1; count < voice_count; count *= 2) held_note_counts.push_back(count);
+    held_note_counts.push_back(voice_count);
+
+    const u32 out_channels = prototype->getNumOutputs();
+    std::vector<float> output(block_frames * out_channels);
+    for (const u32 held_note_count : held_note_counts) {
+        // Each run gets a fresh node graph (without a device) and fresh voices, so no voice is still releasing from the previous run.
+        FaustPolyVoices voices{prototype, voice_count};
+        auto graph_config = ma_node_graph_config_init(out_channels);
+        ma_node_graph graph;
+        if (ma_node_graph_init(&graph_config, nullptr, &graph) != MA_SUCCESS) break;
+
+        auto config = ma_faust_poly_node_config_init(voices.Configs.data(), voice_count, sample_rate, block_frames);
+        ma_faust_poly_node poly_node;
+        if (ma_faust_poly_node_init(&graph, &config, nullptr, &poly_node) != MA_SUCCESS) {
+            ma_node_graph_uninit(&graph, nullptr);
+            break;
+        }
+        ma_node_attach_output_bus(&poly_node, 0, ma_node_graph_get_endpoint(&graph), 0);
+        for (u32 i = 0; i < held_note_count; i++) ma_faust_poly_node_note_on(&poly_node, u8(36 + i), 1);
+
+        const u32 warmup_block_count = std::max(block_count / 10, 1u);
+        for (u32 i = 0; i < warmup_block_count; i++) ma_node_graph_read_pcm_frames(&graph, output.data(), block_frames, nullptr);
+
+        const auto compute_start = steady_clock::now();
+        for (u32 i = 0; i < block_count; i++) ma_node_graph_read_pcm_frames(&graph, output.data(), block_frames, nullptr);
+        const auto compute_ns = std::chrono::duration<float, std::nano>(steady_clock::now() - compute_start).count();
+        const float ns_per_block = compute_ns / float(std::max(block_count, 1u));
+        const float block_ns = 1e9f * float(block_frames) / float(sample_rate);
+        results.push_back({held_note_count, ma_faust_poly_node_get_active_voice_count(&poly_node), ns_per_block, 100 * ns_per_block / block_ns});
+
+        ma_faust_poly_node_uninit(&poly_node, nullptr);
+        ma_node_graph_uninit(&graph, nullptr);
+    }
+    return results;
+}
+
+FaustPolyNode::FaustPolyNode(ComponentArgs &&args, ID dsp_id) : AudioGraphNode(std::move(args), [this, dsp_id] { return CreateNode(dsp_id); }) {}
+
+std::unique_ptr<MaNode> FaustPolyNode::CreateNode(ID dsp_id) { return std::make_unique<FaustPolyMaNode>(ComponentArgs{this, "Node"}, Graph, dsp_id); }
+
+static FaustPolyMaNode *GetPolyMaNode(const std::unique_ptr<MaNode> &node) { return reinterpret_cast<FaustPolyMaNode *>(node.get()); }
+
+void FaustPolyNode::OnSampleRateChanged() {
+    AudioGraphNode::OnSampleRateChanged();
+    ma_faust_poly_node_set_sample_rate((ma_faust_poly_node *)Get(), Graph->SampleRate);
+}
+
+ID FaustPolyNode::GetDspId() const { return GetPolyMaNode(Node)->DspId; }
+void FaustPolyNode::SetDsp(TransientStore &s, ID id) { GetPolyMaNode(Node)->SetDsp(s, id); }
+// Voices are only swapped out by reinitializing the node, after which the audio thread no longer references them.
+bool FaustPolyNode::IsUsingDsp(const dsp *dsp) const {
+    return dsp && (GetPolyMaNode(Node)->Voices.Prototype == dsp || (BenchmarkResults.IsRunning() && BenchmarkPrototype == dsp));
+}
+
+void FaustPolyNode::NoteOn(u8 note, float velocity) const { ma_faust_poly_node_note_on((ma_faust_poly_node *)Get(), note, velocity); }
+void FaustPolyNode::NoteOff(u8 note) const { ma_faust_poly_node_note_off((ma_faust_poly_node *)Get(), note); }
+void FaustPolyNode::AllNotesOff() const { ma_faust_poly_node_all_notes_off((ma_faust_poly_node *)Get()); }
+
+void FaustPolyNode::BenchmarkVoices() const {
+    const auto *node = GetPolyMaNode(Node);
+    auto *prototype = node->Voices.Prototype;
+    if (!prototype || BenchmarkResults.IsRunning()) return;
+
+    // The worker's voices follow the clone's params, so it never reads the live prototype while the UI and audio threads use it.
+    std::shared_ptr<dsp> clone{prototype->clone()};
+    clone->instanceResetUserInterface();
+    CopyParamValues(*prototype, *clone);
+    BenchmarkPrototype = prototype;
+    BenchmarkResults.Start([clone = std::move(clone), voice_count = u32(node->VoiceCount), sample_rate = Graph->SampleRate]() mutable {
+        auto results = BenchmarkFaustPolyVoices(clone.get(), voice_count, sample_rate);
+        clone.reset(); // Delete the clone while the prototype (and its factory) is still reported as in use.
+        return results;
+    });
+}
+
+using namespace ImGui;
+
+void FaustPolyNode::RenderKeyboard() const {
+    static constexpr std::array<const char *, 12> NoteNames{"C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B"};
+    static constexpr u8 FirstNote = 48, OctaveCount = 2; // C3
+
+    const float key_width = GetFrameHeight() * 1.5f;
+    for (u8 octave = 0; octave < OctaveCount; octave++) {
+        for (u8 i = 0; i < 12; i++) {
+            const u8 note = FirstNote + octave * 12 + i;
+            const bool is_black_key = NoteNames[i][1] == '#';
+            if (i > 0) SameLine(0, 1);
+            if (is_black_key) PushStyleColor(ImGuiCol_Button, GetStyleColorVec4(ImGuiCol_FrameBg));
+            PushID(note);
+            Button(std::format("{}{}", NoteNames[i], note / 12 - 1).c_str(), {key_width, 0});
+            if (IsItemActivated()) NoteOn(note, GetPolyMaNode(Node)->Velocity);
+            if (IsItemDeactivated()) NoteOff(note);
+            PopID();
+            if (is_black_key) PopStyleColor();
+        }
+    }
+    if (Button("All notes off")) AllNotesOff();
+}
+
+void FaustPolyNode::RenderBenchmarkResults() const {
+    if (BenchmarkResults.IsRunning()) TextUnformatted("Benchmarking held note counts...");
+    const auto results = BenchmarkResults.Get();
+    if (!results || results->empty()) return;
+
+    if (BeginTable("Benchmark", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_SizingFixedFit)) {
+        TableSetupColumn("Held notes");
+        TableSetupColumn("Active voices");
+        TableSetupColumn("Compute per block");
+        TableSetupColumn("Block budget");
+        TableHeadersRow();
+        for (const auto &result : *results) {
+            TableNextRow();
+            TableNextColumn();
+            Text("%u", result.HeldNoteCount);
+            TableNextColumn();
+            Text("%u", result.ActiveVoiceCount);
+            TableNextColumn();
+            Text("%.2f us", result.ComputeNsPerBlock / 1000);
+            TableNextColumn();
+            Text("%.2f%%", result.BlockPercent);
+        }
+        EndTable();
+    }
+}
+
+void FaustPolyNode::Render() const {
+    const auto *node = GetPolyMaNode(Node);
+    node->VoiceCount.Draw();
+    node->SilenceThreshold.Draw();
+    Text("Active voices: %u/%u", ma_faust_poly_node_get_active_voice_count((ma_faust_poly_node *)Get()), ma_faust_poly_node_get_voice_count((ma_faust_poly_node *)Get()));
+    if (TreeNodeEx("Keyboard", ImGuiTreeNodeFlags_DefaultOpen)) {
+        node->Velocity.Draw();
+        RenderKeyboard();
+        TreePop();
+    }
+    if (TreeNode("Benchmark")) {
+        BeginDisabled(node->Voices.Prototype == nullptr || BenchmarkResults.IsRunning());
+        if (Button("Benchmark held note counts")) Graph->Q(Action::AudioGraph::BenchmarkFaustPolyNode{Id});
+        EndDisabled();
+        RenderBenchmarkResults();
+        TreePop();
+    }
+    Spacing();
+    AudioGraphNode::Render();
+}
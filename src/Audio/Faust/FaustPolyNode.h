@@ -0,0 +1,50 @@
+#pragma once
+
+// An audio graph node that plays notes on a fixed number of voices of a Faust DSP, mixing them into one output.
+// Follows Faust's polyphony conventions: Each voice's `freq`, `gate`, and `gain` params are controlled by the note it's playing,
+// and all of its other params follow the DSP's params.
+
+#include "Audio/Graph/AudioGraphNode.h"
+#include "Core/Helper/BackgroundResult.h"
+
+class dsp;
+
+struct FaustPolyBenchmarkResult {
+    u32 HeldNoteCount;
+    u32 ActiveVoiceCount; // Voices computed at the end of the benchmark.
+    float ComputeNsPerBlock;
+    float BlockPercent; // Compute time as a percentage of the block's duration.
+};
+
+// Headless benchmark: For each number of held notes (0, 1, 2, 4, ..., `voice_count`), measures the time to compute `block_count` blocks of
+// `block_frames` frames with `voice_count` voices cloned from the prototype, after a warm-up pass.
+std::vector<FaustPolyBenchmarkResult> BenchmarkFaustPolyVoices(dsp *prototype, u32 voice_count, u32 sample_rate, u32 block_frames = 512, u32 block_count = 1000);
+
+struct FaustPolyNode : AudioGraphNode {
+    FaustPolyNode(ComponentArgs &&, ID dsp_id = 0);
+
+    void OnSampleRateChanged() override;
+
+    ID GetDspId() const;
+    void SetDsp(TransientStore &, ID);
+    bool IsUsingDsp(const dsp *) const;
+
+    // Note events are queued, and handled by the audio thread at the start of its next block.
+    void NoteOn(u8 note, float velocity) const;
+    void NoteOff(u8 note) const;
+    void AllNotesOff() const;
+
+    // Runs `BenchmarkFaustPolyVoices` on a worker thread, against a clone of the current prototype. Does nothing if one is already running.
+    void BenchmarkVoices() const;
+
+private:
+    std::unique_ptr<MaNode> CreateNode(ID dsp_id = 0);
+
+    void Render() const override;
+    void RenderKeyboard() const;
+    void RenderBenchmarkResults() const;
+
+    // The DSP the running benchmark was cloned from. Reported as in use until the benchmark finishes, so its factory outlives the clone.
+    mutable const dsp *BenchmarkPrototype{nullptr};
+    mutable BackgroundResult<std::vector<FaustPolyBenchmarkResult>> BenchmarkResults;
+};
@@ -10,6 +10,7 @@
 
 #include "Core/CoreActionProducer.h"
 #include "Core/Helper/String.h"
+#include "Core/Profiler.h"
 #include "Core/Project/ProjectContext.h"
 #include "Core/String.h"
 #include "Core/UI/HelpMarker.h"
@@ -18,6 +19,7 @@
 
 #include "Audio/Device/AudioDevice.h"
 #include "Audio/Faust/FaustNode.h"
+#include "Audio/Faust/FaustPolyNode.h"
 #include "Audio/WaveformNode.h"
 
 #define ma_offset_ptr(p, offset) (((ma_uint8 *)(p)) + (offset))
@@ -272,6 +274,8 @@ struct InputDeviceNode : DeviceNode {
     // Adapted from `ma_device__handle_duplex_callback_capture`.
     static void AudioInputCallback(ma_device *device, void *output, const void *input, u32 frame_count) {
         auto *user_data = reinterpret_cast<AudioDevice::UserData *>(device->pUserData);
+        ProfileThreadRing(user_data->FlowGridDevice->ProfileRing);
+        ProfileZone("Audio input callback");
         const auto *self = reinterpret_cast<const InputDeviceNode *>(user_data->User);
         if (self->Get() == nullptr) {
             ma_silence_pcm_frames(output, frame_count, device->capture.internalFormat, device->capture.channels);
@@ -370,6 +374,8 @@ struct OutputDeviceNode : DeviceNode {
 
     static void AudioOutputCallback(ma_device *device, void *output, const void *input, u32 frame_count) {
         auto *user_data = reinterpret_cast<AudioDevice::UserData *>(device->pUserData);
+        ProfileThreadRing(user_data->FlowGridDevice->ProfileRing);
+        ProfileZone("Audio output callback");
         const auto *self = reinterpret_cast<const OutputDeviceNode *>(user_data->User);
         if (self->IsPrimary() && self->Graph) {
             ma_node_graph_read_pcm_frames(self->Graph->Get(), output, frame_count, nullptr);
@@ -500,6 +506,11 @@ std::unique_ptr<AudioGraphNode> AudioGraph::CreateAudioGraphNode(ComponentArgs &
         latest_dsp_id = 0;
         return node;
     }
+    if (args.PathSegment == FaustPolyNodeTypeId) {
+        auto node = CreateAudioGraphNode<FaustPolyNode>(graph, std::move(args), latest_dsp_id);
+        latest_dsp_id = 0;
+        return node;
+    }
 
     return nullptr;
 }
@@ -514,6 +525,10 @@ void AudioGraph::Apply(TransientStore &s, const ActionType &action) const {
                 latest_dsp_id = a.dsp_id;
                 Nodes.EmplaceBack(s, FaustNodeTypeId);
             },
+            [this, &s](const Action::AudioGraph::CreateFaustPolyNode &a) {
+                latest_dsp_id = a.dsp_id;
+                Nodes.EmplaceBack(s, FaustPolyNodeTypeId);
+            },
             [this, &s](const Action::AudioGraph::DeleteNode &a) {
                 Nodes.EraseId(s, a.id);
                 Connections.DisconnectOutput(s, a.id);
@@ -524,6 +539,13 @@ void AudioGraph::Apply(TransientStore &s, const ActionType &action) const {
                 auto *format = static_cast<const DeviceNode::DataFormat *>(Component::ById.at(a.id));
                 format->Set(s, {a.sample_format, a.channels, a.sample_rate});
             },
+            [](const Action::AudioGraph::BenchmarkFaustPolyNode &a) {
+                const auto it = Component::ById.find(a.id);
+                const auto *node = it != Component::ById.end() ? dynamic_cast<const FaustPolyNode *>(it->second) : nullptr;
+                if (!node) throw std::runtime_error(std::format("No Faust polyphonic node with id {} exists.", a.id));
+
+                node->BenchmarkVoices();
+            },
         },
         action
     );
@@ -572,20 +594,32 @@ u32 AudioGraph::GetBufferFrames() const {
     return 0;
 }
 
-void AudioGraph::OnFaustDspChanged(TransientStore &s, ID id, dsp *) {
+void AudioGraph::OnFaustDspChanged(TransientStore &s, ID id, dsp *dsp) {
+    if (dsp) DspById[id] = dsp;
+    else DspById.erase(id);
+
     for (auto &node : FindAllByPathSegment(FaustNodeTypeId)) {
         if (auto *faust_node = reinterpret_cast<FaustNode *>(node.get()); faust_node->GetDspId() == id) {
             faust_node->SetDsp(s, id);
         }
     }
+    for (auto &node : FindAllByPathSegment(FaustPolyNodeTypeId)) {
+        if (auto *faust_node = reinterpret_cast<FaustPolyNode *>(node.get()); faust_node->GetDspId() == id) {
+            faust_node->SetDsp(s, id);
+        }
+    }
 }
-void AudioGraph::OnFaustDspAdded(TransientStore &s, ID id, dsp *dsp) {
-    DspById[id] = dsp;
-    OnFaustDspChanged(s, id, dsp);
-}
-void AudioGraph::OnFaustDspRemoved(TransientStore &s, ID id) {
-    DspById.erase(id);
-    OnFaustDspChanged(s, id, nullptr);
+void AudioGraph::OnFaustDspAdded(TransientStore &s, ID id, dsp *dsp) { OnFaustDspChanged(s, id, dsp); }
+void AudioGraph::OnFaustDspRemoved(TransientStore &s, ID id) { OnFaustDspChanged(s, id, nullptr); }
+
+bool AudioGraph::IsFaustDspInUse(const dsp *dsp) const {
+    for (const auto &node : FindAllByPathSegment(FaustNodeTypeId)) {
+        if (reinterpret_cast<const FaustNode *>(node.get())->IsUsingDsp(dsp)) return true;
+    }
+    for (const auto &node : FindAllByPathSegment(FaustPolyNodeTypeId)) {
+        if (reinterpret_cast<const FaustPolyNode *>(node.get())->IsUsingDsp(dsp)) return true;
+    }
+    return false;
 }
 
 void AudioGraph::OnNodeConnectionsChanged(AudioGraphNode *) { UpdateConnections(_S); }
@@ -878,6 +912,8 @@ void AudioGraph::RenderNodeCreateSelector() const {
         if (!DspById.empty() && ImGui::TreeNode(FaustNodeTypeId.c_str())) {
             for (const auto &[id, _] : DspById) {
                 if (Button(std::to_string(id).c_str())) Q(Action::AudioGraph::CreateFaustNode{id});
+                SameLine();
+                if (Button(std::format("{} (polyphonic)", id).c_str())) Q(Action::AudioGraph::CreateFaustPolyNode{id});
             }
             TreePop();
         }
@@ -891,6 +927,7 @@ void AudioGraph::RenderNodeCreateSelector() const {
 
 void AudioGraph::Render() const {
     SampleRate.Render(AudioDevice::PrioritizedSampleRates);
+    FaustCrossfadeMs.Draw();
     AudioGraphNode::Render();
 
     if (SelectedNodeId != 0) {
@@ -19,7 +19,7 @@ using std::views::filter, std::views::transform;
 inline const std::string
     InputDeviceNodeTypeId = "Input",
     OutputDeviceNodeTypeId = "Output",
-    WaveformNodeTypeId = "Waveform", FaustNodeTypeId = "Faust";
+    WaveformNodeTypeId = "Waveform", FaustNodeTypeId = "Faust", FaustPolyNodeTypeId = "FaustPoly";
 
 struct AudioGraph : AudioGraphNode, ActionableProducer<Action::AudioGraph::Any>, FaustDSPListener, AudioGraphNode::Listener {
     AudioGraph(ProducerComponentArgs<ProducedActionType> &&);
@@ -44,6 +44,8 @@ struct AudioGraph : AudioGraphNode, ActionableProducer<Action::AudioGraph::Any>,
     void OnFaustDspChanged(TransientStore &, ID, dsp *) override;
     void OnFaustDspAdded(TransientStore &, ID, dsp *) override;
     void OnFaustDspRemoved(TransientStore &, ID) override;
+    bool IsFaustDspInUse(const dsp *) const override;
+    u32 GetFaustSampleRate() const override { return SampleRate; }
 
     void OnNodeConnectionsChanged(AudioGraphNode *) override;
 
@@ -126,6 +128,12 @@ struct AudioGraph : AudioGraphNode, ActionableProducer<Action::AudioGraph::Any>,
         [this](u32 sr) { return GetSampleRateName(sr); },
         176400
     );
+    Prop_(
+        Float, FaustCrossfadeMs,
+        "?When a Faust DSP is recompiled, nodes using it crossfade from the previous DSP to the new one over this duration (in milliseconds).\n"
+        "DSPs with different channel counts are always swapped immediately.",
+        20, 0, 500
+    );
     Prop(Style, Style);
 
     mutable ID SelectedNodeId{0}; // `Used for programatically navigating to nodes in the graph view.
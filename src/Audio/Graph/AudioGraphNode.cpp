@@ -8,7 +8,6 @@
 
 // Custom nodes.
 #include "ma_gainer_node/ma_gainer_node.h"
-#include "ma_monitor_node/fft_data.h"
 #include "ma_monitor_node/ma_monitor_node.h"
 #include "ma_monitor_node/window_functions.h"
 #include "ma_panner_node/ma_panner_node.h"
@@ -129,7 +128,7 @@ static WindowFunctionType GetWindowFunction(WindowType type) {
 AudioGraphNode::MonitorNode::MonitorNode(ComponentArgs &&args)
     : Component(std::move(args)), ParentNode(static_cast<AudioGraphNode *>(Parent->Parent)),
       Type(PathSegment.starts_with(to_string(IO_In)) ? IO_In : IO_Out) {
-    Component::References listening_to{WindowType, WindowLength};
+    Component::References listening_to{WindowType, WindowLength, SpectrumBins, SpectrumAveraging, PeakDecay};
     for (const auto &component : listening_to) RegisterChangeListener(this, component.get().Id);
 
     Monitor = std::make_unique<ma_monitor_node>();
@@ -142,11 +141,12 @@ AudioGraphNode::MonitorNode::~MonitorNode() {
 }
 
 void AudioGraphNode::MonitorNode::Init() {
-    auto config = ma_monitor_node_config_init(ParentNode->ChannelCount(Type, 0), WindowLength);
+    auto config = ma_monitor_node_config_init(ParentNode->ChannelCount(Type, 0), WindowLength, SpectrumBins);
     ma_result result = ma_monitor_node_init(ParentNode->Graph->Get(), &config, nullptr, Get());
     if (result != MA_SUCCESS) throw std::runtime_error(std::format("Failed to initialize monitor node: {}", int(result)));
 
     UpdateWindowType();
+    UpdateSpectrumSmoothing();
 }
 
 void AudioGraphNode::MonitorNode::Uninit() {
@@ -155,7 +155,8 @@ void AudioGraphNode::MonitorNode::Uninit() {
 
 void AudioGraphNode::MonitorNode::OnComponentChanged() {
     if (WindowType.IsChanged()) UpdateWindowType();
-    if (WindowLength.IsChanged()) UpdateWindowLength();
+    if (WindowLength.IsChanged() || SpectrumBins.IsChanged()) UpdateWindowLength();
+    if (SpectrumAveraging.IsChanged() || PeakDecay.IsChanged()) UpdateSpectrumSmoothing();
 }
 
 void AudioGraphNode::MonitorNode::UpdateWindowType() {
@@ -166,12 +167,17 @@ void AudioGraphNode::MonitorNode::UpdateWindowType() {
 }
 
 void AudioGraphNode::MonitorNode::UpdateWindowLength() {
-    // Recreate the monitor node to update the buffer size.
+    // Recreate the monitor node to update the buffer size (or the spectrum bins).
     Uninit();
     Init();
     ParentNode->NotifyConnectionsChanged();
 }
 
+void AudioGraphNode::MonitorNode::UpdateSpectrumSmoothing() {
+    ma_monitor_set_spectrum_averaging(Get(), SpectrumAveraging);
+    ma_monitor_set_spectrum_peak_decay(Get(), PeakDecay);
+}
+
 ma_monitor_node *AudioGraphNode::MonitorNode::Get() { return Monitor.get(); }
 
 std::string AudioGraphNode::MonitorNode::GetWindowLengthName(u32 window_length_frames) const {
@@ -182,54 +188,71 @@ void AudioGraphNode::MonitorNode::ApplyWindowFunction(WindowFunctionType window_
     ma_monitor_apply_window_function(Get(), window_function);
 }
 
+// Plotting costs scale with the plot's pixel width rather than the window length:
+// Each channel is decimated to the (min, max) sample pairs of each pixel column, drawn as a vertical zig-zag.
 void AudioGraphNode::MonitorNode::RenderWaveform() const {
     if (ImPlot::BeginPlot("Waveform", {-1, 160})) {
-        const auto N = Monitor->config.buffer_frames;
+        const u32 N = Monitor->config.buffer_frames;
         ImPlot::SetupAxes("Frame", "Value");
         ImPlot::SetupAxisLimits(ImAxis_X1, 0, N, ImGuiCond_Always);
         ImPlot::SetupAxisLimits(ImAxis_Y1, -1.1, 1.1, ImGuiCond_Always);
         if (ParentNode->IsActive) {
+            const u32 columns = std::clamp(u32(ImPlot::GetPlotSize().x), 1u, N);
+            const float frames_per_column = float(N) / float(columns);
+            static std::vector<float> frames, values;
+            frames.resize(columns * 2);
+            values.resize(columns * 2);
+            for (u32 column = 0; column < columns; column++) {
+                frames[column * 2] = frames[column * 2 + 1] = float(column) * frames_per_column;
+            }
+
+            ImPlot::PushStyleVar(ImPlotStyleVar_Marker, ImPlotMarker_None);
             for (u32 channel_index = 0; channel_index < Monitor->config.channels; channel_index++) {
+                const float *channel_buffer = Monitor->buffer + channel_index * N;
+                for (u32 column = 0; column < columns; column++) {
+                    const u32 begin = u32(float(column) * frames_per_column);
+                    const u32 end = std::max(begin + 1, std::min(N, u32(float(column + 1) * frames_per_column)));
+                    const auto [min_it, max_it] = std::minmax_element(channel_buffer + begin, channel_buffer + end);
+                    values[column * 2] = *min_it;
+                    values[column * 2 + 1] = *max_it;
+                }
                 const std::string channel_name = std::format("Channel {}", channel_index);
-                ImPlot::PushStyleVar(ImPlotStyleVar_Marker, ImPlotMarker_None);
-                ImPlot::PlotLine(channel_name.c_str(), Monitor->buffer, N);
-                ImPlot::PopStyleVar();
+                ImPlot::PlotLine(channel_name.c_str(), frames.data(), values.data(), columns * 2);
             }
+            ImPlot::PopStyleVar();
         }
         ImPlot::EndPlot();
     }
 }
 
+// The log-frequency bins, averaging, and peak hold are computed by the monitor node on the audio thread.
+// Here we only plot `spectrum_bins` points per channel.
 void AudioGraphNode::MonitorNode::RenderMagnitudeSpectrum() const {
     if (ImPlot::BeginPlot("Magnitude spectrum", {-1, 160})) {
-        static constexpr float MIN_DB = -100;
-        const fft_data *fft = Monitor->fft;
         const u32 N = Monitor->config.buffer_frames;
-        const u32 N_2 = N / 2;
+        const u32 bins = Monitor->config.spectrum_bins;
         const float fs = ParentNode->Graph->SampleRate;
         const float fs_n = fs / float(N);
 
-        static std::vector<float> frequency(N_2);
-        static std::vector<float> magnitude(N_2);
-        frequency.resize(N_2);
-        magnitude.resize(N_2);
-
-        const auto *data = fft->data; // Complex values.
-        for (u32 i = 0; i < N_2; i++) {
-            frequency[i] = fs_n * float(i);
-            const float mag_linear = sqrtf(data[i][0] * data[i][0] + data[i][1] * data[i][1]) / float(N_2);
-            magnitude[i] = ma_volume_linear_to_db(mag_linear);
+        static std::vector<float> frequency;
+        frequency.resize(bins);
+        for (u32 bin = 0; bin < bins; bin++) {
+            // Geometric center of the FFT bins covered by this spectrum bin.
+            frequency[bin] = fs_n * sqrtf(float(Monitor->spectrum_bin_starts[bin]) * float(Monitor->spectrum_bin_starts[bin + 1] - 1));
         }
 
-        ImPlot::SetupAxes("Frequency bin", "Magnitude (dB)");
-        ImPlot::SetupAxisLimits(ImAxis_X1, 0, fs / 2, ImGuiCond_Always);
-        ImPlot::SetupAxisLimits(ImAxis_Y1, MIN_DB, 0, ImGuiCond_Always);
+        ImPlot::SetupAxes("Frequency (Hz)", "Magnitude (dB)");
+        ImPlot::SetupAxisScale(ImAxis_X1, ImPlotScale_Log10);
+        ImPlot::SetupAxisLimits(ImAxis_X1, fs_n, fs / 2, ImGuiCond_Always);
+        ImPlot::SetupAxisLimits(ImAxis_Y1, MA_MONITOR_MIN_DB, 0, ImGuiCond_Always);
         if (ParentNode->IsActive) {
             ImPlot::PushStyleVar(ImPlotStyleVar_Marker, ImPlotMarker_None);
-            // ImPlot::PushStyleColor(ImPlotCol_Fill, {1.f, 0.f, 0.f, 1.f});
-            // todo per-channel
-            ImPlot::PlotShaded("1", frequency.data(), magnitude.data(), N_2, MIN_DB);
-            // ImPlot::PopStyleColor();
+            for (u32 channel_index = 0; channel_index < Monitor->config.channels; channel_index++) {
+                const std::string channel_name = std::format("Channel {}", channel_index);
+                ImPlot::PlotShaded(channel_name.c_str(), frequency.data(), Monitor->spectrum + channel_index * bins, bins, MA_MONITOR_MIN_DB);
+                const std::string peak_name = std::format("Channel {} peak", channel_index);
+                ImPlot::PlotLine(peak_name.c_str(), frequency.data(), Monitor->spectrum_peak + channel_index * bins, bins);
+            }
             ImPlot::PopStyleVar();
         }
         ImPlot::EndPlot();
@@ -237,11 +260,17 @@ void AudioGraphNode::MonitorNode::RenderMagnitudeSpectrum() const {
 }
 
 void AudioGraphNode::MonitorNode::Render() const {
-    static const std::vector<u32> WindowLengthOptions{256, 512, 1024, 2048, 4096, 8192, 16384};
+    static const std::vector<u32> WindowLengthOptions{256, 512, 1024, 2048, 4096, 8192, 16384, 32768};
     SetNextItemWidth(GetFontSize() * 9);
     WindowLength.Render(WindowLengthOptions);
     SetNextItemWidth(GetFontSize() * 9);
     WindowType.Draw();
+    SetNextItemWidth(GetFontSize() * 9);
+    SpectrumBins.Draw();
+    SetNextItemWidth(GetFontSize() * 9);
+    SpectrumAveraging.Draw();
+    SetNextItemWidth(GetFontSize() * 9);
+    PeakDecay.Draw();
     RenderWaveform();
     RenderMagnitudeSpectrum();
 }
@@ -186,6 +186,7 @@ struct AudioGraphNode : Component, ChangeListener {
 
         void UpdateWindowType();
         void UpdateWindowLength();
+        void UpdateSpectrumSmoothing();
 
         void ApplyWindowFunction(WindowFunctionType);
 
@@ -203,6 +204,9 @@ struct AudioGraphNode : Component, ChangeListener {
             {"Rectangular", "Hann", "Hamming", "Blackman", "Blackman-Harris", "Nuttall", "Flat-Top", "Triangular", "Bartlett", "Bartlett-Hann", "Bohman", "Parzen"},
             WindowType_BlackmanHarris
         );
+        Prop_(UInt, SpectrumBins, "?The number of logarithmically-spaced frequency bins in the magnitude spectrum.", 128, 16, 1024);
+        Prop_(Float, SpectrumAveraging, "?How much each magnitude spectrum update is averaged with the previous one.\nZero disables averaging.", 0.5, 0, 0.99);
+        Prop_(Float, PeakDecay, "?How many dB the held magnitude spectrum peaks fall each window.\nZero holds peaks indefinitely.", 0.5, 0, 6);
 
     private:
         void Render() const override;
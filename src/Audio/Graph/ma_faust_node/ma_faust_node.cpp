@@ -32,48 +32,122 @@ ma_uint32 ma_faust_node_get_sample_rate(ma_faust_node *faust_node) {
 ma_result ma_faust_node_set_sample_rate(ma_faust_node *faust_node, ma_uint32 sample_rate) {
     if (faust_node == nullptr) return MA_INVALID_ARGS;
 
+    faust_node->config.sample_rate = sample_rate;
     if (faust_node->config.faust_dsp != nullptr) faust_node->config.faust_dsp->init(sample_rate);
     return MA_SUCCESS;
 }
 
 ma_result ma_faust_node_set_dsp(ma_faust_node *faust_node, dsp *faust_dsp) {
-    if (faust_node == nullptr) return MA_INVALID_ARGS;
+    if (faust_node == nullptr || faust_dsp == nullptr) return MA_INVALID_ARGS;
     // Reinitialize the node if the channel count has changed.
     if (ma_faust_node_get_in_channels(faust_node) != ma_uint32(faust_dsp->getNumInputs()) ||
         ma_faust_node_get_out_channels(faust_node) != ma_uint32(faust_dsp->getNumOutputs())) return MA_INVALID_ARGS;
 
     faust_node->config.faust_dsp = faust_dsp;
+    faust_node->pending_dsp.store(faust_dsp);
+    return MA_SUCCESS;
+}
+
+ma_result ma_faust_node_set_crossfade_frames(ma_faust_node *faust_node, ma_uint32 crossfade_frames) {
+    if (faust_node == nullptr) return MA_INVALID_ARGS;
+
+    faust_node->crossfade_frames.store(crossfade_frames);
     return MA_SUCCESS;
 }
 
+ma_bool32 ma_faust_node_is_using_dsp(ma_faust_node *faust_node, const dsp *faust_dsp) {
+    if (faust_node == nullptr || faust_dsp == nullptr) return MA_FALSE;
+
+    // The DSP pointers are only a consistent snapshot if no process callback started or finished while reading them.
+    const ma_uint32 sequence = faust_node->process_sequence.load();
+    if (sequence % 2 == 1) return MA_TRUE;
+
+    const bool is_using = faust_dsp == faust_node->config.faust_dsp || faust_dsp == faust_node->pending_dsp.load() ||
+        faust_dsp == faust_node->processing_dsp.load() || faust_dsp == faust_node->fading_dsp.load();
+    return is_using || faust_node->process_sequence.load() != sequence;
+}
+
+// Take the pending DSP, if any, moving the processing DSP to the fading slot.
+// A new swap waits for any crossfade in progress to complete.
+static void ma_faust_node_take_pending_dsp(ma_faust_node *faust_node) {
+    if (faust_node->fading_dsp.load() != nullptr) return;
+
+    dsp *pending_dsp = faust_node->pending_dsp.exchange(nullptr);
+    if (pending_dsp == nullptr) return;
+
+    dsp *processing_dsp = faust_node->processing_dsp.load();
+    if (processing_dsp != nullptr && processing_dsp != pending_dsp && faust_node->crossfade_frames.load() > 0) {
+        faust_node->crossfade_cursor = 0;
+        faust_node->fading_dsp.store(processing_dsp);
+    }
+    faust_node->processing_dsp.store(pending_dsp);
+}
+
+// Mix the fading DSP's output into `frames_out` with a linear gain ramp, ending the crossfade once it reaches zero.
+static void ma_faust_node_crossfade(ma_faust_node *faust_node, ma_uint32 frame_count, float **frames_out, ma_uint32 out_channels) {
+    const float crossfade_frames = float(ma_max(faust_node->crossfade_frames.load(), 1u));
+    for (ma_uint32 channel = 0; channel < out_channels; ++channel) {
+        float *out = frames_out[channel];
+        const float *fade = faust_node->fade_buffer[channel];
+        for (ma_uint32 i = 0; i < frame_count; ++i) {
+            const float gain = ma_min(float(faust_node->crossfade_cursor + i) / crossfade_frames, 1.f);
+            out[i] = out[i] * gain + fade[i] * (1 - gain);
+        }
+    }
+    faust_node->crossfade_cursor += frame_count;
+    if (float(faust_node->crossfade_cursor) >= crossfade_frames) faust_node->fading_dsp.store(nullptr);
+}
+
 static void ma_faust_node_process_pcm_frames(ma_node *node, const float **const_frames_in, ma_uint32 *frame_count_in, float **frames_out, ma_uint32 *frame_count_out) {
     auto *faust_node = (ma_faust_node *)node;
-    if (!faust_node->config.faust_dsp) return;
+    faust_node->process_sequence.fetch_add(1);
+    ma_faust_node_take_pending_dsp(faust_node);
 
-    auto *dsp = faust_node->config.faust_dsp;
-    float **frames_in = const_cast<float **>(const_frames_in); // Faust `compute` expects a non-const buffer: https://github.com/grame-cncm/faust/pull/850
-    ma_uint32 in_channels = ma_faust_node_get_in_channels(faust_node);
-    ma_uint32 out_channels = ma_faust_node_get_out_channels(faust_node);
+    if (auto *dsp = faust_node->processing_dsp.load()) {
+        float **frames_in = const_cast<float **>(const_frames_in); // Faust `compute` expects a non-const buffer: https://github.com/grame-cncm/faust/pull/850
+        const ma_uint32 in_channels = ma_faust_node_get_in_channels(faust_node);
+        const ma_uint32 out_channels = ma_faust_node_get_out_channels(faust_node);
+        const ma_uint32 frame_count = *frame_count_out;
 
-    if (in_channels <= 1 && out_channels <= 1) {
-        // No multichannel.
-        dsp->compute(*frame_count_out, frames_in, frames_out);
-    } else if (in_channels <= 1) {
-        // Multi output.
-        dsp->compute(*frame_count_out, frames_in, faust_node->out_buffer);
-        ma_interleave_pcm_frames(ma_format_f32, out_channels, *frame_count_out, (const void **)faust_node->out_buffer, frames_out[0]);
-    } else if (out_channels <= 1) {
-        // Multi input.
-        ma_deinterleave_pcm_frames(ma_format_f32, in_channels, *frame_count_in, const_frames_in[0], (void **)faust_node->in_buffer);
-        dsp->compute(*frame_count_out, faust_node->in_buffer, frames_out);
-    } else {
-        // Multi input/output.
-        ma_deinterleave_pcm_frames(ma_format_f32, in_channels, *frame_count_in, const_frames_in[0], (void **)faust_node->in_buffer);
-        dsp->compute(*frame_count_out, faust_node->in_buffer, faust_node->out_buffer);
-        ma_interleave_pcm_frames(ma_format_f32, out_channels, *frame_count_out, (const void **)faust_node->out_buffer, frames_out[0]);
+        // Multichannel input/output is deinterleaved into/from the node's buffers.
+        float **inputs = frames_in;
+        if (in_channels > 1) {
+            ma_deinterleave_pcm_frames(ma_format_f32, in_channels, *frame_count_in, const_frames_in[0], (void **)faust_node->in_buffer);
+            inputs = faust_node->in_buffer;
+        }
+        float **outputs = out_channels > 1 ? faust_node->out_buffer : frames_out;
+
+        dsp->compute(frame_count, inputs, outputs);
+        if (auto *fading_dsp = faust_node->fading_dsp.load()) {
+            fading_dsp->compute(frame_count, inputs, faust_node->fade_buffer);
+            ma_faust_node_crossfade(faust_node, frame_count, outputs, out_channels);
+        }
+
+        if (out_channels > 1) {
+            ma_interleave_pcm_frames(ma_format_f32, out_channels, frame_count, (const void **)faust_node->out_buffer, frames_out[0]);
+        }
+    }
+
+    faust_node->process_sequence.fetch_add(1);
+}
+
+static float **allocate_deinterleaved_buffer(ma_uint32 channels, ma_uint32 frames, const ma_allocation_callbacks *allocation_callbacks) {
+    auto **buffer = (float **)ma_malloc(channels * sizeof(float *), allocation_callbacks);
+    if (buffer == nullptr) return nullptr;
+
+    for (ma_uint32 channel = 0; channel < channels; ++channel) {
+        buffer[channel] = (float *)ma_malloc(frames * ma_get_bytes_per_frame(ma_format_f32, 1), allocation_callbacks);
+        if (buffer[channel] == nullptr) return nullptr;
+        ma_silence_pcm_frames(buffer[channel], frames, ma_format_f32, 1);
     }
+    return buffer;
+}
+
+static void free_deinterleaved_buffer(float **buffer, ma_uint32 channels, const ma_allocation_callbacks *allocation_callbacks) {
+    if (buffer == nullptr) return;
 
-    (void)frame_count_in;
+    for (ma_uint32 channel = 0; channel < channels; ++channel) ma_free(buffer[channel], allocation_callbacks);
+    ma_free(buffer, allocation_callbacks);
 }
 
 ma_result ma_faust_node_init(ma_node_graph *node_graph, const ma_faust_node_config *config, const ma_allocation_callbacks *allocation_callbacks, ma_faust_node *faust_node) {
@@ -89,24 +163,18 @@ ma_result ma_faust_node_init(ma_node_graph *node_graph, const ma_faust_node_conf
 
     ma_uint32 in_channels = ma_faust_node_get_in_channels(faust_node);
     ma_uint32 out_channels = ma_faust_node_get_out_channels(faust_node);
-    if (in_channels > 1 || out_channels > 1) {
-        const ma_uint32 N = faust_node->config.buffer_frames;
-        if (in_channels > 1) {
-            faust_node->in_buffer = (float **)ma_malloc(N * sizeof(float *), allocation_callbacks);
-            for (ma_uint32 channel = 0; channel < in_channels; ++channel) {
-                faust_node->in_buffer[channel] = (float *)ma_malloc(N * ma_get_bytes_per_frame(ma_format_f32, 1), allocation_callbacks);
-                if (faust_node->in_buffer[channel] == nullptr) return MA_OUT_OF_MEMORY;
-                ma_silence_pcm_frames(faust_node->in_buffer[channel], N, ma_format_f32, 1);
-            }
-        }
-        if (out_channels > 1) {
-            faust_node->out_buffer = (float **)ma_malloc(N * sizeof(float *), allocation_callbacks);
-            for (ma_uint32 channel = 0; channel < out_channels; ++channel) {
-                faust_node->out_buffer[channel] = (float *)ma_malloc(N * ma_get_bytes_per_frame(ma_format_f32, 1), allocation_callbacks);
-                if (faust_node->out_buffer[channel] == nullptr) return MA_OUT_OF_MEMORY;
-                ma_silence_pcm_frames(faust_node->out_buffer[channel], N, ma_format_f32, 1);
-            }
-        }
+    const ma_uint32 N = faust_node->config.buffer_frames;
+    if (in_channels > 1) {
+        faust_node->in_buffer = allocate_deinterleaved_buffer(in_channels, N, allocation_callbacks);
+        if (faust_node->in_buffer == nullptr) return MA_OUT_OF_MEMORY;
+    }
+    if (out_channels > 1) {
+        faust_node->out_buffer = allocate_deinterleaved_buffer(out_channels, N, allocation_callbacks);
+        if (faust_node->out_buffer == nullptr) return MA_OUT_OF_MEMORY;
+    }
+    if (dsp && out_channels > 0) {
+        faust_node->fade_buffer = allocate_deinterleaved_buffer(out_channels, N, allocation_callbacks);
+        if (faust_node->fade_buffer == nullptr) return MA_OUT_OF_MEMORY;
     }
 
     ma_node_config base_config = config->node_config;
@@ -117,21 +185,21 @@ ma_result ma_faust_node_init(ma_node_graph *node_graph, const ma_faust_node_conf
     base_config.pOutputChannels = out_channels > 0 ? &out_channels : nullptr;
 
     if (dsp) dsp->init(faust_node->config.sample_rate);
+    faust_node->processing_dsp.store(dsp);
     return ma_node_init(node_graph, &base_config, allocation_callbacks, &faust_node->base);
 }
 
 void ma_faust_node_uninit(ma_faust_node *faust_node, const ma_allocation_callbacks *allocation_callbacks) {
-    if (ma_uint32 in_channels = ma_faust_node_get_in_channels(faust_node); in_channels > 1) {
-        for (ma_uint32 channel = 0; channel < ma_faust_node_get_in_channels(faust_node); ++channel) {
-            ma_free(faust_node->in_buffer[channel], allocation_callbacks);
-        }
-        ma_free(faust_node->in_buffer, allocation_callbacks);
-    }
-    if (ma_uint32 out_channels = ma_faust_node_get_out_channels(faust_node); out_channels > 1) {
-        for (ma_uint32 channel = 0; channel < ma_faust_node_get_out_channels(faust_node); ++channel) {
-            ma_free(faust_node->out_buffer[channel], allocation_callbacks);
-        }
-        ma_free(faust_node->out_buffer, allocation_callbacks);
-    }
+    // Uninitialize the node first, so the audio thread is no longer processing it when its buffers are freed.
     ma_node_uninit(&faust_node->base, allocation_callbacks);
+
+    const ma_uint32 in_channels = ma_faust_node_get_in_channels(faust_node);
+    const ma_uint32 out_channels = ma_faust_node_get_out_channels(faust_node);
+    if (in_channels > 1) free_deinterleaved_buffer(faust_node->in_buffer, in_channels, allocation_callbacks);
+    if (out_channels > 1) free_deinterleaved_buffer(faust_node->out_buffer, out_channels, allocation_callbacks);
+    free_deinterleaved_buffer(faust_node->fade_buffer, out_channels, allocation_callbacks);
+    faust_node->in_buffer = faust_node->out_buffer = faust_node->fade_buffer = nullptr;
+    faust_node->pending_dsp.store(nullptr);
+    faust_node->processing_dsp.store(nullptr);
+    faust_node->fading_dsp.store(nullptr);
 }
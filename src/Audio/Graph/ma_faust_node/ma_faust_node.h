@@ -2,6 +2,8 @@
 
 #include "miniaudio.h"
 
+#include <atomic>
+
 class dsp;
 
 struct ma_faust_node_config {
@@ -15,10 +17,25 @@ ma_faust_node_config ma_faust_node_config_init(dsp *, ma_uint32 sample_rate, ma_
 
 struct ma_faust_node {
     ma_node_base base;
-    ma_faust_node_config config;
+    ma_faust_node_config config; // `config.faust_dsp` is the most recently set DSP, which may not be processing yet.
     // These deinterleaved buffers are only created if the respective direction of the Faust node is multi-channel.
     float **in_buffer;
     float **out_buffer;
+
+    // DSPs with the same channel counts are hot-swapped by crossfading from the old DSP to the new one on the audio thread.
+    // * `ma_faust_node_set_dsp` publishes the new DSP to `pending_dsp`.
+    // * At the start of the next block (after any crossfade in progress), the audio thread moves the processing DSP to `fading_dsp`
+    //   and starts processing `pending_dsp`, mixing in the output of `fading_dsp` with a linearly decreasing gain over `crossfade_frames`.
+    // * Once the crossfade completes, the audio thread clears `fading_dsp`.
+    // DSPs are owned by the caller, which must not delete a swapped-out DSP until `ma_faust_node_is_using_dsp` returns false.
+    std::atomic<dsp *> pending_dsp;
+    std::atomic<dsp *> processing_dsp; // Only written on the audio thread (and during init).
+    std::atomic<dsp *> fading_dsp;
+    float **fade_buffer; // Deinterleaved output of `fading_dsp`.
+    std::atomic<ma_uint32> crossfade_frames;
+    ma_uint32 crossfade_cursor;
+    // Incremented at the start and end of each process callback, so it's odd while the audio thread is processing.
+    std::atomic<ma_uint32> process_sequence;
 };
 
 ma_result ma_faust_node_init(ma_node_graph *, const ma_faust_node_config *, const ma_allocation_callbacks *, ma_faust_node *);
@@ -33,4 +50,9 @@ ma_uint32 ma_faust_node_get_sample_rate(ma_faust_node *);
 dsp *ma_faust_node_get_dsp(ma_faust_node *);
 
 ma_result ma_faust_node_set_sample_rate(ma_faust_node *, ma_uint32 sample_rate);
+// Swap to a DSP with the same channel counts. The new DSP should already be initialized.
+// The swap happens on the audio thread at the start of the next block, crossfading over `crossfade_frames`.
 ma_result ma_faust_node_set_dsp(ma_faust_node *, dsp *);
+ma_result ma_faust_node_set_crossfade_frames(ma_faust_node *, ma_uint32 crossfade_frames);
+// Returns true if the audio thread may still be referencing the DSP.
+ma_bool32 ma_faust_node_is_using_dsp(ma_faust_node *, const dsp *);
@@ -0,0 +1,325 @@
+#include "ma_faust_poly_node.h"
+
+#include "../ma_helper.h"
+
+#include <cmath>
+
+#ifndef FAUSTFLOAT
+#define FAUSTFLOAT float
+#endif
+
+#include "faust/dsp/dsp.h"
+
+ma_faust_poly_node_config ma_faust_poly_node_config_init(const ma_faust_poly_voice_config *voices, ma_uint32 voice_count, ma_uint32 sample_rate, ma_uint32 buffer_frames) {
+    ma_faust_poly_node_config config;
+    config.node_config = ma_node_config_init();
+    config.voices = voices;
+    config.voice_count = voices != nullptr ? voice_count : 0;
+    config.sample_rate = sample_rate;
+    config.buffer_frames = buffer_frames;
+    config.silence_threshold = 0.0001f; // -80 dB
+    config.silence_hold_frames = sample_rate / 20; // 50 ms
+
+    return config;
+}
+
+ma_uint32 ma_faust_poly_node_get_voice_count(ma_faust_poly_node *poly_node) { return poly_node->config.voice_count; }
+ma_uint32 ma_faust_poly_node_get_active_voice_count(ma_faust_poly_node *poly_node) { return poly_node->active_voice_count.load(); }
+ma_uint32 ma_faust_poly_node_get_sample_rate(ma_faust_poly_node *poly_node) { return poly_node->config.sample_rate; }
+
+ma_bool32 ma_faust_poly_node_has_dsp(ma_faust_poly_node *poly_node, const dsp *faust_dsp) {
+    if (poly_node == nullptr || faust_dsp == nullptr) return MA_FALSE;
+
+    for (ma_uint32 i = 0; i < poly_node->config.voice_count; ++i) {
+        if (poly_node->voices[i].config.faust_dsp == faust_dsp) return MA_TRUE;
+    }
+    return MA_FALSE;
+}
+
+ma_result ma_faust_poly_node_set_sample_rate(ma_faust_poly_node *poly_node, ma_uint32 sample_rate) {
+    if (poly_node == nullptr) return MA_INVALID_ARGS;
+
+    // Keep the same silence hold duration.
+    poly_node->config.silence_hold_frames = ma_uint32(ma_uint64(poly_node->config.silence_hold_frames) * sample_rate / ma_max(poly_node->config.sample_rate, 1u));
+    poly_node->config.sample_rate = sample_rate;
+    for (ma_uint32 i = 0; i < poly_node->config.voice_count; ++i) poly_node->voices[i].config.faust_dsp->init(sample_rate);
+    // Initializing resets the voices' gates, so release their notes to match.
+    return ma_faust_poly_node_all_notes_off(poly_node);
+}
+
+ma_result ma_faust_poly_node_set_silence_threshold(ma_faust_poly_node *poly_node, float silence_threshold) {
+    if (poly_node == nullptr) return MA_INVALID_ARGS;
+
+    poly_node->silence_threshold.store(silence_threshold);
+    return MA_SUCCESS;
+}
+
+ma_result ma_faust_poly_node_push_event(ma_faust_poly_node *poly_node, ma_faust_poly_event event) {
+    if (poly_node == nullptr) return MA_INVALID_ARGS;
+
+    const ma_uint32 write_index = poly_node->event_write_index.load();
+    if (write_index - poly_node->event_read_index.load() >= MA_FAUST_POLY_EVENT_QUEUE_CAPACITY) return MA_NO_SPACE;
+
+    poly_node->events[write_index % MA_FAUST_POLY_EVENT_QUEUE_CAPACITY] = event;
+    poly_node->event_write_index.store(write_index + 1);
+    return MA_SUCCESS;
+}
+
+ma_result ma_faust_poly_node_note_on(ma_faust_poly_node *poly_node, ma_uint8 note, float velocity) {
+    return ma_faust_poly_node_push_event(poly_node, {ma_faust_poly_event_type_note_on, note, velocity});
+}
+ma_result ma_faust_poly_node_note_off(ma_faust_poly_node *poly_node, ma_uint8 note) {
+    return ma_faust_poly_node_push_event(poly_node, {ma_faust_poly_event_type_note_off, note, 0});
+}
+ma_result ma_faust_poly_node_all_notes_off(ma_faust_poly_node *poly_node) {
+    return ma_faust_poly_node_push_event(poly_node, {ma_faust_poly_event_type_all_notes_off, 0, 0});
+}
+
+static void ma_faust_poly_voice_set_gate(ma_faust_poly_voice *voice, bool is_open) {
+    if (voice->config.gate_zone != nullptr) *voice->config.gate_zone = is_open ? 1 : 0;
+}
+
+static void ma_faust_poly_voice_release(ma_faust_poly_voice *voice) {
+    voice->is_held = MA_FALSE;
+    voice->is_retriggering = MA_FALSE;
+    ma_faust_poly_voice_set_gate(voice, false);
+    // Without a gate, the voice can't fade out, so it's stopped right away.
+    if (voice->config.gate_zone == nullptr) {
+        voice->is_active = MA_FALSE;
+        voice->note = -1;
+    }
+}
+
+// Returns a free voice if there is one.
+// Otherwise, steals the oldest released (still sounding) voice, or the oldest held voice if all voices are held.
+static ma_faust_poly_voice *ma_faust_poly_node_allocate_voice(ma_faust_poly_node *poly_node) {
+    ma_faust_poly_voice *oldest_released = nullptr, *oldest_held = nullptr;
+    for (ma_uint32 i = 0; i < poly_node->config.voice_count; ++i) {
+        auto *voice = &poly_node->voices[i];
+        if (!voice->is_active) return voice;
+
+        auto *&oldest = voice->is_held ? oldest_held : oldest_released;
+        if (oldest == nullptr || voice->note_on_index < oldest->note_on_index) oldest = voice;
+    }
+    return oldest_released != nullptr ? oldest_released : oldest_held;
+}
+
+static void ma_faust_poly_node_note_on_voice(ma_faust_poly_node *poly_node, ma_uint8 note, float velocity) {
+    // Retrigger a voice already holding this note, rather than allocating another voice for it.
+    ma_faust_poly_voice *voice = nullptr;
+    for (ma_uint32 i = 0; i < poly_node->config.voice_count && voice == nullptr; ++i) {
+        if (poly_node->voices[i].is_held && poly_node->voices[i].note == note) voice = &poly_node->voices[i];
+    }
+    if (voice == nullptr) voice = ma_faust_poly_node_allocate_voice(poly_node);
+    if (voice == nullptr) return;
+
+    if (voice->config.freq_zone != nullptr) *voice->config.freq_zone = 440.f * std::exp2((float(note) - 69.f) / 12.f);
+    if (voice->config.gain_zone != nullptr) *voice->config.gain_zone = velocity;
+    // A held voice's gate is already open, so it needs to be closed for a frame for its envelope to retrigger.
+    if (voice->is_held) voice->is_retriggering = MA_TRUE;
+    else ma_faust_poly_voice_set_gate(voice, true);
+
+    voice->note = note;
+    voice->is_active = MA_TRUE;
+    voice->is_held = MA_TRUE;
+    voice->note_on_index = poly_node->note_on_count++;
+    voice->silent_frames = 0;
+}
+
+static void ma_faust_poly_node_process_events(ma_faust_poly_node *poly_node) {
+    const ma_uint32 write_index = poly_node->event_write_index.load();
+    ma_uint32 read_index = poly_node->event_read_index.load();
+    for (; read_index != write_index; ++read_index) {
+        const auto &event = poly_node->events[read_index % MA_FAUST_POLY_EVENT_QUEUE_CAPACITY];
+        switch (event.type) {
+            case ma_faust_poly_event_type_note_on:
+                ma_faust_poly_node_note_on_voice(poly_node, event.note, event.velocity);
+                break;
+            case ma_faust_poly_event_type_note_off:
+                for (ma_uint32 i = 0; i < poly_node->config.voice_count; ++i) {
+                    auto *voice = &poly_node->voices[i];
+                    if (voice->is_held && voice->note == event.note) ma_faust_poly_voice_release(voice);
+                }
+                break;
+            case ma_faust_poly_event_type_all_notes_off:
+                for (ma_uint32 i = 0; i < poly_node->config.voice_count; ++i) {
+                    if (poly_node->voices[i].is_held) ma_faust_poly_voice_release(&poly_node->voices[i]);
+                }
+                break;
+        }
+    }
+    poly_node->event_read_index.store(read_index);
+}
+
+// Compute the voice into `voice_buffer`, and add it to `mix_buffer`.
+static void ma_faust_poly_node_compute_voice(ma_faust_poly_node *poly_node, ma_faust_poly_voice *voice, ma_uint32 frame_count, float **inputs) {
+    auto *faust_dsp = voice->config.faust_dsp;
+    float **outputs = poly_node->voice_buffer;
+    if (voice->is_retriggering && frame_count > 1) {
+        ma_faust_poly_voice_set_gate(voice, false);
+        faust_dsp->compute(1, inputs, outputs);
+        ma_faust_poly_voice_set_gate(voice, true);
+        for (ma_uint32 channel = 0; channel < poly_node->in_channels; ++channel) poly_node->voice_in_offset[channel] = inputs[channel] + 1;
+        for (ma_uint32 channel = 0; channel < poly_node->out_channels; ++channel) poly_node->voice_out_offset[channel] = outputs[channel] + 1;
+        faust_dsp->compute(int(frame_count - 1), poly_node->voice_in_offset, poly_node->voice_out_offset);
+        voice->is_retriggering = MA_FALSE;
+    } else {
+        faust_dsp->compute(int(frame_count), inputs, outputs);
+    }
+
+    float peak = 0;
+    for (ma_uint32 channel = 0; channel < poly_node->out_channels; ++channel) {
+        float *mix = poly_node->mix_buffer[channel];
+        const float *out = outputs[channel];
+        for (ma_uint32 i = 0; i < frame_count; ++i) {
+            mix[i] += out[i];
+            peak = ma_max(peak, std::abs(out[i]));
+        }
+    }
+
+    if (voice->is_held || peak >= poly_node->silence_threshold.load()) {
+        voice->silent_frames = 0;
+    } else {
+        voice->silent_frames += frame_count;
+        if (voice->silent_frames >= poly_node->config.silence_hold_frames) {
+            voice->is_active = MA_FALSE;
+            voice->note = -1;
+        }
+    }
+}
+
+static void ma_faust_poly_node_process_pcm_frames(ma_node *node, const float **frames_in, ma_uint32 *frame_count_in, float **frames_out, ma_uint32 *frame_count_out) {
+    (void)frame_count_in;
+    auto *poly_node = (ma_faust_poly_node *)node;
+    if (poly_node->config.voice_count == 0) {
+        ma_silence_pcm_frames(frames_out[0], *frame_count_out, ma_format_f32, poly_node->out_channels);
+        return;
+    }
+
+    ma_faust_poly_node_process_events(poly_node);
+
+    const ma_uint32 in_channels = poly_node->in_channels, out_channels = poly_node->out_channels;
+    const ma_uint32 frame_count = *frame_count_out;
+    for (ma_uint32 offset = 0; offset < frame_count;) {
+        const ma_uint32 block_frames = ma_min(frame_count - offset, poly_node->block_frames);
+        if (in_channels > 0) {
+            ma_deinterleave_pcm_frames(ma_format_f32, in_channels, block_frames, frames_in[0] + offset * in_channels, (void **)poly_node->in_buffer);
+        }
+        for (ma_uint32 channel = 0; channel < out_channels; ++channel) ma_silence_pcm_frames(poly_node->mix_buffer[channel], block_frames, ma_format_f32, 1);
+
+        for (ma_uint32 i = 0; i < poly_node->config.voice_count; ++i) {
+            auto *voice = &poly_node->voices[i];
+            if (voice->is_active) ma_faust_poly_node_compute_voice(poly_node, voice, block_frames, poly_node->in_buffer);
+        }
+
+        ma_interleave_pcm_frames(ma_format_f32, out_channels, block_frames, (const void **)poly_node->mix_buffer, frames_out[0] + offset * out_channels);
+        offset += block_frames;
+    }
+
+    ma_uint32 active_voice_count = 0;
+    for (ma_uint32 i = 0; i < poly_node->config.voice_count; ++i) active_voice_count += poly_node->voices[i].is_active ? 1 : 0;
+    poly_node->active_voice_count.store(active_voice_count);
+}
+
+static void free_deinterleaved_buffer(float **buffer, ma_uint32 channels, const ma_allocation_callbacks *allocation_callbacks) {
+    if (buffer == nullptr) return;
+
+    for (ma_uint32 channel = 0; channel < channels; ++channel) ma_free(buffer[channel], allocation_callbacks);
+    ma_free(buffer, allocation_callbacks);
+}
+
+static float **allocate_deinterleaved_buffer(ma_uint32 channels, ma_uint32 frames, const ma_allocation_callbacks *allocation_callbacks) {
+    auto **buffer = (float **)ma_calloc(channels * sizeof(float *), allocation_callbacks);
+    if (buffer == nullptr) return nullptr;
+
+    for (ma_uint32 channel = 0; channel < channels; ++channel) {
+        buffer[channel] = (float *)ma_malloc(frames * ma_get_bytes_per_frame(ma_format_f32, 1), allocation_callbacks);
+        if (buffer[channel] == nullptr) {
+            free_deinterleaved_buffer(buffer, channels, allocation_callbacks);
+            return nullptr;
+        }
+        ma_silence_pcm_frames(buffer[channel], frames, ma_format_f32, 1);
+    }
+    return buffer;
+}
+
+static void ma_faust_poly_node_free(ma_faust_poly_node *poly_node, const ma_allocation_callbacks *allocation_callbacks) {
+    free_deinterleaved_buffer(poly_node->in_buffer, poly_node->in_channels, allocation_callbacks);
+    free_deinterleaved_buffer(poly_node->voice_buffer, poly_node->out_channels, allocation_callbacks);
+    free_deinterleaved_buffer(poly_node->mix_buffer, poly_node->out_channels, allocation_callbacks);
+    ma_free(poly_node->voice_in_offset, allocation_callbacks);
+    ma_free(poly_node->voice_out_offset, allocation_callbacks);
+    ma_free(poly_node->voices, allocation_callbacks);
+    poly_node->in_buffer = poly_node->voice_buffer = poly_node->mix_buffer = nullptr;
+    poly_node->voice_in_offset = poly_node->voice_out_offset = nullptr;
+    poly_node->voices = nullptr;
+}
+
+ma_result ma_faust_poly_node_init(ma_node_graph *node_graph, const ma_faust_poly_node_config *config, const ma_allocation_callbacks *allocation_callbacks, ma_faust_poly_node *poly_node) {
+    if (poly_node == nullptr || config == nullptr) return MA_INVALID_ARGS;
+
+    MA_ZERO_OBJECT(poly_node);
+    poly_node->config = *config;
+    poly_node->config.voices = nullptr; // Voice configs are copied into `voices`.
+    poly_node->silence_threshold.store(config->silence_threshold);
+
+    const ma_uint32 voice_count = config->voice_count;
+    auto *first_dsp = voice_count > 0 ? config->voices[0].faust_dsp : nullptr;
+    // Without voices, the node is a silent mono node, like a Faust node without a DSP.
+    poly_node->in_channels = first_dsp ? first_dsp->getNumInputs() : 0;
+    poly_node->out_channels = first_dsp ? first_dsp->getNumOutputs() : 1;
+    for (ma_uint32 i = 1; i < voice_count; ++i) {
+        auto *faust_dsp = config->voices[i].faust_dsp;
+        if (faust_dsp == nullptr || ma_uint32(faust_dsp->getNumInputs()) != poly_node->in_channels || ma_uint32(faust_dsp->getNumOutputs()) != poly_node->out_channels) {
+            return MA_INVALID_ARGS;
+        }
+    }
+    if (poly_node->out_channels == 0) return MA_INVALID_ARGS; // A voice with no output is never heard.
+
+    poly_node->block_frames = config->buffer_frames > 0 ? config->buffer_frames : MA_FAUST_POLY_DEFAULT_BLOCK_FRAMES;
+    if (voice_count > 0) {
+        poly_node->voices = (ma_faust_poly_voice *)ma_calloc(voice_count * sizeof(ma_faust_poly_voice), allocation_callbacks);
+        if (poly_node->voices == nullptr) return MA_OUT_OF_MEMORY;
+
+        for (ma_uint32 i = 0; i < voice_count; ++i) {
+            auto *voice = &poly_node->voices[i];
+            voice->config = config->voices[i];
+            voice->note = -1;
+            voice->config.faust_dsp->init(config->sample_rate);
+            ma_faust_poly_voice_set_gate(voice, false);
+        }
+
+        const ma_uint32 N = poly_node->block_frames;
+        poly_node->voice_buffer = allocate_deinterleaved_buffer(poly_node->out_channels, N, allocation_callbacks);
+        poly_node->mix_buffer = allocate_deinterleaved_buffer(poly_node->out_channels, N, allocation_callbacks);
+        poly_node->voice_out_offset = (float **)ma_calloc(poly_node->out_channels * sizeof(float *), allocation_callbacks);
+        if (poly_node->in_channels > 0) {
+            poly_node->in_buffer = allocate_deinterleaved_buffer(poly_node->in_channels, N, allocation_callbacks);
+            poly_node->voice_in_offset = (float **)ma_calloc(poly_node->in_channels * sizeof(float *), allocation_callbacks);
+        }
+        if (poly_node->voice_buffer == nullptr || poly_node->mix_buffer == nullptr || poly_node->voice_out_offset == nullptr ||
+            (poly_node->in_channels > 0 && (poly_node->in_buffer == nullptr || poly_node->voice_in_offset == nullptr))) {
+            ma_faust_poly_node_free(poly_node, allocation_callbacks);
+            return MA_OUT_OF_MEMORY;
+        }
+    }
+
+    static ma_node_vtable vtable = {ma_faust_poly_node_process_pcm_frames, nullptr, MA_NODE_BUS_COUNT_UNKNOWN, MA_NODE_BUS_COUNT_UNKNOWN, 0};
+    ma_uint32 in_channels = poly_node->in_channels, out_channels = poly_node->out_channels;
+    ma_node_config base_config = config->node_config;
+    base_config.vtable = &vtable;
+    base_config.inputBusCount = ma_uint8(in_channels > 0 ? 1 : 0);
+    base_config.outputBusCount = 1;
+    base_config.pInputChannels = in_channels > 0 ? &in_channels : nullptr;
+    base_config.pOutputChannels = &out_channels;
+
+    ma_result result = ma_node_init(node_graph, &base_config, allocation_callbacks, &poly_node->base);
+    if (result != MA_SUCCESS) ma_faust_poly_node_free(poly_node, allocation_callbacks);
+    return result;
+}
+
+void ma_faust_poly_node_uninit(ma_faust_poly_node *poly_node, const ma_allocation_callbacks *allocation_callbacks) {
+    // Uninitialize the node first, so the audio thread is no longer processing it when its buffers are freed.
+    ma_node_uninit(&poly_node->base, allocation_callbacks);
+    ma_faust_poly_node_free(poly_node, allocation_callbacks);
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "miniaudio.h"
+
+#include <atomic>
+
+class dsp;
+
+#define MA_FAUST_POLY_EVENT_QUEUE_CAPACITY 256
+#define MA_FAUST_POLY_DEFAULT_BLOCK_FRAMES 512 // Used when the graph's buffer size is unknown.
+
+// A voice's DSP instance, and the zones of its `freq`/`gate`/`gain` params (any of which may be null).
+// The zones must only be written by the node, which sets them on the audio thread when handling note events.
+struct ma_faust_poly_voice_config {
+    dsp *faust_dsp;
+    float *freq_zone;
+    float *gate_zone;
+    float *gain_zone;
+};
+
+struct ma_faust_poly_node_config {
+    ma_node_config node_config;
+    const ma_faust_poly_voice_config *voices; // Copied during init. All voices must have the same channel counts.
+    ma_uint32 voice_count;
+    ma_uint32 sample_rate;
+    ma_uint32 buffer_frames;
+    float silence_threshold; // Linear amplitude.
+    // A released voice stops being computed once its output stays below `silence_threshold` for this many frames.
+    ma_uint32 silence_hold_frames;
+};
+
+ma_faust_poly_node_config ma_faust_poly_node_config_init(const ma_faust_poly_voice_config *voices, ma_uint32 voice_count, ma_uint32 sample_rate, ma_uint32 buffer_frames);
+
+enum ma_faust_poly_event_type {
+    ma_faust_poly_event_type_note_on,
+    ma_faust_poly_event_type_note_off,
+    ma_faust_poly_event_type_all_notes_off,
+};
+
+struct ma_faust_poly_event {
+    ma_faust_poly_event_type type;
+    ma_uint8 note; // MIDI note number.
+    float velocity; // [0, 1]
+};
+
+// Only accessed on the audio thread (after init).
+struct ma_faust_poly_voice {
+    ma_faust_poly_voice_config config;
+    ma_int32 note; // -1 if the voice is free.
+    ma_bool32 is_active; // Only active voices are computed.
+    ma_bool32 is_held; // The voice's gate is open (its note is on).
+    // Set when a held voice is stolen. Its gate is closed for the first frame of the next block, so its envelope retriggers.
+    ma_bool32 is_retriggering;
+    ma_uint64 note_on_index; // Increases with each note-on, for stealing the oldest voice.
+    ma_uint32 silent_frames;
+};
+
+// Runs a fixed set of voice DSP instances (usually cloned from the same prototype), mixing their outputs into a single output bus.
+// Note events are pushed to a lock-free single-producer, single-consumer queue, and handled at the start of each block on the audio thread.
+// * Note-on: Allocates a free voice, or steals the oldest released voice, or else the oldest held voice.
+// * Note-off: Closes the gate of the voice holding the note.
+// Voices that are not held and whose output has fallen below the silence threshold are skipped until allocated again.
+struct ma_faust_poly_node {
+    ma_node_base base;
+    ma_faust_poly_node_config config;
+    ma_faust_poly_voice *voices;
+    ma_uint32 in_channels, out_channels;
+    ma_uint32 block_frames; // Frames are processed in blocks of at most this many frames.
+    // Deinterleaved buffers, each with `block_frames` frames per channel.
+    float **in_buffer;
+    float **voice_buffer;
+    float **mix_buffer;
+    // Offset channel pointers, used to compute the frames after a retrigger frame.
+    float **voice_in_offset;
+    float **voice_out_offset;
+    ma_uint64 note_on_count;
+
+    ma_faust_poly_event events[MA_FAUST_POLY_EVENT_QUEUE_CAPACITY];
+    std::atomic<ma_uint32> event_write_index; // Only written by the producer.
+    std::atomic<ma_uint32> event_read_index; // Only written by the audio thread.
+
+    std::atomic<float> silence_threshold;
+    std::atomic<ma_uint32> active_voice_count; // As of the end of the most recent block.
+};
+
+ma_result ma_faust_poly_node_init(ma_node_graph *, const ma_faust_poly_node_config *, const ma_allocation_callbacks *, ma_faust_poly_node *);
+void ma_faust_poly_node_uninit(ma_faust_poly_node *, const ma_allocation_callbacks *);
+
+ma_uint32 ma_faust_poly_node_get_voice_count(ma_faust_poly_node *);
+ma_uint32 ma_faust_poly_node_get_active_voice_count(ma_faust_poly_node *);
+ma_uint32 ma_faust_poly_node_get_sample_rate(ma_faust_poly_node *);
+// Returns true if any of the node's voices use the DSP.
+ma_bool32 ma_faust_poly_node_has_dsp(ma_faust_poly_node *, const dsp *);
+
+// Reinitializes all voices, silencing them.
+ma_result ma_faust_poly_node_set_sample_rate(ma_faust_poly_node *, ma_uint32 sample_rate);
+ma_result ma_faust_poly_node_set_silence_threshold(ma_faust_poly_node *, float silence_threshold);
+
+// Events are pushed from a single (non-audio) thread. Returns `MA_NO_SPACE` if the event queue is full.
+ma_result ma_faust_poly_node_push_event(ma_faust_poly_node *, ma_faust_poly_event);
+ma_result ma_faust_poly_node_note_on(ma_faust_poly_node *, ma_uint8 note, float velocity);
+ma_result ma_faust_poly_node_note_off(ma_faust_poly_node *, ma_uint8 note);
+ma_result ma_faust_poly_node_all_notes_off(ma_faust_poly_node *);
@@ -1,14 +1,17 @@
 #include "ma_monitor_node.h"
 
+#include <cmath>
+
 #include "../ma_helper.h"
 
 #include "fft_data.h"
 
-ma_monitor_node_config ma_monitor_node_config_init(ma_uint32 channels, ma_uint32 buffer_frames) {
+ma_monitor_node_config ma_monitor_node_config_init(ma_uint32 channels, ma_uint32 buffer_frames, ma_uint32 spectrum_bins) {
     ma_monitor_node_config config;
     config.node_config = ma_node_config_init(); // Input and output channels are set in ma_monitor_node_init().
     config.channels = channels;
     config.buffer_frames = buffer_frames;
+    config.spectrum_bins = ma_min(spectrum_bins, buffer_frames / 8);
 
     return config;
 }
@@ -21,29 +24,75 @@ ma_result ma_monitor_apply_window_function(ma_monitor_node *monitor, void (*wind
     return MA_SUCCESS;
 }
 
-static void ma_monitor_node_process_pcm_frames(ma_node *node, const float **frames_in, ma_uint32 *frame_count_in, float **frames_out, ma_uint32 *frame_count_out) {
-    auto *monitor = (ma_monitor_node *)node;
+ma_result ma_monitor_set_spectrum_averaging(ma_monitor_node *monitor, float averaging) {
+    if (monitor == nullptr) return MA_INVALID_ARGS;
+
+    monitor->spectrum_averaging = ma_clamp(averaging, 0.f, 0.999f);
+    return MA_SUCCESS;
+}
+
+ma_result ma_monitor_set_spectrum_peak_decay(ma_monitor_node *monitor, float peak_decay_db) {
+    if (monitor == nullptr) return MA_INVALID_ARGS;
 
-    const ma_uint32 N = monitor->config.buffer_frames;
-    float *working_buffer = monitor->working_buffer_index == 0 ? monitor->working_buffer_0 : monitor->working_buffer_1;
-    float *buffer_write_pos = working_buffer + monitor->working_buffer_cursor;
-    ma_uint32 remaining_write_frames = N - monitor->working_buffer_cursor;
-    if (*frame_count_out >= remaining_write_frames) {
-        ma_copy_pcm_frames(buffer_write_pos, frames_out[0], remaining_write_frames, ma_format_f32, 1);
-        monitor->buffer = working_buffer;
-        monitor->working_buffer_cursor = 0;
-        monitor->working_buffer_index = monitor->working_buffer_index == 0 ? 1 : 0;
-
-        // todo atomic windowing
-        for (ma_uint32 i = 0; i < N; i++) {
-            monitor->windowed_buffer[i] = monitor->buffer[i] * monitor->window[i];
+    monitor->spectrum_peak_decay = ma_max(peak_decay_db, 0.f);
+    return MA_SUCCESS;
+}
+
+// Window and transform the full buffer for all channels, and reduce each channel's FFT into averaged/peak-held log-frequency bins.
+static void ma_monitor_analyze(ma_monitor_node *monitor) {
+    const ma_uint32 N = monitor->config.buffer_frames, N_2 = N / 2;
+    const ma_uint32 channels = monitor->config.channels, bins = monitor->config.spectrum_bins;
+
+    // todo atomic windowing
+    for (ma_uint32 channel = 0; channel < channels; channel++) {
+        const float *in = monitor->buffer + channel * N;
+        float *out = monitor->windowed_buffer + channel * N;
+        for (ma_uint32 i = 0; i < N; i++) out[i] = in[i] * monitor->window[i];
+    }
+
+    fftwf_execute(monitor->fft->plan);
+
+    const float averaging = monitor->spectrum_averaging, peak_decay = monitor->spectrum_peak_decay;
+    for (ma_uint32 channel = 0; channel < channels; channel++) {
+        const fftwf_complex *data = monitor->fft->data + channel * (N_2 + 1);
+        float *spectrum = monitor->spectrum + channel * bins;
+        float *peak = monitor->spectrum_peak + channel * bins;
+        for (ma_uint32 bin = 0; bin < bins; bin++) {
+            float max_power = 0;
+            for (ma_uint32 i = monitor->spectrum_bin_starts[bin]; i < monitor->spectrum_bin_starts[bin + 1]; i++) {
+                max_power = ma_max(max_power, data[i][0] * data[i][0] + data[i][1] * data[i][1]);
+            }
+            const float db = ma_max(MA_MONITOR_MIN_DB, ma_volume_linear_to_db(sqrtf(max_power) / float(N_2)));
+            spectrum[bin] = averaging * spectrum[bin] + (1 - averaging) * db;
+            peak[bin] = ma_max(spectrum[bin], peak[bin] - peak_decay);
         }
+    }
+}
 
-        fftwf_execute(monitor->fft->plan);
+static void ma_monitor_node_process_pcm_frames(ma_node *node, const float **frames_in, ma_uint32 *frame_count_in, float **frames_out, ma_uint32 *frame_count_out) {
+    auto *monitor = (ma_monitor_node *)node;
 
-    } else {
-        ma_copy_pcm_frames(buffer_write_pos, frames_out[0], *frame_count_out, ma_format_f32, 1);
-        monitor->working_buffer_cursor += *frame_count_out;
+    const ma_uint32 N = monitor->config.buffer_frames, channels = monitor->config.channels;
+    const float *frames = frames_out[0];
+    ma_uint32 remaining_frames = *frame_count_out;
+    while (remaining_frames > 0) {
+        float *working_buffer = monitor->working_buffer_index == 0 ? monitor->working_buffer_0 : monitor->working_buffer_1;
+        const ma_uint32 write_frames = ma_min(remaining_frames, N - monitor->working_buffer_cursor);
+        // Deinterleave into each channel's planar buffer.
+        for (ma_uint32 channel = 0; channel < channels; channel++) {
+            float *channel_write_pos = working_buffer + channel * N + monitor->working_buffer_cursor;
+            for (ma_uint32 i = 0; i < write_frames; i++) channel_write_pos[i] = frames[i * channels + channel];
+        }
+        frames += write_frames * channels;
+        remaining_frames -= write_frames;
+        monitor->working_buffer_cursor += write_frames;
+
+        if (monitor->working_buffer_cursor == N) {
+            monitor->buffer = working_buffer;
+            monitor->working_buffer_cursor = 0;
+            monitor->working_buffer_index = monitor->working_buffer_index == 0 ? 1 : 0;
+            ma_monitor_analyze(monitor);
+        }
     }
 
     (void)frame_count_in;
@@ -54,14 +103,16 @@ ma_result create_fft(ma_monitor_node *monitor, const ma_allocation_callbacks *al
     auto *fft = (fft_data *)ma_malloc(sizeof(fft_data), allocation_callbacks);
     if (fft == nullptr) return MA_OUT_OF_MEMORY;
 
-    ma_uint32 N = monitor->config.buffer_frames;
-    fft->data = fftwf_alloc_complex(N / 2 + 1);
+    const int N = monitor->config.buffer_frames, channels = monitor->config.channels;
+    const int N_out = N / 2 + 1;
+    fft->data = fftwf_alloc_complex(N_out * channels);
     if (fft->data == nullptr) {
         ma_free(fft, allocation_callbacks);
         return MA_OUT_OF_MEMORY;
     }
 
-    fft->plan = fftwf_plan_dft_r2c_1d(N, monitor->windowed_buffer, fft->data, FFTW_MEASURE);
+    // One plan transforms all (planar) channels at once.
+    fft->plan = fftwf_plan_many_dft_r2c(1, &N, channels, monitor->windowed_buffer, nullptr, 1, N, fft->data, nullptr, 1, N_out, FFTW_MEASURE);
 
     monitor->fft = fft;
 
@@ -76,43 +127,63 @@ void destroy_fft(fft_data *fft, const ma_allocation_callbacks *allocation_callba
     ma_free(fft, allocation_callbacks);
 }
 
+static void free_buffers(ma_monitor_node *monitor, const ma_allocation_callbacks *allocation_callbacks) {
+    ma_free(monitor->working_buffer_0, allocation_callbacks);
+    ma_free(monitor->working_buffer_1, allocation_callbacks);
+    ma_free(monitor->window, allocation_callbacks);
+    ma_free(monitor->windowed_buffer, allocation_callbacks);
+    ma_free(monitor->spectrum_bin_starts, allocation_callbacks);
+    ma_free(monitor->spectrum, allocation_callbacks);
+    ma_free(monitor->spectrum_peak, allocation_callbacks);
+    monitor->working_buffer_0 = monitor->working_buffer_1 = monitor->buffer = nullptr;
+    monitor->window = monitor->windowed_buffer = monitor->spectrum = monitor->spectrum_peak = nullptr;
+    monitor->spectrum_bin_starts = nullptr;
+}
+
+// Spread bin edges logarithmically over FFT bins `[1, N/2]` (skipping DC), giving each bin at least one FFT bin.
+static void init_spectrum_bin_starts(ma_monitor_node *monitor) {
+    const ma_uint32 N_2 = monitor->config.buffer_frames / 2, bins = monitor->config.spectrum_bins;
+    ma_uint32 *starts = monitor->spectrum_bin_starts;
+    starts[0] = 1;
+    for (ma_uint32 bin = 1; bin < bins; bin++) {
+        const auto edge = ma_uint32(roundf(powf(float(N_2), float(bin) / float(bins))));
+        starts[bin] = ma_min(ma_max(edge, starts[bin - 1] + 1), N_2 + 1 - (bins - bin));
+    }
+    starts[bins] = N_2 + 1; // Include the Nyquist bin.
+}
+
 ma_result ma_monitor_node_init(ma_node_graph *node_graph, const ma_monitor_node_config *config, const ma_allocation_callbacks *allocation_callbacks, ma_monitor_node *monitor) {
-    if (monitor == nullptr || config == nullptr) return MA_INVALID_ARGS;
+    if (monitor == nullptr || config == nullptr || config->spectrum_bins == 0) return MA_INVALID_ARGS;
 
     MA_ZERO_OBJECT(monitor);
     monitor->config = *config;
-    ma_uint32 N = monitor->config.buffer_frames;
-
-    monitor->working_buffer_0 = (float *)ma_malloc((size_t)(N * ma_get_bytes_per_frame(ma_format_f32, config->channels)), allocation_callbacks);
-    if (monitor->working_buffer_0 == nullptr) return MA_OUT_OF_MEMORY;
-    ma_silence_pcm_frames(monitor->working_buffer_0, N, ma_format_f32, config->channels);
-
-    monitor->working_buffer_1 = (float *)ma_malloc((size_t)(N * ma_get_bytes_per_frame(ma_format_f32, config->channels)), allocation_callbacks);
-    if (monitor->working_buffer_1 == nullptr) {
-        ma_free(monitor->working_buffer_0, allocation_callbacks);
+    const ma_uint32 N = monitor->config.buffer_frames, channels = config->channels, bins = config->spectrum_bins;
+    const size_t buffer_bytes = size_t(N) * ma_get_bytes_per_frame(ma_format_f32, channels);
+    const size_t spectrum_bytes = size_t(bins) * channels * sizeof(float);
+
+    monitor->working_buffer_0 = (float *)ma_malloc(buffer_bytes, allocation_callbacks);
+    monitor->working_buffer_1 = (float *)ma_malloc(buffer_bytes, allocation_callbacks);
+    monitor->window = (float *)ma_malloc(size_t(N) * sizeof(float), allocation_callbacks);
+    monitor->windowed_buffer = (float *)ma_malloc(buffer_bytes, allocation_callbacks);
+    monitor->spectrum_bin_starts = (ma_uint32 *)ma_malloc(size_t(bins + 1) * sizeof(ma_uint32), allocation_callbacks);
+    monitor->spectrum = (float *)ma_malloc(spectrum_bytes, allocation_callbacks);
+    monitor->spectrum_peak = (float *)ma_malloc(spectrum_bytes, allocation_callbacks);
+    if (monitor->working_buffer_0 == nullptr || monitor->working_buffer_1 == nullptr || monitor->window == nullptr ||
+        monitor->windowed_buffer == nullptr || monitor->spectrum_bin_starts == nullptr || monitor->spectrum == nullptr || monitor->spectrum_peak == nullptr) {
+        free_buffers(monitor, allocation_callbacks);
         return MA_OUT_OF_MEMORY;
     }
-    ma_silence_pcm_frames(monitor->working_buffer_1, N, ma_format_f32, config->channels);
 
+    ma_silence_pcm_frames(monitor->working_buffer_0, N, ma_format_f32, channels);
+    ma_silence_pcm_frames(monitor->working_buffer_1, N, ma_format_f32, channels);
+    ma_silence_pcm_frames(monitor->windowed_buffer, N, ma_format_f32, channels);
     monitor->buffer = monitor->working_buffer_1;
-
-    monitor->window = (float *)ma_malloc((size_t)(N * ma_get_bytes_per_frame(ma_format_f32, 1)), allocation_callbacks);
-    if (monitor->window == nullptr) {
-        ma_free(monitor->working_buffer_0, allocation_callbacks);
-        ma_free(monitor->working_buffer_1, allocation_callbacks);
-        return MA_OUT_OF_MEMORY;
-    }
     for (ma_uint32 i = 0; i < N; ++i) monitor->window[i] = 1.0; // Rectangular window by default.
-
-    monitor->windowed_buffer = (float *)ma_malloc((size_t)(N * ma_get_bytes_per_frame(ma_format_f32, config->channels)), allocation_callbacks);
-    if (monitor->windowed_buffer == nullptr) return MA_OUT_OF_MEMORY;
-    ma_silence_pcm_frames(monitor->windowed_buffer, N, ma_format_f32, config->channels);
+    for (ma_uint32 i = 0; i < bins * channels; ++i) monitor->spectrum[i] = monitor->spectrum_peak[i] = MA_MONITOR_MIN_DB;
+    init_spectrum_bin_starts(monitor);
 
     if (ma_result result = create_fft(monitor, allocation_callbacks); result != MA_SUCCESS) {
-        ma_free(monitor->working_buffer_0, allocation_callbacks);
-        ma_free(monitor->working_buffer_1, allocation_callbacks);
-        ma_free(monitor->window, allocation_callbacks);
-        ma_free(monitor->windowed_buffer, allocation_callbacks);
+        free_buffers(monitor, allocation_callbacks);
         return result;
     }
 
@@ -131,8 +202,5 @@ void ma_monitor_node_uninit(ma_monitor_node *monitor, const ma_allocation_callba
     ma_node_uninit(monitor, allocation_callbacks);
     destroy_fft(monitor->fft, allocation_callbacks);
     monitor->fft = nullptr;
-    ma_free(monitor->buffer, allocation_callbacks);
-    monitor->buffer = nullptr;
-    ma_free(monitor->windowed_buffer, allocation_callbacks);
-    monitor->windowed_buffer = nullptr;
+    free_buffers(monitor, allocation_callbacks);
 }
@@ -69,6 +69,8 @@ template<IsAction... T> struct ActionVariant : std::variant<T...> {
     using variant_t = std::variant<T...>; // Alias for the base variant type.
     using variant_t::variant; // Inherit the base variant's ctors.
 
+    template<typename U> static constexpr bool Contains = (std::same_as<U, T> || ...);
+
     // Note: this map is declared to be instantiated for each `ActionVariant` type,
     // but the compiler only instantiates them for the types with references to the map.
     template<size_t I = 0> static auto CreatePathToIndex() {
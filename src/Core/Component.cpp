@@ -68,6 +68,8 @@ Component::~Component() {
 void Component::RegisterChangeListener(ChangeListener *listener) const { Ctx.RegisterChangeListener(listener, Id); }
 void Component::RegisterChangeListener(ChangeListener *listener, ID id) const { Ctx.RegisterChangeListener(listener, id); }
 void Component::UnregisterChangeListener(ChangeListener *listener) const { Ctx.UnregisterChangeListener(listener); }
+void Component::RegisterTickListener(TickListener *listener) const { Ctx.RegisterTickListener(listener); }
+void Component::UnregisterTickListener(TickListener *listener) const { Ctx.UnregisterTickListener(listener); }
 
 bool Component::IsChanged(bool include_descendents) const noexcept {
     return Ctx.IsChanged(Id) || (include_descendents && Ctx.IsDescendentChanged(Id));
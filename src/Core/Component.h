@@ -8,6 +8,7 @@
 #include "nlohmann/json.hpp"
 
 #include "ChangeListener.h"
+#include "TickListener.h"
 #include "ComponentArgs.h"
 #include "HelpInfo.h"
 #include "Helper/Path.h"
@@ -110,6 +111,8 @@ struct Component {
     void RegisterChangeListener(ChangeListener *) const;
     void RegisterChangeListener(ChangeListener *, ID) const;
     void UnregisterChangeListener(ChangeListener *) const;
+    void RegisterTickListener(TickListener *) const;
+    void UnregisterTickListener(TickListener *) const;
 
     // Returns true if this component has changed directly (must me a leaf),
     // or if any of its descendent components have changed, if `include_descendents` is true.
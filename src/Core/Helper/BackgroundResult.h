@@ -0,0 +1,40 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+// Computes a value on a worker thread, and posts it back for the UI thread to read once it's ready.
+// Used for long-running measurements (benchmarks) requested by actions, so applying the action doesn't block the UI.
+template<typename T> struct BackgroundResult {
+    // Does nothing if a computation is already running.
+    // `compute` runs on the worker thread, so it must own (or share immutably) everything it reads.
+    void Start(std::function<T()> compute) {
+        if (Running.exchange(true)) return;
+
+        Worker = std::jthread{[this, compute = std::move(compute)] {
+            T value = compute();
+            {
+                std::scoped_lock lock{Mutex};
+                Value = std::move(value);
+            }
+            Running = false;
+        }};
+    }
+
+    bool IsRunning() const { return Running; }
+
+    // The last computed value, if any. A running computation keeps the previous value until it finishes.
+    std::optional<T> Get() const {
+        std::scoped_lock lock{Mutex};
+        return Value;
+    }
+
+private:
+    mutable std::mutex Mutex;
+    std::optional<T> Value{};
+    std::atomic<bool> Running{false};
+    std::jthread Worker; // Declared last, so it's joined before anything it uses is destroyed.
+};
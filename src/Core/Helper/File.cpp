@@ -1,5 +1,6 @@
 #include "File.h"
 
+#include <format>
 #include <fstream>
 #include <optional>
 
@@ -7,7 +8,9 @@
 #include <shlobj.h> // for SHGetFolderPathW
 #include <windows.h>
 #else
+#include <fcntl.h>
 #include <pwd.h>
+#include <sys/mman.h>
 #include <sys/types.h>
 #include <unistd.h>
 #endif
@@ -47,6 +50,44 @@ std::string FileIO::read(const fs::path &path) {
     return result;
 }
 
+FileIO::MappedFile::MappedFile(const fs::path &path) {
+    const fs::path full_path = ExpandPath(path);
+    Size = fs::file_size(full_path);
+    if (Size == 0) return; // Empty files can't be mapped.
+
+#ifdef _WIN32
+    FileHandle = CreateFileW(full_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (FileHandle == INVALID_HANDLE_VALUE) throw std::runtime_error(std::format("Unable to open file: {}", full_path.string()));
+    MappingHandle = CreateFileMappingW(FileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (MappingHandle) Data = static_cast<const char *>(MapViewOfFile(MappingHandle, FILE_MAP_READ, 0, 0, 0));
+    if (!Data) {
+        if (MappingHandle) CloseHandle(MappingHandle);
+        CloseHandle(FileHandle);
+        throw std::runtime_error(std::format("Unable to map file: {}", full_path.string()));
+    }
+#else
+    const int fd = open(full_path.c_str(), O_RDONLY);
+    if (fd == -1) throw std::runtime_error(std::format("Unable to open file: {}", full_path.string()));
+    void *data = mmap(nullptr, Size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // The mapping keeps its own reference to the file.
+    if (data == MAP_FAILED) throw std::runtime_error(std::format("Unable to map file: {}", full_path.string()));
+    madvise(data, Size, MADV_SEQUENTIAL);
+    Data = static_cast<const char *>(data);
+#endif
+}
+
+FileIO::MappedFile::~MappedFile() {
+    if (!Data) return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(Data);
+    CloseHandle(MappingHandle);
+    CloseHandle(FileHandle);
+#else
+    munmap(const_cast<char *>(Data), Size);
+#endif
+}
+
 bool FileIO::write(const fs::path &path, std::string_view contents) {
     std::fstream out_file;
     out_file.open(path, std::ios::out);
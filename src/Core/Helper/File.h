@@ -2,12 +2,32 @@
 
 #include <filesystem>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace fs = std::filesystem;
 
 namespace FileIO {
 std::string read(const fs::path &);
+
+// Read-only memory mapping of a file's contents, valid for the lifetime of the object.
+// Pages are loaded on demand, so reading a large file through the view doesn't need a copy of it in memory.
+struct MappedFile {
+    explicit MappedFile(const fs::path &);
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    ~MappedFile();
+
+    std::string_view View() const { return {Data, Size}; }
+
+private:
+    const char *Data{nullptr};
+    size_t Size{0};
+#ifdef _WIN32
+    void *FileHandle{nullptr}, *MappingHandle{nullptr};
+#endif
+};
+
 bool write(const fs::path &, const std::string_view contents);
 bool write(const fs::path &, const std::vector<std::uint8_t> &contents);
 } // namespace FileIO
@@ -0,0 +1,213 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <format>
+#include <memory>
+#include <mutex>
+#include <optional>
+
+#include "nlohmann/json.hpp"
+
+#include "Core/Helper/File.h"
+
+using json = nlohmann::json;
+
+namespace Profiler {
+// A zone in a ring, with atomic fields so the collector can read it while the owning thread overwrites it.
+struct ZoneSlot {
+    // Odd while the slot is being written, and `2 * (index + 1)` once it holds the ring's zone `index`.
+    std::atomic<uint64_t> Sequence{0};
+    std::atomic<const char *> Name{nullptr};
+    std::atomic<uint64_t> StartNs{0}, EndNs{0};
+    std::atomic<uint32_t> Depth{0};
+
+    // Only called by the owning thread.
+    void Write(uint64_t index, const Zone &zone) {
+        Sequence.store(2 * index + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        Name.store(zone.Name, std::memory_order_relaxed);
+        StartNs.store(zone.StartNs, std::memory_order_relaxed);
+        EndNs.store(zone.EndNs, std::memory_order_relaxed);
+        Depth.store(zone.Depth, std::memory_order_relaxed);
+        Sequence.store(2 * (index + 1), std::memory_order_release);
+    }
+
+    // The ring's zone `index`, unless the slot has since been overwritten, or was being overwritten while reading it.
+    std::optional<Zone> Read(uint64_t index) const {
+        const uint64_t sequence = Sequence.load(std::memory_order_acquire);
+        if (sequence != 2 * (index + 1)) return {};
+
+        const Zone zone{
+            Name.load(std::memory_order_relaxed),
+            StartNs.load(std::memory_order_relaxed),
+            EndNs.load(std::memory_order_relaxed),
+            Depth.load(std::memory_order_relaxed),
+        };
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (Sequence.load(std::memory_order_relaxed) != sequence) return {};
+        return zone;
+    }
+};
+
+constexpr uint64_t RingSize = 1 << 14;
+
+struct ZoneRing {
+    std::string ThreadName;
+    std::array<ZoneSlot, RingSize> Slots;
+    std::atomic<uint64_t> WriteCount{0}; // Only written by the owning thread.
+    uint64_t ReadCount{0}; // Only accessed while collecting.
+    std::atomic<bool> IsOwned{true}; // False once the owning thread exits (or the ring is released), so it can be reused once collected.
+};
+} // namespace Profiler
+
+namespace {
+using Profiler::RingSize, Profiler::Zone, Profiler::ZoneRing;
+
+const auto Epoch = std::chrono::steady_clock::now();
+
+std::mutex RingsMutex; // Locked when a thread records its first zone, when naming a thread or reserving a ring, and when collecting.
+std::vector<std::unique_ptr<ZoneRing>> Rings;
+
+// Releases the ring when its thread exits.
+struct RingOwner {
+    ~RingOwner() {
+        if (Ring) Ring->IsOwned = false;
+    }
+    ZoneRing *Ring{nullptr};
+};
+thread_local RingOwner CurrentRingOwner; // Only accessed when acquiring a ring, since its (nontrivial) destructor is registered on first access.
+thread_local ZoneRing *CurrentThreadRing{nullptr}; // The acquired or reserved ring the thread records into.
+thread_local uint32_t CurrentDepth{0};
+
+// Assumes `RingsMutex` is locked.
+ZoneRing &AcquireRing() {
+    for (auto &ring : Rings) {
+        if (!ring->IsOwned && ring->ReadCount == ring->WriteCount) {
+            ring->IsOwned = true;
+            ring->ThreadName = std::format("Thread {}", &ring - Rings.data());
+            return *ring;
+        }
+    }
+    auto &ring = *Rings.emplace_back(std::make_unique<ZoneRing>());
+    ring.ThreadName = std::format("Thread {}", Rings.size() - 1);
+    return ring;
+}
+
+ZoneRing &CurrentRing() {
+    if (!CurrentThreadRing) {
+        const std::lock_guard lock{RingsMutex};
+        CurrentThreadRing = CurrentRingOwner.Ring = &AcquireRing();
+    }
+    return *CurrentThreadRing;
+}
+
+// Collector state, only accessed from the UI thread.
+std::vector<Profiler::ThreadZones> History;
+std::vector<Zone> CollectBuffer;
+uint64_t DroppedCount{0};
+bool Paused{false};
+} // namespace
+
+namespace Profiler {
+uint64_t NowNs() { return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - Epoch).count(); }
+
+void SetThreadName(std::string name) {
+    auto &ring = CurrentRing();
+    const std::lock_guard lock{RingsMutex};
+    ring.ThreadName = std::move(name);
+}
+
+ZoneRing *ReserveRing(std::string thread_name) {
+#ifdef PROFILER_ENABLED
+    const std::lock_guard lock{RingsMutex};
+    auto &ring = AcquireRing();
+    ring.ThreadName = std::move(thread_name);
+    return &ring;
+#else
+    (void)thread_name;
+    return nullptr;
+#endif
+}
+
+void ReleaseRing(ZoneRing *ring) {
+    if (ring) ring->IsOwned = false;
+}
+
+void UseRing(ZoneRing *ring) { CurrentThreadRing = ring; }
+
+Scope::Scope(const char *name) : Name(name), StartNs(NowNs()) { ++CurrentDepth; }
+
+Scope::~Scope() {
+    const uint64_t end_ns = NowNs();
+    auto &ring = CurrentRing();
+    const uint64_t index = ring.WriteCount.load(std::memory_order_relaxed);
+    ring.Slots[index % RingSize].Write(index, {Name, StartNs, end_ns, --CurrentDepth});
+    ring.WriteCount.store(index + 1, std::memory_order_release);
+}
+
+void Collect() {
+    uint64_t newest_ns = 0;
+    {
+        const std::lock_guard lock{RingsMutex};
+        for (auto &ring : Rings) {
+            const uint64_t write_count = ring->WriteCount.load(std::memory_order_acquire);
+            const uint64_t start = std::max(ring->ReadCount, write_count > RingSize ? write_count - RingSize : 0);
+            DroppedCount += start - ring->ReadCount;
+            ring->ReadCount = write_count;
+            if (Paused || start == write_count) continue;
+
+            CollectBuffer.clear();
+            for (uint64_t i = start; i < write_count; ++i) {
+                // Zones the owning thread overwrote since `write_count` was read are dropped.
+                if (const auto zone = ring->Slots[i % RingSize].Read(i)) CollectBuffer.push_back(*zone);
+                else ++DroppedCount;
+            }
+
+            // A ring's zones are written in end time order, so appending keeps each row ordered.
+            auto it = std::ranges::find_if(History, [&ring](const auto &thread) { return thread.Ring == ring.get() && thread.ThreadName == ring->ThreadName; });
+            if (it == History.end()) it = History.emplace(History.end(), ThreadZones{ring.get(), ring->ThreadName, {}});
+            it->Zones.insert(it->Zones.end(), CollectBuffer.begin(), CollectBuffer.end());
+        }
+    }
+
+    for (const auto &thread : History) {
+        if (!thread.Zones.empty()) newest_ns = std::max(newest_ns, thread.Zones.back().EndNs);
+    }
+    if (newest_ns < HistoryNs) return;
+
+    for (auto &thread : History) {
+        auto &zones = thread.Zones;
+        zones.erase(zones.begin(), std::ranges::lower_bound(zones, newest_ns - HistoryNs, {}, &Zone::EndNs));
+    }
+    std::erase_if(History, [](const auto &thread) { return thread.Zones.empty(); });
+}
+
+void SetPaused(bool paused) { Paused = paused; }
+bool IsPaused() { return Paused; }
+
+const std::vector<ThreadZones> &GetHistory() { return History; }
+uint64_t GetDroppedCount() { return DroppedCount; }
+
+bool WriteChromeTrace(const fs::path &path) {
+    json events = json::array();
+    for (size_t tid = 0; tid < History.size(); ++tid) {
+        const auto &thread = History[tid];
+        events.push_back({{"name", "thread_name"}, {"ph", "M"}, {"pid", 0}, {"tid", tid}, {"args", {{"name", thread.ThreadName}}}});
+        for (const auto &zone : thread.Zones) {
+            // Chrome trace times are in (fractional) microseconds.
+            events.push_back({
+                {"name", zone.Name},
+                {"ph", "X"},
+                {"pid", 0},
+                {"tid", tid},
+                {"ts", double(zone.StartNs) / 1000},
+                {"dur", double(zone.EndNs - zone.StartNs) / 1000},
+            });
+        }
+    }
+    return FileIO::write(path, json{{"traceEvents", std::move(events)}, {"displayTimeUnit", "ns"}}.dump());
+}
+} // namespace Profiler
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+/**
+Built-in scoped-zone profiler, covering all threads.
+
+Each thread records its zones (with nanosecond timestamps) into its own fixed-size ring buffer.
+Only the recording thread writes to its ring, so recording never locks or allocates (after a thread's first zone).
+Threads that can't lock or allocate even then (realtime audio callbacks) record into a ring reserved for them ahead of time.
+The UI thread collects new zones from all rings once per frame, keeping the last few seconds of history.
+Each ring slot is guarded by its own sequence number, so the collector skips slots being (over)written instead of reading torn zones.
+If a thread records more zones than its ring holds between collections, the oldest ones are dropped (and counted).
+
+Instrument with the macros at the bottom, which expand to nothing unless `PROFILER_ENABLED` is defined.
+*/
+namespace Profiler {
+struct Zone {
+    const char *Name; // Must be a static string.
+    uint64_t StartNs, EndNs; // Since the profiler's epoch (its first use).
+    uint32_t Depth; // Nesting depth within its thread.
+};
+
+struct ZoneRing;
+
+// The zones one thread recorded into one ring.
+// Rows are keyed on the ring (and the thread's name, since a ring is reused once its thread exits), not on the name alone,
+// since concurrent threads can share a name (e.g. background compile jobs), and their zones overlap in time.
+struct ThreadZones {
+    const ZoneRing *Ring;
+    std::string ThreadName; // Only a label.
+    std::vector<Zone> Zones; // Ordered by end time.
+};
+
+uint64_t NowNs();
+
+// Name the current thread in collected zones. Unnamed threads are numbered.
+void SetThreadName(std::string);
+
+// Reserve a named ring for a thread that must not lock or allocate when recording its first zone, e.g. an audio device's callback thread.
+// Call off that thread, before it starts recording (e.g. before starting the device).
+// Returns null if the profiler is compiled out.
+ZoneRing *ReserveRing(std::string thread_name);
+// Call once the thread no longer records into the ring (e.g. after stopping the device).
+void ReleaseRing(ZoneRing *);
+// Record the current thread's zones into a reserved ring. Doesn't lock or allocate, so it's safe to call at the start of every realtime callback.
+void UseRing(ZoneRing *);
+
+struct Scope {
+    explicit Scope(const char *name);
+    ~Scope();
+
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+private:
+    const char *Name;
+    uint64_t StartNs;
+};
+
+// Move the zones recorded since the last collection into the history. Call once per frame on the UI thread.
+// Zones older than `HistoryNs` before the newest zone are discarded.
+void Collect();
+// While paused, collected zones are discarded, freezing the history.
+void SetPaused(bool);
+bool IsPaused();
+
+inline constexpr uint64_t HistoryNs = 5'000'000'000;
+
+// Collected zones, by thread ring. Rows left with no zones in the history are dropped. Only access from the UI thread.
+const std::vector<ThreadZones> &GetHistory();
+uint64_t GetDroppedCount();
+
+// Write the collected zones in Chrome's trace event format (viewable in `chrome://tracing` or Perfetto).
+bool WriteChromeTrace(const fs::path &);
+} // namespace Profiler
+
+#ifdef PROFILER_ENABLED
+#define ProfileConcat_(a, b) a##b
+#define ProfileConcat(a, b) ProfileConcat_(a, b)
+// Record the enclosing scope as a zone named `name` (a string literal).
+#define ProfileZone(name) const Profiler::Scope ProfileConcat(ProfileScope, __LINE__){name}
+// Name the current thread. Only sets the name the first time it's reached on each thread.
+#define ProfileThread(name) static thread_local const bool ProfileConcat(ProfileThreadNamed, __LINE__) = (Profiler::SetThreadName(name), true)
+// Record the current thread's zones into a ring from `Profiler::ReserveRing`, instead of naming the thread (which acquires a ring on first use).
+#define ProfileThreadRing(ring) Profiler::UseRing(ring)
+#else
+#define ProfileZone(name)
+#define ProfileThread(name)
+#define ProfileThreadRing(ring)
+#endif
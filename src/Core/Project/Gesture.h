@@ -0,0 +1,34 @@
+#pragma once
+
+#include "AnyAction.h"
+#include "Core/Store/StoreHistory.h"
+
+// A gesture is a group of (merged) saved actions committed to the store history together.
+struct Gesture {
+    SavedActionMoments Actions;
+    TimePoint CommitTime;
+};
+
+namespace nlohmann {
+inline void to_json(json &j, const Action::Saved &action) {
+    action.to_json(j);
+}
+inline void from_json(const json &j, Action::Saved &action) {
+    if (auto legacy_command = Action::TextBuffer::ToLegacyCommand(j)) action = std::move(*legacy_command);
+    else Action::Saved::from_json(j, action);
+}
+
+Json(SavedActionMoment, Action, QueueTime);
+Json(Gesture, Actions, CommitTime);
+} // namespace nlohmann
+
+// Used for saving/loading the history.
+// This is all the information needed to reconstruct a project.
+struct IndexedGestures {
+    Gestures Gestures;
+    u32 Index;
+};
+Json(IndexedGestures, Gestures, Index);
+
+// Merge chronologically consecutive actions where possible, dropping pairs that cancel out.
+SavedActionMoments MergeActions(const SavedActionMoments &);
@@ -0,0 +1,186 @@
+#include "HeadlessRunner.h"
+
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <random>
+#include <ranges>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+// `windows.h` must come first.
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "imgui.h"
+#include "implot.h"
+
+#include "Core/Helper/File.h"
+#include "Core/Primitive/Float.h"
+#include "Core/Profiler.h"
+#include "Gesture.h"
+#include "Project.h"
+
+std::optional<HeadlessRunOptions> HeadlessRunOptions::Parse(int argc, char **argv) {
+    const auto args = std::views::counted(argv + 1, std::max(argc - 1, 0)) | std::views::transform([](const char *arg) { return std::string_view{arg}; });
+    if (std::ranges::find(args, "--headless") == args.end()) return {};
+
+    HeadlessRunOptions options;
+    for (auto it = args.begin(); it != args.end(); ++it) {
+        const auto arg = *it;
+        if (arg == "--headless") continue;
+        if (std::next(it) == args.end()) throw std::invalid_argument(std::format("Missing value for argument '{}'", arg));
+
+        const std::string value{*++it};
+        if (arg == "--replay") options.ReplayPath = value;
+        else if (arg == "--synthetic") options.SyntheticGestureCount = std::stoul(value);
+        else if (arg == "--gesture-size") options.SyntheticGestureSize = std::max(u32(std::stoul(value)), 1u);
+        else if (arg == "--out") options.ReportPath = value;
+        else if (arg == "--trace") options.TracePath = value;
+        else throw std::invalid_argument(std::format("Unknown argument '{}'", arg));
+    }
+    return options;
+}
+
+static Gestures ReadGestures(const fs::path &path) {
+    IndexedGestures indexed_gestures = json::parse(FileIO::read(path));
+    return std::move(indexed_gestures.Gestures);
+}
+
+// Each synthetic gesture drags a random `Float` component's value through a random walk,
+// like dragging a slider, so consecutive actions in a gesture merge.
+static Gestures CreateSyntheticGestures(u32 gesture_count, u32 gesture_size) {
+    std::vector<const Float *> floats;
+    for (const auto *component : Component::ById | std::views::values) {
+        if (const auto *f = dynamic_cast<const Float *>(component)) floats.push_back(f);
+    }
+    if (floats.empty()) throw std::runtime_error("No `Float` components to generate synthetic actions for.");
+
+    // `ById` is unordered, so sort for a deterministic sequence of actions.
+    std::ranges::sort(floats, {}, &Component::Id);
+
+    std::mt19937 rng{0};
+    std::uniform_int_distribution<size_t> float_dist{0, floats.size() - 1};
+    std::uniform_real_distribution<float> step_dist{-0.05f, 0.05f};
+    Gestures gestures;
+    gestures.reserve(gesture_count);
+    for (u32 i = 0; i < gesture_count; ++i) {
+        const auto *f = floats[float_dist(rng)];
+        float value = *f;
+        SavedActionMoments actions;
+        actions.reserve(gesture_size);
+        for (u32 j = 0; j < gesture_size; ++j) {
+            value = std::clamp(value + step_dist(rng) * (f->Max - f->Min), f->Min, f->Max);
+            actions.emplace_back(Action::Float::Set{f->Id, value}, Clock::now());
+        }
+        gestures.emplace_back(std::move(actions), Clock::now());
+    }
+    return gestures;
+}
+
+// Peak resident memory of the process so far.
+static u64 GetPeakMemoryBytes() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    return GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)) ? counters.PeakWorkingSetSize : 0;
+#else
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+    return usage.ru_maxrss; // Bytes on macOS.
+#else
+    return u64(usage.ru_maxrss) * 1024; // Kilobytes on Linux.
+#endif
+#endif
+}
+
+struct HeadlessReport {
+    std::string Source;
+    u32 GestureCount, ActionCount;
+    float TotalMs, ApplyMs, PatchMs, RefreshMs, HistoryMs;
+    float DrainMs; // Waiting for background work (compiles, layouts, parses) after the last gesture. Included in `TotalMs`.
+    u64 InitPeakMemoryBytes; // Before replaying any gestures.
+    u64 PeakMemoryBytes;
+};
+Json(HeadlessReport, Source, GestureCount, ActionCount, TotalMs, ApplyMs, PatchMs, RefreshMs, HistoryMs, DrainMs, InitPeakMemoryBytes, PeakMemoryBytes);
+
+int RunHeadless(Project &project, const HeadlessRunOptions &options) {
+    // Null UI context: ImGui & ImPlot contexts without any platform/renderer backend or frames,
+    // so components can read UI state but nothing is ever drawn.
+    ImGui::CreateContext();
+    ImPlot::CreateContext();
+    ImGui::GetIO().IniFilename = nullptr;
+
+    int exit_code = 0;
+    try {
+        // Leave the canonical empty project as the UI saved it, and replay action logs on top of it, as `Project::Open` does.
+        project.Init(false);
+        if (options.ReplayPath && !project.OpenEmpty()) {
+            std::cerr << "No empty project has been saved yet (run FlowGrid without `--headless` once to save it). Replaying on top of the initial state.\n";
+        }
+
+        const auto gestures = options.ReplayPath ?
+            ReadGestures(*options.ReplayPath) :
+            CreateSyntheticGestures(options.SyntheticGestureCount, options.SyntheticGestureSize);
+        const u64 init_peak_memory_bytes = GetPeakMemoryBytes();
+
+        project.PhaseTimes.emplace();
+        u32 action_count = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (const auto &gesture : gestures) {
+            project.ApplyGesture(gesture);
+            action_count += gesture.Actions.size();
+            // Like the UI loop, poll background work (Faust compiles, param layouts, node trees, syntax parses) and apply its results.
+            project.Tick();
+        }
+        // Wait for background work started by the last gestures, so its results are applied (and measured) too.
+        const auto drain_start = std::chrono::steady_clock::now();
+        while (project.IsBusy()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+            project.Tick();
+        }
+        const auto end = std::chrono::steady_clock::now();
+        const float total_ms = std::chrono::duration<float, std::milli>(end - start).count();
+        const float drain_ms = std::chrono::duration<float, std::milli>(end - drain_start).count();
+
+        const auto &times = *project.PhaseTimes;
+        const HeadlessReport report{
+            options.ReplayPath ? options.ReplayPath->string() : std::format("synthetic ({} gestures of {} actions)", options.SyntheticGestureCount, options.SyntheticGestureSize),
+            u32(gestures.size()),
+            action_count,
+            total_ms,
+            times.ApplyMs,
+            times.PatchMs,
+            times.RefreshMs,
+            times.HistoryMs,
+            drain_ms,
+            init_peak_memory_bytes,
+            GetPeakMemoryBytes(),
+        };
+        project.PhaseTimes.reset();
+
+        std::cerr << std::format(
+            "Replayed {} actions in {} gestures in {:.1f} ms (apply {:.1f}, patch {:.1f}, refresh {:.1f}, history {:.1f}, background drain {:.1f}). Peak memory: {:.1f} MB\n",
+            report.ActionCount, report.GestureCount, report.TotalMs, report.ApplyMs, report.PatchMs, report.RefreshMs, report.HistoryMs, report.DrainMs, double(report.PeakMemoryBytes) / (1 << 20)
+        );
+        const std::string report_json = json(report).dump(2);
+        if (!options.ReportPath) std::cout << report_json << '\n';
+        else if (!FileIO::write(*options.ReportPath, report_json)) throw std::runtime_error(std::format("Failed to write report: {}", options.ReportPath->string()));
+
+        if (options.TracePath && !Profiler::WriteChromeTrace(*options.TracePath)) {
+            throw std::runtime_error(std::format("Failed to write trace: {}", options.TracePath->string()));
+        }
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << '\n';
+        exit_code = 1;
+    }
+
+    ImPlot::DestroyContext();
+    ImGui::DestroyContext();
+    return exit_code;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <filesystem>
+#include <optional>
+
+#include "Core/Scalar.h"
+
+namespace fs = std::filesystem;
+
+struct Project;
+
+/**
+Options for running a project without a UI, replaying gestures as fast as possible to profile the state layer.
+Usage: `FlowGrid --headless [--replay <project.fga> | --synthetic <gesture count> [--gesture-size <actions>]] [--out <report.json>] [--trace <trace.json>]`
+*/
+struct HeadlessRunOptions {
+    // Action-formatted project whose gestures are replayed. If not set, synthetic gestures are generated.
+    std::optional<fs::path> ReplayPath;
+    u32 SyntheticGestureCount{1000};
+    u32 SyntheticGestureSize{10}; // Actions per synthetic gesture.
+    std::optional<fs::path> ReportPath; // The report is written to stdout if not set.
+    std::optional<fs::path> TracePath; // Chrome trace of the profiler zones collected during the run.
+
+    // Returns `std::nullopt` if `--headless` is not among the arguments.
+    // Throws `std::invalid_argument` for unknown or incomplete headless arguments.
+    static std::optional<HeadlessRunOptions> Parse(int argc, char **argv);
+};
+
+// Replay gestures through the project without creating any windows, and report the time spent in each phase
+// of applying them (see `ProjectPhaseTimes`), along with peak memory usage.
+// The project ticks after each gesture, and until its background work is done after the last one, so compiles, layouts and parses are applied too.
+// Returns the process exit code.
+int RunHeadless(Project &, const HeadlessRunOptions &);
@@ -1,6 +1,7 @@
 
 #include "Project.h"
 
+#include <algorithm>
 #include <format>
 #include <ranges>
 #include <set>
@@ -11,101 +12,15 @@
 #include "Core/Action/ActionMenuItem.h"
 #include "Core/Helper/File.h"
 #include "Core/Helper/String.h"
+#include "Core/Profiler.h"
 #include "Core/Store/StoreHistory.h"
 #include "Core/Store/StorePatch.h"
+#include "Core/TextEditor/TextBuffer.h"
 #include "Core/UI/HelpMarker.h"
 #include "Core/UI/JsonTree.h"
+#include "Gesture.h"
 
-struct Gesture {
-    SavedActionMoments Actions;
-    TimePoint CommitTime;
-};
-
-namespace nlohmann {
-inline void to_json(json &j, const Action::Saved &action) {
-    action.to_json(j);
-}
-inline void from_json(const json &j, Action::Saved &action) {
-    Action::Saved::from_json(j, action);
-}
-
-Json(SavedActionMoment, Action, QueueTime);
-Json(Gesture, Actions, CommitTime);
-} // namespace nlohmann
-
-using std::ranges::to, std::views::drop, std::views::join, std::views::keys, std::views::transform;
-
-// Store history:
-// Defining this here instead of its own impl file to have a single place that depends on Store.h and the fully-defined `Action::Any` type.
-struct StoreHistory::Metrics {
-    immer::map<ID, immer::vector<TimePoint>> CommitTimesById;
-
-    void AddPatch(const Patch &patch, const TimePoint &commit_time) {
-        for (ID id : patch.GetIds()) {
-            auto commit_times = CommitTimesById.count(id) ? CommitTimesById.at(id).push_back(commit_time) : immer::vector<TimePoint>{commit_time};
-            CommitTimesById = CommitTimesById.set(id, std::move(commit_times));
-        }
-    }
-};
-
-struct Record {
-    PersistentStore Store;
-    Gesture Gesture;
-    StoreHistory::Metrics Metrics;
-};
-struct StoreHistory::Records {
-    Records(const PersistentStore &initial_store) : Value{{initial_store, Gesture{{}, Clock::now()}, StoreHistory::Metrics{{}}}} {}
-
-    std::vector<Record> Value;
-};
-
-StoreHistory::StoreHistory(const PersistentStore &store)
-    : _Records(std::make_unique<Records>(store)), _Metrics(std::make_unique<Metrics>()) {}
-StoreHistory::~StoreHistory() = default;
-
-u32 StoreHistory::Size() const { return _Records->Value.size(); }
-
-void StoreHistory::AddGesture(PersistentStore store, Gesture &&gesture, ID component_id) {
-    const auto patch = CreatePatch(store, CurrentStore(), component_id);
-    if (patch.Empty()) return;
-
-    _Metrics->AddPatch(patch, gesture.CommitTime);
-
-    while (Size() > Index + 1) _Records->Value.pop_back(); // todo use an undo _tree_ and keep this history
-    _Records->Value.emplace_back(std::move(store), std::move(gesture), *_Metrics);
-    Index = Size() - 1;
-}
-void StoreHistory::Clear(const PersistentStore &store) {
-    Index = 0;
-    _Records = std::make_unique<Records>(store);
-    _Metrics = std::make_unique<Metrics>();
-}
-void StoreHistory::SetIndex(u32 new_index) {
-    if (new_index == Index || new_index < 0 || new_index >= Size()) return;
-
-    Index = new_index;
-    _Metrics = std::make_unique<Metrics>(_Records->Value[Index].Metrics);
-}
-
-const PersistentStore &StoreHistory::CurrentStore() const { return _Records->Value[Index].Store; }
-const PersistentStore &StoreHistory::PrevStore() const { return _Records->Value[Index - 1].Store; }
-
-std::map<ID, u32> StoreHistory::GetChangeCountById() const {
-    return _Records->Value[Index].Metrics.CommitTimesById |
-        transform([](const auto &entry) { return std::pair(entry.first, entry.second.size()); }) |
-        to<std::map<ID, u32>>();
-}
-u32 StoreHistory::GetChangedPathsCount() const { return _Records->Value[Index].Metrics.CommitTimesById.size(); }
-
-StoreHistory::ReferenceRecord StoreHistory::At(u32 index) const {
-    const auto &record = _Records->Value[index];
-    return {record.Store, record.Gesture};
-}
-
-Gestures StoreHistory::GetGestures() const {
-    // The first record only holds the initial store with no gestures.
-    return _Records->Value | drop(1) | transform([](const auto &record) { return record.Gesture; }) | to<std::vector>();
-}
+using std::ranges::to, std::views::join, std::views::keys, std::views::transform;
 
 // Project constants:
 static const fs::path InternalPath = ".flowgrid";
@@ -144,6 +59,7 @@ Project::Project(CreateApp &&create_app)
 Project::~Project() = default;
 
 void Project::RefreshChanged(Patch &&patch, bool add_to_gesture) const {
+    ProfileZone("Project::RefreshChanged");
     MarkChanged(std::move(patch));
 
     // Find listeners to notify.
@@ -222,41 +138,24 @@ void Project::MarkChanged(Patch &&patch) const {
     for (const auto &[field_id, paths_moment] : ChangedPaths) LatestChangedPaths[field_id] = paths_moment;
 }
 
-SavedActionMoments MergeActions(const SavedActionMoments &actions) {
-    SavedActionMoments merged_actions; // Mutable return value.
-
-    // `active` keeps track of which action we're merging into.
-    // It's either an action in `gesture` or the result of merging 2+ of its consecutive members.
-    std::optional<const SavedActionMoment> active;
-    for (u32 i = 0; i < actions.size(); i++) {
-        if (!active) active.emplace(actions[i]);
-        const auto &a = *active;
-        const auto &b = actions[i + 1];
-        const auto merge_result = a.Action.Merge(b.Action);
-        std::visit(
-            Match{
-                [&](const bool cancel_out) {
-                    if (cancel_out) i++; // The two actions (`a` and `b`) cancel out, so we add neither. (Skip over `b` entirely.)
-                    else merged_actions.emplace_back(a); //
-                    active.reset(); // No merge in either case. Move on to try compressing the next action.
-                },
-                [&](const Action::Saved &merged_action) {
-                    // The two actions were merged. Keep track of it but don't add it yet - maybe we can merge more actions into it.
-                    active.emplace(merged_action, b.QueueTime);
-                },
-            },
-            merge_result
-        );
+// Adds the duration of its scope to a phase time, if phase times are being tracked.
+struct PhaseTimer {
+    PhaseTimer(std::optional<ProjectPhaseTimes> &times, float ProjectPhaseTimes::*phase_ms)
+        : PhaseMs(times ? &((*times).*phase_ms) : nullptr), Start(PhaseMs ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{}) {}
+    ~PhaseTimer() {
+        if (PhaseMs) *PhaseMs += std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - Start).count();
     }
-    if (active) merged_actions.emplace_back(*active);
 
-    return merged_actions;
-}
+private:
+    float *PhaseMs;
+    std::chrono::steady_clock::time_point Start;
+};
 
 void Project::CommitGesture() const {
     GestureChangedPaths.clear();
     if (ActiveGestureActions.empty()) return;
 
+    const PhaseTimer timer{PhaseTimes, &ProjectPhaseTimes::HistoryMs};
     const auto merged_actions = MergeActions(ActiveGestureActions);
     ActiveGestureActions.clear();
     if (merged_actions.empty()) return;
@@ -265,13 +164,18 @@ void Project::CommitGesture() const {
 }
 
 bool Project::CheckedCommit(bool add_to_gesture) const {
-    PersistentStore new_store{_S.Persistent()};
-    auto patch = CreatePatch(PS, new_store, State.Id);
-    if (patch.Empty()) return false;
+    Patch patch;
+    {
+        const PhaseTimer timer{PhaseTimes, &ProjectPhaseTimes::PatchMs};
+        PersistentStore new_store{_S.Persistent()};
+        patch = CreatePatch(PS, new_store, State.Id);
+        if (patch.Empty()) return false;
 
-    PS = std::move(new_store);
-    _S = PS.Transient();
+        PS = std::move(new_store);
+        _S = PS.Transient();
+    }
 
+    const PhaseTimer timer{PhaseTimes, &ProjectPhaseTimes::RefreshMs};
     RefreshChanged(std::move(patch), add_to_gesture);
     return true;
 }
@@ -301,14 +205,6 @@ void Project::SetHistoryIndex(u32 index) const {
     ProjectHasChanges = true;
 }
 
-// Used for saving/loading the history.
-// This is all the information needed to reconstruct a project.
-struct IndexedGestures {
-    Gestures Gestures;
-    u32 Index;
-};
-Json(IndexedGestures, Gestures, Index);
-
 json Project::GetProjectJson(ProjectFormat format) const {
     switch (format) {
         case ProjectFormat::State: return State.ToJson();
@@ -459,7 +355,7 @@ bool Project::Save(const fs::path &path) const {
     return true;
 }
 
-void Project::Init() {
+void Project::Init(bool save_empty_project) {
     // Consume and commit any pending actions.
     Tick();
     CommitGesture();
@@ -475,6 +371,7 @@ void Project::Init() {
     ImGuiSettings::IsChanged = true;
 
     // Keep the canonical "empty" project up-to-date.
+    if (!save_empty_project) return;
     if (!fs::exists(InternalPath)) fs::create_directory(InternalPath);
     Save(EmptyProjectPath);
 }
@@ -488,6 +385,8 @@ Patch CreatePatchAndResetTransient(const PersistentStore &persistent, TransientS
 }
 
 void Project::Tick() {
+    ProfileZone("Project::Tick");
+    Profiler::Collect();
     auto &io = ImGui::GetIO();
     if (io.WantSaveIniSettings) {
         ImGui::SaveIniSettingsToMemory(); // Populate ImGui's `Settings...` context members.
@@ -498,6 +397,7 @@ void Project::Tick() {
         }
         io.WantSaveIniSettings = false;
     }
+    for (auto *listener : TickListeners) listener->OnTick();
     ApplyQueuedActions();
 }
 
@@ -861,7 +761,29 @@ void Project::RenderMetrics() const {
     }
 }
 
+// Text buffer commands are evaluated against the current buffer right before they're applied, and replaced by the action to apply
+// (and save) in their place. See `TextBuffer::Resolve`.
+// Returns false if the action can't be applied.
+static bool ResolveTextBufferCommand(Project::ActionType &action) {
+    std::optional<Action::TextBuffer::Any> command;
+    std::visit(
+        [&command](const auto &a) {
+            if constexpr (Action::TextBuffer::Any::Contains<std::decay_t<decltype(a)>>) command = a;
+        },
+        action
+    );
+    if (!command) return true;
+
+    const auto *buffer = static_cast<const TextBuffer *>(Component::ById.at(command->GetComponentId()));
+    auto resolved = buffer->Resolve(*command);
+    if (!resolved) return false;
+
+    std::visit([&action](auto &&a) { action = std::move(a); }, std::move(*resolved));
+    return true;
+}
+
 void Project::ApplyQueuedActions() {
+    ProfileZone("Project::ApplyQueuedActions");
     const bool has_gesture_actions = HasGestureActions();
     bool commit_gesture = false;
     while (Queue.try_dequeue(DequeueToken, DequeueActionMoment)) {
@@ -885,8 +807,13 @@ void Project::ApplyQueuedActions() {
             std::holds_alternative<Action::Vec2::ToggleLinked>(action) ||
             std::holds_alternative<Action::AdjacencyList::ToggleConnection>(action) ||
             std::holds_alternative<Action::FileDialog::Select>(action);
+        // * Resolve text buffer commands last, since it evaluates them.
+        if (!ResolveTextBufferCommand(action)) continue;
 
-        Apply(_S, action);
+        {
+            const PhaseTimer timer{PhaseTimes, &ProjectPhaseTimes::ApplyMs};
+            Apply(_S, action);
+        }
 
         std::visit(
             Match{
@@ -906,3 +833,22 @@ void Project::ApplyQueuedActions() {
         CommitGesture();
     }
 }
+
+void Project::ApplyGesture(const Gesture &gesture) {
+    for (const auto &action_moment : gesture.Actions) {
+        std::visit([this](const auto &a) { Q(a); }, action_moment.Action);
+    }
+    ApplyQueuedActions();
+    CommitGesture();
+}
+
+bool Project::OpenEmpty() {
+    if (!fs::exists(EmptyProjectPath)) return false;
+
+    Open(_S, EmptyProjectPath);
+    return true;
+}
+
+bool Project::IsBusy() const {
+    return Queue.size_approx() > 0 || std::ranges::any_of(TickListeners, [](const auto *listener) { return listener->IsBusy(); });
+}
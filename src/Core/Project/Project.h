@@ -4,43 +4,19 @@
 
 #include "concurrentqueue.h"
 
-#include "Core/Action/ActionMoment.h"
 #include "Core/ActionableComponent.h"
 #include "Core/CoreActionHandler.h"
 #include "Core/CoreActionProducer.h"
 #include "Core/FileDialog/FileDialog.h"
 #include "Core/Store/Store.h"
+#include "AnyAction.h"
 #include "Preferences.h"
 #include "ProjectContext.h"
 #include "ProjectCore.h"
 
-#include "Core/CoreAction.h"
-#include "Core/FileDialog/FileDialogAction.h"
 #include "Core/Store/Patch/PatchOp.h"
-#include "Core/Store/StoreAction.h"
-#include "Core/Style/StyleAction.h"
-#include "Core/WindowsAction.h"
-#include "ProjectAction.h"
-
-// todo just need a little more finagling to finally be done w/ project/app decoupling...
-// This is the only remaining project knowledge of anything FlowGrid-specific (non-core).
-// It's only needed for
-// - defining the `Action::Any` variant,
-// - delegating `AppActionType` actions to the `App` component,
-#include "FlowGridAction.h"
-using AppActionType = Action::FlowGrid::Any;
-using AppType = ActionableComponent<AppActionType>;
-
-namespace Action {
-// `Any` holds any action type.
-//  - Metrics->Project->'Action variant size' shows the byte size of `Action::Any`.
-using Any = Combine<Core::Any, Project::Any, FileDialog::Any, Style::Any, Windows::Any, Store::Any, AppActionType>;
-using Saved = Filter<Action::IsSaved, Any>;
-using NonSaved = Filter<Action::IsNotSaved, Any>;
-} // namespace Action
 
-using SavedActionMoment = ActionMoment<Action::Saved>;
-using SavedActionMoments = std::vector<SavedActionMoment>;
+using AppType = ActionableComponent<AppActionType>;
 
 struct Gesture;
 
@@ -64,6 +40,14 @@ struct ProjectState : Component {
 
 struct StoreHistory;
 
+// Cumulative time spent in each phase of applying actions.
+struct ProjectPhaseTimes {
+    float ApplyMs{0}; // Applying actions to the transient store.
+    float PatchMs{0}; // Creating patches and committing the transient store.
+    float RefreshMs{0}; // Refreshing changed components and notifying their listeners.
+    float HistoryMs{0}; // Merging gesture actions and adding them to the history.
+};
+
 struct Plottable {
     std::vector<std::string> Labels;
     std::vector<u64> Values;
@@ -82,9 +66,20 @@ struct Project : ActionableProducer<Action::Any> {
     // Find the field whose `Refresh()` should be called in response to a patch with this component ID and op type.
     static Component *FindChanged(ID, const std::vector<PatchOp> &ops);
 
-    void Init();
+    // Saves the canonical empty project, unless `save_empty_project` is false.
+    // Headless runs don't save it, since they don't render the initial frames its ImGui settings come from.
+    void Init(bool save_empty_project = true);
     void Tick();
 
+    // Queue the gesture's actions, apply them, and commit them as a single gesture.
+    // Used to replay action logs without a UI (see `HeadlessRunner`).
+    void ApplyGesture(const Gesture &);
+    // Open the canonical empty project, which action-formatted projects are replayed on top of (see `Open`).
+    // Returns false if it hasn't been saved yet.
+    bool OpenEmpty();
+    // Returns true while actions are queued, or any tick listener has unfinished background work.
+    bool IsBusy() const;
+
     void Apply(TransientStore &, const ActionType &) const override;
     bool CanApply(const ActionType &) const override;
 
@@ -127,6 +122,7 @@ struct Project : ActionableProducer<Action::Any> {
     // Components with at least one descendent (excluding itself) updated during the latest action pass.
     mutable std::unordered_set<ID> ChangedAncestorComponentIds{};
     std::unordered_map<ID, std::unordered_set<ChangeListener *>> ChangeListenersById{};
+    std::unordered_set<TickListener *> TickListeners{};
 
     ProjectContext Ctx{
         .Preferences = Preferences,
@@ -155,8 +151,13 @@ struct Project : ActionableProducer<Action::Any> {
         .UnregisterChangeListener = [this](ChangeListener *listener) noexcept {
             for (auto &[component_id, listeners] : ChangeListenersById) listeners.erase(listener);
             std::erase_if(ChangeListenersById, [](const auto &entry) { return entry.second.empty(); }); },
+        .RegisterTickListener = [this](TickListener *listener) noexcept { TickListeners.insert(listener); },
+        .UnregisterTickListener = [this](TickListener *listener) noexcept { TickListeners.erase(listener); },
     };
 
+    // While engaged, accumulates the time spent in each phase of applying actions.
+    mutable std::optional<ProjectPhaseTimes> PhaseTimes;
+
     mutable PersistentStore PS;
     mutable TransientStore _S;
     ProjectState State{PS, _S, Ctx};
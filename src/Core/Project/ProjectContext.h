@@ -19,6 +19,7 @@ struct CoreActionProducer;
 
 struct Component;
 struct ChangeListener;
+struct TickListener;
 
 /*
 `ProjectContext` is essentially the public slice of a `Project`.
@@ -50,4 +51,6 @@ struct ProjectContext {
 
     const std::function<void(ChangeListener *, ID)> RegisterChangeListener;
     const std::function<void(ChangeListener *)> UnregisterChangeListener;
+    const std::function<void(TickListener *)> RegisterTickListener;
+    const std::function<void(TickListener *)> UnregisterTickListener;
 };
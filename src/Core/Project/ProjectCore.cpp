@@ -3,6 +3,8 @@
 #include "imgui_internal.h"
 #include "implot.h"
 
+#include "Core/FileDialog/FileDialog.h"
+#include "Core/Profiler.h"
 #include "Core/UI/JsonTree.h"
 
 #include "ProjectContext.h"
@@ -20,6 +22,7 @@ ProjectCore::ProjectCore(ArgsT &&args) : ActionableComponent(std::move(args)) {
     Debug.PathUpdateFrequency.RegisterWindow();
     Debug.DebugLog.RegisterWindow();
     Debug.StackTool.RegisterWindow();
+    Debug.ProfileTimeline.RegisterWindow();
     Debug.Metrics.RegisterWindow();
 }
 
@@ -111,6 +114,7 @@ void ProjectCore::Dock(ID *node_id) const {
     Debug.PathUpdateFrequency.Dock(&debug_node_id);
     Debug.DebugLog.Dock(&debug_node_id);
     Debug.StackTool.Dock(&debug_node_id);
+    Debug.ProfileTimeline.Dock(&debug_node_id);
     Debug.Metrics.Dock(&metrics_node_id);
 }
 
@@ -134,6 +138,7 @@ void ProjectCore::Debug::DrawWindowsMenu() const {
         item(PathUpdateFrequency);
         item(DebugLog);
         item(StackTool);
+        item(ProfileTimeline);
         item(Metrics);
         EndMenu();
     }
@@ -146,6 +151,84 @@ void ProjectCore::Debug::StackTool::Render() const {
     ShowIDStackToolWindow();
 }
 
+void ProjectCore::Debug::ProfileTimeline::Render() const {
+#ifndef PROFILER_ENABLED
+    TextUnformatted("Profiling is compiled out. Configure with `-DPROFILER_ENABLED=on` to record zones.");
+#endif
+    static std::string SaveMessage;
+    auto &file_dialog = Ctx.FileDialog;
+    if (file_dialog.Data.OwnerId == Id && file_dialog.Data.SaveMode && !file_dialog.SelectedFilePath.empty()) {
+        const fs::path trace_path = file_dialog.SelectedFilePath;
+        file_dialog.SelectedFilePath = "";
+        SaveMessage = Profiler::WriteChromeTrace(trace_path) ? std::format("Saved to {}", fs::absolute(trace_path).string()) : "Failed to save trace.";
+    }
+
+    bool paused = Profiler::IsPaused();
+    if (Checkbox("Pause", &paused)) Profiler::SetPaused(paused);
+    SameLine();
+    SetNextItemWidth(GetFontSize() * 12);
+    SliderFloat("Visible", &VisibleMs, 1, 2000, "%.0f ms", ImGuiSliderFlags_Logarithmic);
+    SameLine();
+    if (Button("Save Chrome trace")) {
+        // Only writes a file, without changing any state, so the dialog is opened directly rather than with an action.
+        file_dialog.Set({
+            .OwnerId = Id,
+            .Title = "Save Chrome trace",
+            .Filters = ".json",
+            .DefaultFileName = "flowgrid_trace.json",
+            .SaveMode = true,
+            .Flags = FileDialogFlags_Modal | FileDialogFlags_ConfirmOverwrite,
+        });
+    }
+    if (!SaveMessage.empty()) {
+        SameLine();
+        TextUnformatted(SaveMessage.c_str());
+    }
+    Text("Dropped zones: %llu", (unsigned long long)Profiler::GetDroppedCount());
+
+    const auto &history = Profiler::GetHistory();
+    uint64_t end_ns = 0;
+    for (const auto &thread : history) {
+        if (!thread.Zones.empty()) end_ns = std::max(end_ns, thread.Zones.back().EndNs);
+    }
+    const uint64_t visible_ns = std::max(uint64_t(VisibleMs * 1'000'000), uint64_t(1));
+    const uint64_t start_ns = end_ns > visible_ns ? end_ns - visible_ns : 0;
+    const auto to_x = [&](float origin_x, float width, uint64_t ns) {
+        return origin_x + width * float(std::clamp(ns, start_ns, end_ns) - start_ns) / float(visible_ns);
+    };
+
+    auto *dl = GetWindowDrawList();
+    const float row_height = GetTextLineHeightWithSpacing(), padding = GetStyle().FramePadding.x;
+    for (const auto &thread : history) {
+        // Zones are ordered by end time, so the visible ones start with the first ending in the visible range.
+        const auto visible_zones = std::ranges::subrange(std::ranges::lower_bound(thread.Zones, start_ns, {}, &Profiler::Zone::EndNs), thread.Zones.end());
+        uint32_t max_depth = 0;
+        for (const auto &zone : visible_zones) max_depth = std::max(max_depth, zone.Depth);
+
+        SeparatorText(thread.ThreadName.c_str());
+        const ImVec2 origin = GetCursorScreenPos();
+        const float width = GetContentRegionAvail().x;
+        PushID(&thread); // Thread names aren't unique.
+        InvisibleButton("##Lane", {width, (max_depth + 1) * row_height});
+        PopID();
+        const bool is_lane_hovered = IsItemHovered();
+        const auto mouse_pos = GetIO().MousePos;
+        for (const auto &zone : visible_zones) {
+            const float x0 = to_x(origin.x, width, zone.StartNs), x1 = std::max(to_x(origin.x, width, zone.EndNs), x0 + 1);
+            const ImVec2 min{x0, origin.y + zone.Depth * row_height}, max{x1, min.y + row_height - 1};
+            const float hue = float(std::hash<std::string_view>{}(zone.Name) % 360) / 360;
+            dl->AddRectFilled(min, max, ImColor::HSV(hue, 0.45f, 0.65f));
+            if (x1 - x0 > padding * 2) {
+                const ImVec4 clip_rect{min.x + padding, min.y, max.x - padding, max.y};
+                dl->AddText(GetFont(), GetFontSize(), {clip_rect.x, min.y}, GetColorU32(ImGuiCol_Text), zone.Name, nullptr, 0, &clip_rect);
+            }
+            if (is_lane_hovered && mouse_pos.x >= min.x && mouse_pos.x < max.x && mouse_pos.y >= min.y && mouse_pos.y < max.y) {
+                SetTooltip("%s: %.3f ms", zone.Name, float(zone.EndNs - zone.StartNs) / 1'000'000);
+            }
+        }
+    }
+}
+
 void ProjectCore::Debug::Metrics::ImGuiMetrics::Render() const { ImGui::ShowMetricsWindow(); }
 void ProjectCore::Debug::Metrics::ImPlotMetrics::Render() const { ImPlot::ShowMetricsWindow(); }
 
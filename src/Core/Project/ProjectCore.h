@@ -111,6 +111,17 @@ struct ProjectCore : ActionableComponent<Action::ProjectCore::Any, Action::Combi
             void Render() const override;
         };
 
+        // Flame-chart timeline of the zones collected by `Profiler`, with a lane per thread.
+        struct ProfileTimeline : Component {
+            using Component::Component;
+
+        protected:
+            void Render() const override;
+
+        private:
+            mutable float VisibleMs{50};
+        };
+
         enum LabelModeType {
             Annotated,
             Raw
@@ -130,6 +141,7 @@ struct ProjectCore : ActionableComponent<Action::ProjectCore::Any, Action::Combi
         Prop(PathUpdateFrequency, PathUpdateFrequency);
         Prop(DebugLog, DebugLog);
         Prop(StackTool, StackTool);
+        Prop_(ProfileTimeline, ProfileTimeline, "Profiler");
         Prop(Metrics, Metrics);
     };
 
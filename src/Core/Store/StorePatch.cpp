@@ -5,6 +5,8 @@
 
 #include "immer/algorithm.hpp"
 
+#include "Core/Profiler.h"
+
 using std::ranges::reverse_view;
 
 // `AddOps` function definitions for all specialized `ValuesT`, to fully implement the `CreatePatch` method.
@@ -129,6 +131,7 @@ void AddOps(const StoreMap<ValueType> &before, const StoreMap<ValueType> &after,
 }
 
 Patch CreatePatch(const PersistentStore &before, const PersistentStore &after, ID base_id) {
+    ProfileZone("CreatePatch");
     // Use template lambda to call `AddOps` for each value type.
     static constexpr auto apply_add_ops = []<typename... Ts>(std::tuple<Ts...>, const PersistentStore &before, const PersistentStore &after, PatchOps &ops) {
         (AddOps(before.GetMap<Ts>(), after.GetMap<Ts>(), ops), ...);
@@ -0,0 +1,218 @@
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+
+using u32 = unsigned int;
+
+/**
+Sorted byte positions at which a value (e.g. a highlight capture) starts, each applying until the next transition.
+Bytes before the first transition have the default value.
+
+Stored as a persistent AVL tree ordered by byte, in which each transition holds its offset from the previous transition
+and each subtree caches the sum of its offsets.
+Absolute positions are never stored, so shifting all transitions after an edit only changes a single offset,
+and copies share all unchanged nodes with the original.
+- Insert, delete, splice, and point lookup: O(log n)
+- Iterating over the k transitions in a byte window: O(log n + k)
+*/
+template<typename ValueType> struct ByteTransitions {
+    struct Node;
+    using NodePtr = std::shared_ptr<const Node>;
+
+    struct Node {
+        Node(NodePtr left, u32 delta, ValueType value, NodePtr right)
+            : Left(std::move(left)), Right(std::move(right)), Delta(delta), Value(std::move(value)),
+              Bytes(ByteSpan(Left) + Delta + ByteSpan(Right)), Count(Size(Left) + 1 + Size(Right)),
+              Height(1 + std::max(ByteTransitions::Height(Left), ByteTransitions::Height(Right))) {}
+
+        const NodePtr Left, Right;
+        const u32 Delta; // Offset from the previous transition, or from byte 0 for the first transition.
+        const ValueType Value;
+        const u32 Bytes; // Sum of all deltas in the subtree, i.e. the position of its last transition relative to the transition before it.
+        const u32 Count, Height;
+    };
+
+    // Positioned at a transition, visiting the following transitions in order.
+    // Only valid as long as the `ByteTransitions` it was created from isn't modified.
+    struct Iterator {
+        // Positioned at the last transition at or before `byte_index`, or before the first transition if there is none.
+        Iterator(const ByteTransitions &transitions, u32 byte_index) : DefaultValue(transitions.DefaultValue) {
+            u32 base = 0;
+            for (const Node *node = transitions.Root.get(); node;) {
+                const u32 position = base + ByteSpan(node->Left) + node->Delta;
+                if (position <= byte_index) {
+                    Current = node;
+                    ByteIndex = base = position;
+                    node = node->Right.get();
+                } else {
+                    Pending.push_back(node);
+                    node = node->Left.get();
+                }
+            }
+        }
+
+        ValueType operator*() const { return Current ? Current->Value : DefaultValue; }
+
+        bool HasNext() const { return !Pending.empty(); }
+        u32 NextByteIndex() const { return HasNext() ? ByteIndex + Pending.back()->Delta : ByteIndex; }
+        // True if positioned at a transition at the given byte.
+        bool IsAt(u32 byte_index) const { return Current && ByteIndex == byte_index; }
+
+        Iterator &operator++() {
+            const auto *node = Pending.back();
+            Pending.pop_back();
+            ByteIndex += node->Delta;
+            Current = node;
+            for (const Node *next = node->Right.get(); next; next = next->Left.get()) Pending.push_back(next);
+            return *this;
+        }
+
+        // Move forward to the last transition at or before the target byte.
+        void MoveForwardTo(u32 target_byte) {
+            while (HasNext() && NextByteIndex() <= target_byte) ++(*this);
+        }
+
+        u32 ByteIndex{0};
+
+    private:
+        const Node *Current{nullptr};
+        std::vector<const Node *> Pending{}; // The following nodes whose right subtrees haven't been visited, nearest last.
+        ValueType DefaultValue;
+    };
+
+    ByteTransitions(ValueType default_value = {}) : DefaultValue(std::move(default_value)) {}
+
+    Iterator begin() const { return {*this, 0}; }
+    Iterator Find(u32 byte_index) const { return {*this, byte_index}; }
+    ValueType At(u32 byte_index) const { return *Find(byte_index); }
+
+    u32 size() const { return Size(Root); }
+    bool empty() const { return !Root; }
+    void clear() { Root = nullptr; }
+
+    // Set the value starting at `byte_index`, replacing any transition already there.
+    void Insert(u32 byte_index, ValueType value) {
+        auto [left, right] = Split(Root, byte_index);
+        const u32 delta = byte_index - ByteSpan(left);
+        if (right && FirstDelta(right) == delta) right = PopFirst(right);
+        if (right) right = WithFirstDelta(right, FirstDelta(right) - delta);
+        Root = Join(std::move(left), std::make_shared<const Node>(nullptr, delta, std::move(value), nullptr), std::move(right));
+    }
+
+    // Delete all transitions in `[start_byte, end_byte)`, leaving the positions of the following transitions unchanged.
+    void Delete(u32 start_byte, u32 end_byte) {
+        if (start_byte >= end_byte) return;
+
+        auto [left, rest] = Split(Root, start_byte);
+        auto [deleted, right] = Split(rest, end_byte - ByteSpan(left));
+        if (right) right = WithFirstDelta(right, FirstDelta(right) + ByteSpan(deleted));
+        Root = Join(std::move(left), std::move(right));
+    }
+
+    // Update transitions for the replacement of bytes `[start_byte, old_end_byte)` with `new_end_byte - start_byte` bytes.
+    // Transitions at or after `old_end_byte` move by the change in length.
+    // Transitions in the replaced range are deleted, and the value at `old_end_byte` continues from `new_end_byte`.
+    void Splice(u32 start_byte, u32 old_end_byte, u32 new_end_byte) {
+        if (start_byte == old_end_byte && old_end_byte == new_end_byte) return;
+
+        auto [left, rest] = Split(Root, start_byte);
+        const u32 left_bytes = ByteSpan(left);
+        auto [replaced, right] = Split(rest, old_end_byte - left_bytes);
+        const u32 replaced_bytes = ByteSpan(replaced);
+        if (replaced && (!right || left_bytes + replaced_bytes + FirstDelta(right) > old_end_byte)) {
+            // The last replaced transition's value continues after the replacement.
+            auto value = LastValue(replaced);
+            if (value != (left ? LastValue(left) : DefaultValue)) {
+                const u32 delta = new_end_byte - left_bytes;
+                if (right) right = WithFirstDelta(right, left_bytes + replaced_bytes + FirstDelta(right) - old_end_byte);
+                left = Join(std::move(left), std::make_shared<const Node>(nullptr, delta, std::move(value), nullptr), nullptr);
+                Root = Join(std::move(left), std::move(right));
+                return;
+            }
+        }
+        if (right) right = WithFirstDelta(right, replaced_bytes + FirstDelta(right) + new_end_byte - old_end_byte);
+        Root = Join(std::move(left), std::move(right));
+    }
+
+    ValueType DefaultValue;
+
+private:
+    static int Height(const NodePtr &node) { return node ? int(node->Height) : 0; }
+    static u32 Size(const NodePtr &node) { return node ? node->Count : 0; }
+    static u32 ByteSpan(const NodePtr &node) { return node ? node->Bytes : 0; }
+
+    static u32 FirstDelta(const NodePtr &node) { return node->Left ? FirstDelta(node->Left) : node->Delta; }
+    static ValueType LastValue(const NodePtr &node) { return node->Right ? LastValue(node->Right) : node->Value; }
+
+    static NodePtr WithFirstDelta(const NodePtr &node, u32 delta) {
+        if (node->Left) return std::make_shared<const Node>(WithFirstDelta(node->Left, delta), node->Delta, node->Value, node->Right);
+        return std::make_shared<const Node>(nullptr, delta, node->Value, node->Right);
+    }
+
+    static std::pair<NodePtr, NodePtr> SplitFirst(const NodePtr &node) {
+        if (!node->Left) return {std::make_shared<const Node>(nullptr, node->Delta, node->Value, nullptr), node->Right};
+
+        auto [first, rest] = SplitFirst(node->Left);
+        return {std::move(first), Join(std::move(rest), node, node->Right)};
+    }
+
+    // Removes the first transition, adding its delta to the next one so the rest keep their positions.
+    static NodePtr PopFirst(const NodePtr &node) {
+        auto [first, rest] = SplitFirst(node);
+        if (rest) rest = WithFirstDelta(rest, FirstDelta(rest) + first->Delta);
+        return rest;
+    }
+
+    static NodePtr Rotate(NodePtr left, const Node &mid, NodePtr right) {
+        return std::make_shared<const Node>(std::move(left), mid.Delta, mid.Value, std::move(right));
+    }
+
+    // Node with subtrees whose heights differ by at most two, rotated if needed to restore balance.
+    static NodePtr Balance(NodePtr left, const Node &mid, NodePtr right) {
+        const int left_height = Height(left), right_height = Height(right);
+        if (left_height > right_height + 1) {
+            if (Height(left->Left) >= Height(left->Right)) return Rotate(left->Left, *left, Rotate(left->Right, mid, std::move(right)));
+            const auto &lr = *left->Right;
+            return Rotate(Rotate(left->Left, *left, lr.Left), lr, Rotate(lr.Right, mid, std::move(right)));
+        }
+        if (right_height > left_height + 1) {
+            if (Height(right->Right) >= Height(right->Left)) return Rotate(Rotate(std::move(left), mid, right->Left), *right, right->Right);
+            const auto &rl = *right->Left;
+            return Rotate(Rotate(std::move(left), mid, rl.Left), rl, Rotate(rl.Right, *right, right->Right));
+        }
+        return Rotate(std::move(left), mid, std::move(right));
+    }
+
+    // Concatenate `left`, `mid`, and `right`, descending the taller tree's inner spine to a subtree of similar height.
+    static NodePtr Join(NodePtr left, const NodePtr &mid, NodePtr right) {
+        if (Height(left) > Height(right) + 1) return Balance(left->Left, *left, Join(left->Right, mid, std::move(right)));
+        if (Height(right) > Height(left) + 1) return Balance(Join(std::move(left), mid, right->Left), *right, right->Right);
+        return Rotate(std::move(left), *mid, std::move(right));
+    }
+    static NodePtr Join(NodePtr left, NodePtr right) {
+        if (!left) return right;
+        if (!right) return left;
+
+        auto [first, rest] = SplitFirst(right);
+        return Join(std::move(left), first, std::move(rest));
+    }
+
+    // Split into the transitions before `byte_index` (relative to the node's base) and the rest.
+    // Deltas are relative to the previous transition, so neither side's deltas change.
+    static std::pair<NodePtr, NodePtr> Split(const NodePtr &node, u32 byte_index) {
+        if (!node) return {};
+
+        const u32 position = ByteSpan(node->Left) + node->Delta;
+        if (byte_index <= position) {
+            auto [left, right] = Split(node->Left, byte_index);
+            return {std::move(left), Join(std::move(right), node, node->Right)};
+        }
+        auto [left, right] = Split(node->Right, byte_index - position);
+        return {Join(node->Left, node, std::move(left)), std::move(right)};
+    }
+
+    NodePtr Root{};
+};
@@ -1,8 +1,11 @@
 #pragma once
 
+#include <atomic>
+#include <optional>
 #include <print>
 #include <ranges>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -12,16 +15,17 @@
 
 #include "Core/HelpInfo.h"
 #include "Core/Helper/Color.h"
+#include "Core/Profiler.h"
 #include "Core/Project/Preferences.h"
 #include "Core/UI/Fonts.h"
 
+#include "ByteTransitions.h"
 #include "LanguageID.h"
+#include "TextBufferReader.h"
 #include "TextInputEdit.h"
 
 using json = nlohmann::json;
 
-using std::views::filter, std::ranges::reverse_view;
-
 // Implemented by the grammar libraries in `lib/tree-sitter-grammars/`.
 extern "C" TSLanguage *tree_sitter_cpp();
 extern "C" TSLanguage *tree_sitter_faust();
@@ -224,133 +228,6 @@ void from_json(const json &j, TSConfig &config) {
     }
 }
 
-template<typename ValueType> struct ByteTransitions {
-    struct DeltaValue {
-        u32 Delta;
-        ValueType Value;
-    };
-
-    struct Iterator {
-        Iterator(const std::vector<DeltaValue> &deltas, ValueType default_value = {})
-            : DeltaValues(deltas), DefaultValue(default_value) {
-        }
-
-        bool HasNext() const { return DeltaIndex < DeltaValues.size() - 1; }
-        bool HasPrev() const { return DeltaIndex > 0; }
-        bool IsEnd() const { return DeltaIndex == DeltaValues.size(); }
-
-        Iterator &operator++() {
-            MoveRight();
-            return *this;
-        }
-        Iterator &operator--() {
-            MoveLeft();
-            return *this;
-        }
-
-        u32 NextByteIndex() const { return HasNext() ? ByteIndex + DeltaValues[DeltaIndex + 1].Delta : ByteIndex; }
-
-        /* Move ops all move until `ByteIndex` is _at or before_ the target byte. */
-        void MoveTo(u32 target_byte) {
-            if (ByteIndex < target_byte) MoveForwardTo(target_byte);
-            else MoveBackTo(target_byte);
-        }
-        void MoveForwardTo(u32 target_byte) {
-            while (ByteIndex < target_byte && !IsEnd() && NextByteIndex() <= target_byte) ++(*this);
-        }
-        void MoveBackTo(u32 target_byte) {
-            while ((ByteIndex > target_byte || (IsEnd() && ByteIndex == target_byte)) && HasPrev()) --(*this);
-        }
-
-        ValueType operator*() const { return !IsEnd() ? DeltaValues[DeltaIndex].Value : DefaultValue; }
-
-        const std::vector<DeltaValue> &DeltaValues;
-        u32 DeltaIndex{0}, ByteIndex{0};
-        ValueType DefaultValue{};
-
-    private:
-        void MoveRight() {
-            if (IsEnd()) throw std::out_of_range("Iterator out of bounds");
-            ++DeltaIndex;
-            if (!IsEnd()) ByteIndex += DeltaValues[DeltaIndex].Delta;
-        }
-        void MoveLeft() {
-            if (!HasPrev()) throw std::out_of_range("Iterator out of bounds");
-            if (!IsEnd()) ByteIndex -= DeltaValues[DeltaIndex].Delta;
-            --DeltaIndex;
-        }
-    };
-
-    ByteTransitions(ValueType default_value = {}) : DefaultValue(default_value) {
-        EnsureStartTransition();
-    }
-
-    void Insert(Iterator &it, u32 byte_index, ValueType value) {
-        it.MoveTo(byte_index);
-        if (it.DeltaIndex > DeltaValues.size()) throw std::out_of_range("Insert iterator out of bounds");
-        if (byte_index < it.ByteIndex) throw std::invalid_argument("Insert byte index is before iterator");
-        if (byte_index == it.ByteIndex && !DeltaValues.empty()) {
-            DeltaValues[it.DeltaIndex].Value = value;
-            if (!it.IsEnd()) ++it;
-            return;
-        }
-
-        const u32 delta = byte_index - it.ByteIndex;
-        if (it.IsEnd()) --it;
-        DeltaValues.insert(DeltaValues.begin() + it.DeltaIndex + 1, {delta, value});
-        ++it;
-        if (it.HasNext()) DeltaValues[it.DeltaIndex + 1].Delta -= delta;
-    }
-
-    // Start is inclusive, end is exclusive.
-    void Delete(Iterator &it, u32 start_byte, u32 end_byte) {
-        it.MoveTo(start_byte);
-        const u32 start_index = start_byte <= it.ByteIndex ? it.DeltaIndex : it.DeltaIndex + 1;
-        it.MoveTo(end_byte - 1);
-        if (it.ByteIndex < start_byte) return;
-
-        if (!it.IsEnd()) ++it;
-        const u32 end_index = it.DeltaIndex;
-
-        // We're now one element after the last element to be deleted.
-        // Merge the deltas of all elements to delete into this element (if we're not past the end).
-        const u32 deleted_delta = std::accumulate(DeltaValues.begin() + start_index, DeltaValues.begin() + end_index, 0u, [](u32 sum, const DeltaValue &dv) { return sum + dv.Delta; });
-        if (!it.IsEnd()) DeltaValues[it.DeltaIndex].Delta += deleted_delta;
-        else it.ByteIndex -= deleted_delta;
-        it.DeltaIndex -= end_index - start_index;
-        DeltaValues.erase(DeltaValues.begin() + start_index, DeltaValues.begin() + end_index);
-        if (EnsureStartTransition()) ++it.DeltaIndex;
-    }
-
-    void Increment(Iterator &it, int amount) {
-        if (amount == 0 || it.IsEnd()) return;
-
-        if (it.DeltaIndex == 0 && it.HasNext()) ++it;
-        DeltaValues[it.DeltaIndex].Delta += amount;
-        it.ByteIndex += amount;
-    }
-
-    auto begin() const { return Iterator(DeltaValues, DefaultValue); }
-    u32 size() const { return DeltaValues.size(); }
-    void clear() {
-        DeltaValues.clear();
-        EnsureStartTransition();
-    }
-
-    std::vector<DeltaValue> DeltaValues;
-    ValueType DefaultValue;
-
-private:
-    bool EnsureStartTransition() {
-        // All documents start by "transitioning" to the default capture (showing the default style).
-        if (DeltaValues.empty() || DeltaValues.front().Delta != 0) {
-            DeltaValues.insert(DeltaValues.begin(), {0, DefaultValue});
-            return true;
-        }
-        return false;
-    }
-};
-
 struct ByteRange {
     u32 Start{0}, End{0};
 
@@ -375,33 +252,71 @@ struct SyntaxNodeAncestry {
     std::vector<SyntaxNode> Ancestry;
 };
 
+// Parsing and highlight queries run on a worker thread, one parse at a time.
+// Edits are applied immediately to the current tree and highlight transitions, which are replaced when the next parse arrives.
+// Edits made while a parse is running are kept and applied to its results, and the latest text is parsed next.
 struct SyntaxTree {
     // todo take language
-    SyntaxTree(TSInput input) : Input(input), Parser(ts_parser_new()) {}
+    SyntaxTree() = default;
     ~SyntaxTree() {
-        if (QueryCursor) ts_query_cursor_delete(QueryCursor);
-        if (Parser) ts_parser_delete(Parser);
+        Job.reset(); // Wait for the running parse, if any.
         if (Tree) ts_tree_delete(Tree);
     }
 
-    // Apply edits to the TS tree, re-parse, update highlight state.
-    void ApplyEdits(const std::ranges::input_range auto &edits) {
-        ChangedCaptureRanges.clear(); // For debugging
+    // Apply edits to the TS tree and highlight transitions, and parse the new `text` in the background.
+    void ApplyEdits(const std::ranges::input_range auto &edits, TextBufferLines text) {
         if (edits.empty()) return;
 
-        if (Tree != nullptr) {
-            for (const auto &edit : edits) {
-                // We only use the byte-based edit fields.
-                const TSInputEdit ts_edit{edit.StartByte, edit.OldEndByte, edit.NewEndByte, {0, 0}, {0, 0}, {0, 0}};
-                ts_tree_edit(Tree, &ts_edit);
-            }
+        ++Version;
+        EditTree(Tree, edits);
+        RebaseCaptureIdTransitions(edits);
+        if (Job) PendingEdits.insert(PendingEdits.end(), edits.begin(), edits.end());
+        PendingText = std::move(text);
+        if (!Job) StartParse();
+    }
+
+    // Discard the tree and parse `text` from scratch in the background.
+    // Used when the text changes without edits relative to the current tree (e.g. undo/redo).
+    void Reparse(TextBufferLines text) {
+        ++Version;
+        if (Tree) ts_tree_delete(Tree);
+        Tree = nullptr;
+        CaptureIdTransitions.clear();
+        PendingEdits.clear();
+        PendingText = std::move(text);
+        if (Job) DiscardJob = true; // Its tree was parsed from an unrelated text.
+        else StartParse();
+    }
+
+    // Adopt the results of the running parse if it's finished. Call on the UI thread, once per project tick.
+    void Update() {
+        if (!Job || !Job->Done) return;
+
+        const auto job = std::move(Job);
+        if (std::exchange(DiscardJob, false)) {
+            PendingEdits.clear(); // Already reflected in the pending text.
+            StartParse();
+            return;
         }
 
-        // const auto *old_tree = Tree; // Partial updating is not fully working yet.
-        Tree = ts_parser_parse(Parser, Tree, Input);
-        UpdateCaptureIdTransitions(edits, nullptr);
+        if (Tree) ts_tree_delete(Tree);
+        Tree = std::exchange(job->Tree, nullptr);
+        CaptureIdTransitions = std::move(job->CaptureIdTransitions);
+        ChangedCaptureRanges = std::move(job->CaptureRanges);
+        ParsedVersion = job->Version;
+
+        // Rebase onto the edits made since the parse started.
+        EditTree(Tree, PendingEdits);
+        RebaseCaptureIdTransitions(PendingEdits);
+        PendingEdits.clear();
+        if (PendingText) StartParse();
     }
 
+    bool IsParsing() const { return bool(Job); }
+    // Whether the tree has been parsed from the latest text, with no edits since.
+    bool IsUpToDate() const { return !Job && ParsedVersion == Version; }
+    bool HasErrors() const { return Tree && ts_node_has_error(ts_tree_root_node(Tree)); }
+
     const LanguageDefinition &GetLanguage() const { return Languages.Get(LanguageId); }
     std::string_view GetLanguageName() const { return GetLanguage().Name; }
 
@@ -417,7 +332,6 @@ struct SyntaxTree {
             Config = {};
         }
         const auto &language = GetLanguage();
-        ts_parser_set_language(Parser, language.TsLanguage);
         Query = language.GetQuery(preferences);
         const u32 capture_count = ts_query_capture_count(Query);
         StyleByCaptureId.clear();
@@ -429,12 +343,19 @@ struct SyntaxTree {
             StyleByCaptureId[i] = Config.FindStyleByCaptureName(std::string(capture_name, length));
         }
 
+        // Results of a parse in the previous language are discarded.
+        Job.reset();
+        DiscardJob = false;
+        PendingEdits.clear();
+        PendingText.reset();
+        if (Tree) ts_tree_delete(Tree);
         Tree = nullptr;
-        QueryCursor = ts_query_cursor_new();
         CaptureIdTransitions.clear();
     }
 
     std::string GetSExp() const {
+        if (!Tree) return "";
+
         char *c_string = ts_node_string(ts_tree_root_node(Tree));
         std::string s_expression(c_string);
         free(c_string);
@@ -442,6 +363,8 @@ struct SyntaxTree {
     }
 
     SyntaxNodeAncestry GetNodeAncestryAtByte(u32 byte_index) const {
+        if (!Tree) return {};
+
         auto cursor = ts_tree_cursor_new(ts_tree_root_node(Tree));
         std::vector<SyntaxNode> ancestors;
         ID id = 0;
@@ -458,79 +381,43 @@ struct SyntaxTree {
 
     inline static u32 NoneCaptureId{u32(-1)}; // Corresponds to the default style.
 
-    TSInput Input;
-    TSConfig Config;
-    TSTree *Tree{nullptr};
-    TSParser *Parser{nullptr};
-    TSQuery *Query{nullptr};
-    TSQueryCursor *QueryCursor{nullptr};
-    std::unordered_map<u32, TextEditorCharStyle> StyleByCaptureId{};
-    ByteTransitions<u32> CaptureIdTransitions{NoneCaptureId};
-    std::set<ByteRange> ChangedCaptureRanges{}; // For debugging.
-    LanguageID LanguageId{LanguageID::None};
-
-private:
-    /**
-    Update capture ID transition points (used for highlighting) based on:
-    - the provided `edits`
-    - the `old_tree` before re-parsing after the edits
-    - the current `Tree` and `Query`
-    If `old_tree != nullptr`, only transitions for the ranges that have changed are updated.
-    Otherwise, the query is executed across the entire document and all capture transitions are added.
-    TODO partial updating is not fully working yet.
-    */
-    void UpdateCaptureIdTransitions(const std::ranges::input_range auto &edits, const TSTree *old_tree = nullptr) {
-        if (edits.empty() || !Query || !Tree) return;
-
-        auto transition_it = CaptureIdTransitions.begin();
-
-        // Find the minimum range needed to span all nodes whose syntactic structure has changed.
-        u32 num_changed_ranges = 0;
-        if (old_tree == nullptr) {
-            CaptureIdTransitions.clear();
-        } else {
-            ByteRange changed_range = {UINT32_MAX, 0u};
-            const TSRange *changed_ranges = ts_tree_get_changed_ranges(old_tree, Tree, &num_changed_ranges);
-            for (u32 i = 0; i < num_changed_ranges; ++i) {
-                changed_range.Start = std::min(changed_range.Start, changed_ranges[i].start_byte);
-                changed_range.End = std::max(changed_range.End, changed_ranges[i].end_byte);
-            }
-            free((void *)changed_ranges);
-
-            if (num_changed_ranges > 0) {
-                ts_query_cursor_set_byte_range(QueryCursor, changed_range.Start, changed_range.End);
-
-                // Note: We don't delete all transitions in this range here, since it might include ancestor nodes
-                // with transitions that are still valid. We delete replaced terminal node ranges in the capture loop below.
-            }
-
-            // Adjust transitions based on the edited ranges, from the end to the start.
-            const auto ordered_edits = std::set<TextInputEdit>(edits.begin(), edits.end());
-            if (CaptureIdTransitions.size() > 1) {
-                for (const auto &edit : reverse_view(ordered_edits)) {
-                    const u32 inc_after_byte = edit.OldEndByte;
-                    transition_it.MoveTo(inc_after_byte);
-                    if (!transition_it.IsEnd()) {
-                        if (transition_it.ByteIndex != inc_after_byte) ++transition_it;
-                        CaptureIdTransitions.Increment(transition_it, edit.NewEndByte - edit.OldEndByte);
-                    }
-                }
-            }
-            // Delete all transitions in deleted ranges.
-            // xxx Not right in all cases. E.g. when deleting the first char of a node.
-            for (const auto &edit : reverse_view(ordered_edits) | filter([](const auto &edit) { return edit.IsDelete(); })) {
-                CaptureIdTransitions.Delete(transition_it, edit.NewEndByte, edit.OldEndByte);
-            }
+    // Parses a snapshot of the text, starting from the (edited) previous tree,
+    // and executes the highlight query across the new tree to find all capture transitions.
+    // Owns its parser, tree, and query cursor, since none of them can be used from more than one thread at a time.
+    struct ParseJob {
+        ParseJob(u32 version, const TSLanguage *language, const TSQuery *query, TSTree *old_tree, TextBufferLines text)
+            : Version(version), Reader(std::move(text)), OldTree(old_tree), Thread([this, language, query] {
+                  ProfileThread("Syntax parse");
+                  ProfileZone("Parse & query");
+                  auto *parser = ts_parser_new();
+                  ts_parser_set_language(parser, language);
+                  Tree = ts_parser_parse(parser, OldTree, Reader.GetInput());
+                  ts_parser_delete(parser);
+                  if (Tree && query) FindCaptureIdTransitions(query);
+                  Done = true;
+              }) {}
+        ~ParseJob() {
+            if (Thread.joinable()) Thread.join();
+            if (OldTree) ts_tree_delete(OldTree);
+            if (Tree) ts_tree_delete(Tree);
         }
 
-        if (old_tree == nullptr || num_changed_ranges > 0) {
-            // Either this is the first parse, or the edit(s) affect existing node captures.
-            // Execute the query and add all capture transitions.
-            ts_query_cursor_exec(QueryCursor, Query, ts_tree_root_node(Tree));
+        const u32 Version;
+        TextBufferReader Reader;
+        TSTree *OldTree, *Tree{nullptr};
+        ByteTransitions<u32> CaptureIdTransitions{NoneCaptureId};
+        std::set<ByteRange> CaptureRanges{};
+        std::atomic<bool> Done{false};
+        std::thread Thread; // Declared last, so it starts after all other members are initialized.
+
+    private:
+        void FindCaptureIdTransitions(const TSQuery *query) {
+            auto *query_cursor = ts_query_cursor_new();
+            ts_query_cursor_exec(query_cursor, query, ts_tree_root_node(Tree));
 
             TSQueryMatch match;
             u32 capture_index;
-            while (ts_query_cursor_next_capture(QueryCursor, &match, &capture_index)) {
+            while (ts_query_cursor_next_capture(query_cursor, &match, &capture_index)) {
                 const TSQueryCapture &capture = match.captures[capture_index];
                 // We only store the points at which there is a _transition_ from one style to another.
                 // This can happen either at the capture node's beginning or end.
@@ -539,19 +426,53 @@ private:
 
                 // Delete invalidated transitions and insert new ones.
                 const auto node_byte_range = ToByteRange(node);
-                ChangedCaptureRanges.insert(node_byte_range); // For debugging.
-                CaptureIdTransitions.Delete(transition_it, node_byte_range.Start, node_byte_range.End);
-                if (*transition_it != capture.index) {
-                    // u32 length;
-                    // const char *capture_name = ts_query_capture_name_for_id(Query, capture.index, &length);
-                    // std::println("\t'{}'[{}:{}]: {}", ts_node_type(node), node_byte_range.Start, node_byte_range.End, string(capture_name, length));
-                    CaptureIdTransitions.Insert(transition_it, node_byte_range.Start, capture.index);
-                    CaptureIdTransitions.Insert(transition_it, node_byte_range.End, NoneCaptureId);
+                CaptureRanges.insert(node_byte_range); // For debugging.
+                CaptureIdTransitions.Delete(node_byte_range.Start, node_byte_range.End);
+                if (CaptureIdTransitions.At(node_byte_range.Start) != capture.index) {
+                    CaptureIdTransitions.Insert(node_byte_range.Start, capture.index);
+                    CaptureIdTransitions.Insert(node_byte_range.End, NoneCaptureId);
                 }
             }
+            ts_query_cursor_delete(query_cursor);
         }
+    };
 
-        // Cleanup: Delete all transitions beyond the new text range.
-        CaptureIdTransitions.Delete(transition_it, ts_node_end_byte(ts_tree_root_node(Tree)), UINT32_MAX);
+    TSConfig Config;
+    TSTree *Tree{nullptr}; // The most recently parsed tree, with all edits since applied.
+    TSQuery *Query{nullptr};
+    std::unordered_map<u32, TextEditorCharStyle> StyleByCaptureId{};
+    ByteTransitions<u32> CaptureIdTransitions{NoneCaptureId};
+    std::set<ByteRange> ChangedCaptureRanges{}; // For debugging.
+    LanguageID LanguageId{LanguageID::None};
+    u32 Version{0}, ParsedVersion{0}; // Incremented for each set of applied edits.
+
+private:
+    static void EditTree(TSTree *tree, const std::ranges::input_range auto &edits) {
+        if (!tree) return;
+
+        for (const auto &edit : edits) {
+            // We only use the byte-based edit fields.
+            const TSInputEdit ts_edit{edit.StartByte, edit.OldEndByte, edit.NewEndByte, {0, 0}, {0, 0}, {0, 0}};
+            ts_tree_edit(tree, &ts_edit);
+        }
     }
+
+    void StartParse() {
+        const auto *language = GetLanguage().TsLanguage;
+        if (!language || !PendingText) return;
+
+        Job = std::make_unique<ParseJob>(Version, language, Query, Tree ? ts_tree_copy(Tree) : nullptr, std::move(*PendingText));
+        PendingText.reset();
+    }
+
+    // Move capture ID transitions (used for highlighting) along with the edited text,
+    // so highlights stay attached to the same text until the next parse's transitions replace them.
+    void RebaseCaptureIdTransitions(const std::ranges::input_range auto &edits) {
+        for (const auto &edit : edits) CaptureIdTransitions.Splice(edit.StartByte, edit.OldEndByte, edit.NewEndByte);
+    }
+
+    std::unique_ptr<ParseJob> Job{};
+    bool DiscardJob{false}; // Set if the text was reparsed from scratch while the job was running.
+    std::vector<TextInputEdit> PendingEdits{}; // Edits applied since the running parse's text snapshot.
+    std::optional<TextBufferLines> PendingText{}; // The latest text, if it hasn't started parsing yet.
 };
@@ -1,6 +1,8 @@
 #include "TextBuffer.h"
 
 #include <array>
+#include <chrono>
+#include <numeric>
 #include <ranges>
 
 #include "imgui_internal.h"
@@ -9,15 +11,20 @@
 
 #include "Core/CoreActionProducer.h"
 #include "Core/FileDialog/FileDialog.h"
+#include "Core/Helper/BackgroundResult.h"
 #include "Core/Helper/File.h"
 #include "Core/Helper/String.h"
 #include "Core/Helper/Time.h"
+#include "Core/Profiler.h"
 #include "Core/Project/ProjectContext.h"
 #include "Core/Store/Store.h"
 #include "Core/UI/Fonts.h"
 #include "Core/Windows.h"
 
 #include "SyntaxTree.h"
+#include "TextBufferBrackets.h"
+#include "TextBufferLineLayout.h"
+#include "TextBufferReader.h"
 
 namespace fs = std::filesystem;
 
@@ -97,13 +104,182 @@ inline static const std::unordered_map<TextBufferPaletteId, const PaletteT &> Pa
     {TextBufferPaletteId::RetroBlue, RetroBluePalette},
 };
 
-const char *TSReadText(void *payload, u32 byte_index, TSPoint position, u32 *bytes_read);
+struct TextBufferParseBenchmarkResult {
+    std::string Input;
+    u32 ByteCount, ReadCount;
+    float ParseMs;
+};
 
-struct TextBufferState {
-    TextBufferState(TextBuffer *buffer) : Syntax(std::make_unique<SyntaxTree>(TSInput{buffer, TSReadText, TSInputEncodingUTF8, nullptr})) {}
+// Measures the time to parse the text from scratch (no previous tree), reading it from the line chunks,
+// and, for reference, from a single contiguous string.
+// The text is repeated until it has at least `min_byte_count` bytes.
+static std::vector<TextBufferParseBenchmarkResult> BenchmarkFullParse(const TSLanguage *language, Lines text, u32 min_byte_count = 10'000'000) {
+    using std::chrono::steady_clock;
+
+    static const auto ByteCount = [](const Lines &lines) {
+        return std::accumulate(lines.begin(), lines.end(), u32(lines.size()) - 1, [](u32 sum, const Line &line) { return sum + line.size(); });
+    };
+    std::vector<TextBufferParseBenchmarkResult> results;
+    if (!language || ByteCount(text) == 0) return results;
+
+    while (ByteCount(text) < min_byte_count) text = text + text;
+
+    auto *parser = ts_parser_new();
+    ts_parser_set_language(parser, language);
+    {
+        TextBufferReader reader{text};
+        const auto start = steady_clock::now();
+        auto *tree = ts_parser_parse(parser, nullptr, reader.GetInput());
+        const float parse_ms = std::chrono::duration<float, std::milli>(steady_clock::now() - start).count();
+        ts_tree_delete(tree);
+        results.push_back({"Line chunks", ByteCount(text), reader.ReadCount, parse_ms});
+    }
+    {
+        std::string contiguous;
+        contiguous.reserve(ByteCount(text));
+        for (u32 li = 0; li < text.size(); ++li) {
+            if (li > 0) contiguous += '\n';
+            immer::for_each_chunk(text[li], [&contiguous](const char *first, const char *last) { contiguous.append(first, last); });
+        }
+        const auto start = steady_clock::now();
+        auto *tree = ts_parser_parse_string(parser, nullptr, contiguous.data(), contiguous.size());
+        const float parse_ms = std::chrono::duration<float, std::milli>(steady_clock::now() - start).count();
+        ts_tree_delete(tree);
+        results.push_back({"Contiguous string", u32(contiguous.size()), 1, parse_ms});
+    }
+    ts_parser_delete(parser);
+    return results;
+}
+
+struct TextBufferEditLogBenchmarkResult {
+    std::string Format;
+    u32 ActionCount, JsonBytes;
+    float ReplayMs;
+};
+
+// Simulates typing a few lines at the end of the buffer, one char per action, and compares saving the typed text as
+// the typed commands, as the full text after each command, and as the single merged `ApplyEdits` action it's saved as.
+// Measures the size of each format's serialized actions, and the time to replay them from JSON onto the original buffer.
+static std::vector<TextBufferEditLogBenchmarkResult> BenchmarkEditLogFormats(Buffer b, bool auto_indent) {
+    using namespace Action::TextBuffer;
+    using std::chrono::steady_clock;
+
+    static constexpr std::string_view Typed{"int main() {\n    return 0;\n}\n"};
+    static constexpr u32 RepeatCount = 10;
+
+    b.Edits = {};
+    b = b.MoveCursorsBottom(false);
+    const auto start_buffer = b;
+    std::vector<EnterChar> commands;
+    std::vector<SetText> texts;
+    std::optional<ApplyEdits> merged;
+    for (u32 i = 0; i < RepeatCount; ++i) {
+        for (const char ch : Typed) {
+            commands.push_back({0, ImWchar(ch)});
+            b = b.EnterChar(ImWchar(ch), auto_indent);
+            texts.push_back({0, b.GetText()});
+            const ApplyEdits edits{0, b.GetDeltas(), b.Cursors | to<std::vector>()};
+            b.Edits = {};
+            merged = merged ? std::get<ApplyEdits>(merged->Merge(edits)) : edits;
+        }
+    }
+
+    const auto measure = [&start_buffer](std::string format, const auto &actions, auto &&replay) -> TextBufferEditLogBenchmarkResult {
+        const std::string serialized = json(actions).dump();
+        const auto start = steady_clock::now();
+        auto replayed = start_buffer;
+        for (const auto &action : json::parse(serialized).get<std::decay_t<decltype(actions)>>()) replayed = replay(replayed, action);
+        const float replay_ms = std::chrono::duration<float, std::milli>(steady_clock::now() - start).count();
+        return {std::move(format), u32(actions.size()), u32(serialized.size()), replay_ms};
+    };
+    return {
+        measure("Commands", commands, [auto_indent](const Buffer &b, const EnterChar &a) { return b.EnterChar(a.value, auto_indent); }),
+        measure("Full text", texts, [](const Buffer &b, const SetText &a) { return b.SetText(a.value); }),
+        measure("Merged edits", std::vector{*merged}, [](const Buffer &b, const ApplyEdits &a) {
+            return b.ApplyDeltas(a.deltas).SetCursors({a.cursors.begin(), a.cursors.end()});
+        }),
+    };
+}
 
-    std::unique_ptr<SyntaxTree> Syntax;
+struct TextBufferMultiCursorBenchmarkResult {
+    std::string Edit;
+    float PerCursorMs, BatchedMs, ApplyEditsMs;
+};
+
+// Applies multi-cursor edits to `line_count` lines of generated text, with cursors spread evenly over `cursor_count` lines.
+// Compares applying each edit one cursor at a time (last cursor first, updating the text and all cursors for each)
+// with applying it to all cursors in a single pass.
+// Also times applying the batched edit's `ApplyEdits` action (as when replaying a saved project), from its deltas.
+static std::vector<TextBufferMultiCursorBenchmarkResult> BenchmarkBatchedEdits(u32 line_count = 10'000, u32 cursor_count = 1'000) {
+    using std::chrono::steady_clock;
+
+    std::string text;
+    for (u32 li = 0; li < line_count; ++li) text += std::format("    int value_{} = {};\n", li, li * 7);
+    Buffer b = Buffer{}.SetText(text);
+    b.Edits = {};
+    immer::vector_transient<Cursor> cursors;
+    for (u32 i = 0; i < cursor_count; ++i) cursors.push_back(LineChar{i * (line_count / cursor_count), 8});
+    b = b.SetCursors(cursors.persistent());
+
+    const auto measure = [&b](std::string edit, auto &&per_cursor, auto &&batched) -> TextBufferMultiCursorBenchmarkResult {
+        auto start = steady_clock::now();
+        per_cursor(b);
+        const float per_cursor_ms = std::chrono::duration<float, std::milli>(steady_clock::now() - start).count();
+        start = steady_clock::now();
+        const Buffer edited = batched(b);
+        const float batched_ms = std::chrono::duration<float, std::milli>(steady_clock::now() - start).count();
+
+        const Action::TextBuffer::ApplyEdits apply_edits{0, edited.GetDeltas(), edited.Cursors | to<std::vector>()};
+        start = steady_clock::now();
+        b.ApplyDeltas(apply_edits.deltas).SetCursors({apply_edits.cursors.begin(), apply_edits.cursors.end()});
+        const float apply_edits_ms = std::chrono::duration<float, std::milli>(steady_clock::now() - start).count();
+        return {std::move(edit), per_cursor_ms, batched_ms, apply_edits_ms};
+    };
+    const Lines pasted{{'/', '/'}, {'/', '/'}};
+    return {
+        measure(
+            "Enter char",
+            [](Buffer b) {
+                for (int i = b.Cursors.size() - 1; i > -1; --i) b = b.InsertAtCursor({{'x'}}, i);
+                return b;
+            },
+            [](const Buffer &b) { return b.EnterChar('x'); }
+        ),
+        measure(
+            "Backspace",
+            [](Buffer b) {
+                b = b.MoveCursorsChar(false, true);
+                for (int i = b.Cursors.size() - 1; i > -1; --i) b = b.DeleteSelection(i);
+                return b;
+            },
+            [](const Buffer &b) { return b.Backspace(); }
+        ),
+        measure(
+            "Paste two lines",
+            [&pasted](Buffer b) {
+                for (int i = b.Cursors.size() - 1; i > -1; --i) b = b.InsertAtCursor(pasted, i);
+                return b;
+            },
+            [&pasted](const Buffer &b) { return b.Paste(pasted); }
+        ),
+        measure(
+            "Indent lines",
+            [](Buffer b) {
+                for (int i = b.Cursors.size() - 1; i > -1; --i) b = b.Insert({{'\t'}}, {b.Cursors[i].Line(), 0}).first;
+                return b;
+            },
+            [](const Buffer &b) { return b.ChangeCurrentLinesIndentation(true); }
+        ),
+    };
+}
+
+struct TextBufferState {
+    std::unique_ptr<SyntaxTree> Syntax{std::make_unique<SyntaxTree>()};
     std::unique_ptr<SyntaxNodeAncestry> HoveredNode{};
+    TextBufferBrackets Brackets{};
+    // By `TextBufferLineLayout::Key`, so a line keeps its layout when lines above it are edited, inserted, or removed,
+    // and identical lines share one layout. Entries are only valid for lines they were built for.
+    std::unordered_map<size_t, TextBufferLineLayout> LineLayouts{};
 
     ImVec2 ContentDims{0, 0}; // Pixel width/height of current content area.
     Coords ContentCoordDims{0, 0}; // Coords width/height of current content area.
@@ -112,48 +288,47 @@ struct TextBufferState {
     float LastClickTime{-1}; // ImGui time.
     // Cleared every frame. Used to keep recently edited cursors visible.
     std::unordered_set<u32> StartEdited{}, EndEdited{};
-};
 
-const char *TSReadText(void *payload, u32 byte_index, TSPoint position, u32 *bytes_read) {
-    (void)byte_index; // Unused.
-    static constexpr char newline = '\n';
+    size_t LastOpenBytes{0};
+    float LastOpenMs{0};
+    // Benchmarks run on background threads, and their results are rendered once they're done.
+    BackgroundResult<std::vector<TextBufferParseBenchmarkResult>> ParseBenchmarkResults{};
+    BackgroundResult<std::vector<TextBufferEditLogBenchmarkResult>> EditLogBenchmarkResults{};
+    BackgroundResult<std::vector<TextBufferMultiCursorBenchmarkResult>> MultiCursorBenchmarkResults{};
 
-    const auto *buffer = static_cast<TextBuffer *>(payload);
-    const auto buffer_data = buffer->GetBuffer();
-    if (position.row >= buffer_data.LineCount()) {
-        *bytes_read = 0;
-        return nullptr;
-    }
-    const auto &line = buffer_data.GetLine(position.row);
-    if (position.column > line.size()) { // Sanity check - shouldn't happen.
-        *bytes_read = 0;
-        return nullptr;
-    }
-    if (position.column == line.size()) {
-        *bytes_read = 1;
-        return &newline;
-    }
+    // Find/replace bar
+    bool ShowFind{false}, FocusFind{false};
+    std::array<char, 256> FindPattern{}, ReplaceText{};
+    bool FindCaseSensitive{true}, FindRegex{false};
 
-    // Read until the end of the line.
-    *bytes_read = line.size() - position.column;
-    return &line.front() + position.column;
-}
+    // The text the syntax tree was last edited or parsed to.
+    // A refreshed buffer with a different text was restored by undo/redo, and its edits don't apply to the current tree.
+    TextBufferLines SyntaxText{};
+
+    // The buffer made by the command `Resolve` evaluated, committed by the following `Apply`.
+    std::optional<Buffer> ResolvedBuffer{};
+};
 
 TextBuffer::TextBuffer(ComponentArgs &&args, const fs::path &file_path)
     : Component(std::move(args)), _LastOpenedFilePath(file_path),
-      State(std::make_unique<TextBufferState>(this)),
+      State(std::make_unique<TextBufferState>()),
       Q([this](auto &&action) {
           return std::visit([this](auto &&a) { return Ctx.Q(std::move(a)); }, std::move(action));
       }) {
     SetFilePath(file_path);
     // if (Exists()) Refresh();
-    Commit(_S, TextBufferData{}.SetText(std::string(FileIO::read(file_path))));
+    Commit(_S, TextBufferData{}.SetText(FileIO::MappedFile{file_path}.View()));
+    RegisterTickListener(this);
 }
 
 TextBuffer::~TextBuffer() {
+    UnregisterTickListener(this);
     Erase(_S);
 }
 
+void TextBuffer::OnTick() { State->Syntax->Update(); }
+bool TextBuffer::IsBusy() const { return State->Syntax->IsParsing(); }
+
 bool TextBuffer::CanApply(const ActionType &action) const {
     using namespace Action::TextBuffer;
 
@@ -169,6 +344,7 @@ bool TextBuffer::CanApply(const ActionType &action) const {
             [this](const MoveCurrentLines &) { return !ReadOnly; },
             [this](const ToggleLineComment &) { return !ReadOnly && !State->Syntax->GetLanguage().SingleLineComment.empty(); },
             [this](const EnterChar &) { return !ReadOnly; },
+            [this](const ReplaceAll &) { return !ReadOnly; },
             [](auto &&) { return true; },
         },
         action
@@ -189,45 +365,95 @@ static Lines GetClipboardLines() {
     return text.persistent();
 }
 
+std::optional<Buffer> TextBuffer::ApplyCommand(const Buffer &b, const ActionType &action) const {
+    using namespace Action::TextBuffer;
+
+    return std::visit<std::optional<Buffer>>(
+        Match{
+            [&b](const SetCursor &a) { return b.SetCursor(a.lc, a.add); },
+            [&b](const SetCursorRange &a) { return b.SetCursor(a.lcr, a.add); },
+            [&b](const MoveCursorsLines &a) { return b.MoveCursorsLines(a.amount, a.select); },
+            [this, &b](const PageCursorsLines &a) { return b.MoveCursorsLines((State->ContentCoordDims.L - 2) * (a.up ? -1 : 1), a.select); },
+            [&b](const MoveCursorsChar &a) { return b.MoveCursorsChar(a.right, a.select, a.word); },
+            [&b](const MoveCursorsTop &a) { return b.MoveCursorsTop(a.select); },
+            [&b](const MoveCursorsBottom &a) { return b.MoveCursorsBottom(a.select); },
+            [&b](const MoveCursorsStartLine &a) { return b.MoveCursorsStartLine(a.select); },
+            [&b](const MoveCursorsEndLine &a) { return b.MoveCursorsEndLine(a.select); },
+            [&b](const SelectAll &) { return b.SelectAll(); },
+            [&b](const SelectNextOccurrence &) { return b.SelectNextOccurrence(); },
+            [&b](const SelectAllOccurrences &) { return b.SelectAllOccurrences(); },
+            [&b](const SelectAllMatches &a) { return b.SelectAll({a.pattern, a.case_sensitive, a.regex}); },
+            [&b](const SetText &a) { return b.SetText(a.value); },
+            [&b](const Cut &) {
+                const auto str = b.GetSelectedText();
+                ImGui::SetClipboardText(str.c_str());
+                return b.DeleteSelections();
+            },
+            [&b](const Paste &) { return b.Paste(GetClipboardLines()); },
+            [&b](const Delete &a) { return b.Delete(a.word); },
+            [&b](const Backspace &a) { return b.Backspace(a.word); },
+            [&b](const DeleteCurrentLines &) { return b.DeleteCurrentLines(); },
+            [&b](const ChangeCurrentLinesIndentation &a) { return b.ChangeCurrentLinesIndentation(a.increase); },
+            [&b](const MoveCurrentLines &a) { return b.MoveCurrentLines(a.up); },
+            [this, &b](const ToggleLineComment &) { return b.ToggleLineComment(State->Syntax->GetLanguage().SingleLineComment); },
+            [this, &b](const EnterChar &a) { return b.EnterChar(a.value, AutoIndent); },
+            [&b](const ReplaceAll &a) { return b.ReplaceAll({a.pattern, a.case_sensitive, a.regex}, a.replacement); },
+            [](auto &&) { return std::optional<Buffer>{}; },
+        },
+        action
+    );
+}
+
+std::optional<TextBuffer::ActionType> TextBuffer::Resolve(const ActionType &action) const {
+    using namespace Action::TextBuffer;
+
+    const auto command = std::holds_alternative<LegacyCommand>(action) ? ParseLegacyCommand(std::get<LegacyCommand>(action)) : action;
+    if (!CanApply(command)) return {};
+
+    // Only keep the edits made by this command.
+    auto b = GetBuffer();
+    b.Edits = {};
+    auto next = ApplyCommand(b, command);
+    if (!next) return command;
+
+    const bool edited = !next->Edits.empty();
+    auto resolved = edited ? ActionType{ApplyEdits{Id, next->GetDeltas(), next->Cursors | to<std::vector>()}} : command;
+    State->ResolvedBuffer = std::move(*next);
+    return resolved;
+}
+
 void TextBuffer::Apply(TransientStore &s, const ActionType &action) const {
     using namespace Action::TextBuffer;
 
+    // The command was already evaluated when it was resolved.
+    if (State->ResolvedBuffer) return Commit(s, *std::exchange(State->ResolvedBuffer, std::nullopt));
+
+    // Only keep the edits made by this action.
+    auto b = GetBuffer();
+    b.Edits = {};
+    if (auto next = ApplyCommand(b, action)) return Commit(s, std::move(*next));
+
     std::visit(
         Match{
-            // Buffer-affecting actions
-            [this, &s](const SetCursor &a) { Commit(s, GetBuffer().SetCursor(a.lc, a.add)); },
-            [this, &s](const SetCursorRange &a) { Commit(s, GetBuffer().SetCursor(a.lcr, a.add)); },
-            [this, &s](const MoveCursorsLines &a) { Commit(s, GetBuffer().MoveCursorsLines(a.amount, a.select)); },
-            [this, &s](const PageCursorsLines &a) { Commit(s, GetBuffer().MoveCursorsLines((State->ContentCoordDims.L - 2) * (a.up ? -1 : 1), a.select)); },
-            [this, &s](const MoveCursorsChar &a) { Commit(s, GetBuffer().MoveCursorsChar(a.right, a.select, a.word)); },
-            [this, &s](const MoveCursorsTop &a) { Commit(s, GetBuffer().MoveCursorsTop(a.select)); },
-            [this, &s](const MoveCursorsBottom &a) { Commit(s, GetBuffer().MoveCursorsBottom(a.select)); },
-            [this, &s](const MoveCursorsStartLine &a) { Commit(s, GetBuffer().MoveCursorsStartLine(a.select)); },
-            [this, &s](const MoveCursorsEndLine &a) { Commit(s, GetBuffer().MoveCursorsEndLine(a.select)); },
-            [this, &s](const SelectAll &) { Commit(s, GetBuffer().SelectAll()); },
-            [this, &s](const SelectNextOccurrence &) { Commit(s, GetBuffer().SelectNextOccurrence()); },
-            [this, &s](const SetText &a) { Commit(s, GetBuffer().SetText(a.value)); },
-            [this](const Copy &) {
-                const auto str = GetBuffer().GetSelectedText();
-                ImGui::SetClipboardText(str.c_str());
+            [this, &s, &b](const ApplyEdits &a) {
+                Commit(s, b.ApplyDeltas(a.deltas).SetCursors({a.cursors.begin(), a.cursors.end()}));
             },
-            [this, &s](const Cut &) {
-                const auto str = GetBuffer().GetSelectedText();
+            [this, &s, &b](const LegacyCommand &a) {
+                if (auto next = ApplyCommand(b, ParseLegacyCommand(a))) Commit(s, std::move(*next));
+            },
+            [&b](const Copy &) {
+                const auto str = b.GetSelectedText();
                 ImGui::SetClipboardText(str.c_str());
-                Commit(s, GetBuffer().DeleteSelections());
             },
-            [this, &s](const Paste &) { Commit(s, GetBuffer().Paste(GetClipboardLines())); },
-            [this, &s](const Delete &a) { Commit(s, GetBuffer().Delete(a.word)); },
-            [this, &s](const Backspace &a) { Commit(s, GetBuffer().Backspace(a.word)); },
-            [this, &s](const DeleteCurrentLines &) { Commit(s, GetBuffer().DeleteCurrentLines()); },
-            [this, &s](const ChangeCurrentLinesIndentation &a) { Commit(s, GetBuffer().ChangeCurrentLinesIndentation(a.increase)); },
-            [this, &s](const MoveCurrentLines &a) { Commit(s, GetBuffer().MoveCurrentLines(a.up)); },
-            [this, &s](const ToggleLineComment &) { Commit(s, GetBuffer().ToggleLineComment(State->Syntax->GetLanguage().SingleLineComment)); },
-            [this, &s](const EnterChar &a) { Commit(s, GetBuffer().EnterChar(a.value, AutoIndent)); },
-            [this, &s](const Open &a) {
+            [this, &s, &b](const Open &a) {
                 LastOpenedFilePath.Set(s, a.file_path.c_str());
                 SetFilePath(a.file_path);
-                Commit(s, GetBuffer().SetText(FileIO::read(a.file_path)));
+                // Lines are built straight from the mapped file, without reading it into an intermediate string.
+                const auto start = std::chrono::steady_clock::now();
+                const FileIO::MappedFile file{a.file_path};
+                Commit(s, b.SetText(file.View()));
+                State->LastOpenBytes = file.View().size();
+                State->LastOpenMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
             },
             // Non-buffer actions
             [this](const ShowOpenDialog &) {
@@ -250,6 +476,12 @@ void TextBuffer::Apply(TransientStore &s, const ActionType &action) const {
                 });
             },
             [this](const Save &a) { FileIO::write(a.file_path, GetBuffer().GetText()); },
+            [this](const BenchmarkParse &) {
+                State->ParseBenchmarkResults.Start([language = State->Syntax->GetLanguage().TsLanguage, text = GetBuffer().Text] { return BenchmarkFullParse(language, text); });
+            },
+            [this, &b](const BenchmarkEditLog &) { State->EditLogBenchmarkResults.Start([b, auto_indent = bool(AutoIndent)] { return BenchmarkEditLogFormats(b, auto_indent); }); },
+            [this](const BenchmarkMultiCursorEdits &) { State->MultiCursorBenchmarkResults.Start([] { return BenchmarkBatchedEdits(); }); },
+            [](auto &&) {}, // Buffer commands, handled above.
         },
         action
     );
@@ -258,13 +490,21 @@ void TextBuffer::Apply(TransientStore &s, const ActionType &action) const {
 // todo: Need a way to merge cursor-only edits, and skip over cursor-only buffer changes when undoing/redoing.
 void TextBuffer::Commit(TransientStore &s, TextBufferData b) const {
     s.Set(Id, b);
-    State->Syntax->ApplyEdits(b.Edits);
+    // Edits are only applied here, when they're made. Refreshing to a restored buffer reparses it instead.
+    State->Syntax->ApplyEdits(b.Edits, b.Text);
+    State->SyntaxText = b.Text;
     // b.Edits = {};
 }
 
 Buffer TextBuffer::GetBuffer() const { return S.Get<Buffer>(Id); }
 std::string TextBuffer::GetText() const { return GetBuffer().GetText(); }
 bool TextBuffer::Empty() const { return GetBuffer().Empty(); }
+std::optional<bool> TextBuffer::HasSyntaxErrors() const {
+    const auto &syntax = *State->Syntax;
+    if (syntax.LanguageId == LanguageID::None) return false;
+    if (!syntax.IsUpToDate()) return {};
+    return syntax.HasErrors();
+}
 
 static bool IsPressed(ImGuiKeyChord chord) {
     const auto window_id = ImGui::GetCurrentWindowRead()->ID;
@@ -303,6 +543,7 @@ std::optional<TextBuffer::ActionType> TextBuffer::ProduceKeyboardAction() const
     if (IsPressed(ImGuiMod_Shift | ImGuiKey_End)) return MoveCursorsEndLine{.component_id = Id, .select = true};
     if (IsPressed(ImGuiMod_Ctrl | ImGuiKey_A)) return SelectAll{Id};
     if (IsPressed(ImGuiMod_Ctrl | ImGuiKey_D)) return SelectNextOccurrence{Id};
+    if (IsPressed(ImGuiMod_Shift | ImGuiMod_Ctrl | ImGuiKey_L)) return SelectAllOccurrences{Id};
     // cut/copy/paste
     if (IsPressed(ImGuiMod_Ctrl | ImGuiKey_Insert) || IsPressed(ImGuiMod_Ctrl | ImGuiKey_C)) return Copy{Id};
     if (IsPressed(ImGuiMod_Shift | ImGuiKey_Insert) || IsPressed(ImGuiMod_Ctrl | ImGuiKey_V)) return Paste{Id};
@@ -493,13 +734,35 @@ std::optional<TextBuffer::ActionType> TextBuffer::Render(const TextBufferData &b
 
     const auto mouse_action = HandleMouseInputs(b, char_advance, text_start_x);
 
+    // Find the bracket at (either side of) the cursor and its match, indexing the brackets if the text changed.
+    std::optional<std::pair<u32, u32>> matching_brackets;
+    if (b.Cursors.size() == 1 && !b.Cursors.front().IsRange()) {
+        if (State->Brackets.Text != b.Text) State->Brackets = TextBufferBrackets{b.Text};
+        const auto lc = b.Cursors.front().LC();
+        const u32 cursor_byte = b.ToByteIndex(lc);
+        if (const auto match = lc.C > 0 ? State->Brackets.FindMatch(cursor_byte - 1) : std::nullopt) {
+            matching_brackets = {cursor_byte - 1, *match};
+        } else if (const auto match = State->Brackets.FindMatch(cursor_byte)) {
+            matching_brackets = {cursor_byte, *match};
+        }
+    }
+
+    std::unordered_set<size_t> visible_layout_keys;
     u32 max_column = 0;
     auto dl = GetWindowDrawList();
-    auto transition_it = State->Syntax->CaptureIdTransitions.begin();
+    const auto &syntax = *State->Syntax;
     for (u32 li = first_visible_coords.L, byte_index = b.ToByteIndex({first_visible_coords.L, 0});
          li <= last_visible_coords.L && li < b.Text.size(); ++li) {
         const auto &line = b.Text[li];
-        const u32 line_max_column = b.GetLineMaxColumn(line, last_visible_coords.C);
+        const size_t transitions_hash = TextBufferLineLayout::HashTransitions(syntax.CaptureIdTransitions, byte_index, byte_index + line.size());
+        const size_t layout_key = TextBufferLineLayout::Key(TextBufferLineLayout::HashLine(line), transitions_hash);
+        visible_layout_keys.insert(layout_key);
+        auto layout_it = State->LineLayouts.find(layout_key);
+        if (layout_it == State->LineLayouts.end() || !layout_it->second.IsFor(line, transitions_hash)) {
+            layout_it = State->LineLayouts.insert_or_assign(layout_key, TextBufferLineLayout{line, byte_index, syntax.CaptureIdTransitions}).first;
+        }
+        const auto &layout = layout_it->second;
+        const u32 line_max_column = layout.MaxColumn();
         max_column = std::max(line_max_column, max_column);
 
         const ImVec2 line_start_screen_pos{cursor_screen_pos.x, cursor_screen_pos.y + li * char_advance.y};
@@ -540,24 +803,40 @@ std::optional<TextBuffer::ActionType> TextBuffer::Render(const TextBufferData &b
             }
 
             for (const auto &c : filter(b.Cursors, [li](const auto &c) { return c.Line() == li; })) {
-                const u32 ci = c.CharIndex(), column = b.GetColumn(line, ci);
+                const u32 ci = c.CharIndex(), column = layout.Columns[std::min(ci, u32(line.size()))];
                 const float width = !Overwrite || ci >= line.size() ? 1.f : (line[ci] == '\t' ? GTextBufferStyle.NumTabSpacesAtColumn(column) : 1) * char_advance.x;
                 const ImVec2 pos{text_screen_x + column * char_advance.x, line_start_screen_pos.y};
                 dl->AddRectFilled(pos, pos + ImVec2{width, char_advance.y}, GetColor(PaletteIndex::Cursor));
             }
         }
 
-        // Render colorized text
-        const u32 line_start_byte_index = byte_index, start_ci = b.GetFirstVisibleCharIndex(line, first_visible_coords.C);
-        byte_index += start_ci;
-        transition_it.MoveForwardTo(byte_index);
-        for (u32 ci = start_ci, column = first_visible_coords.C; ci < line.size() && column <= last_visible_coords.C;) {
-            const auto lc = LineChar{li, ci};
-            const ImVec2 glyph_pos = line_start_screen_pos + ImVec2{text_start_x + column * char_advance.x, 0};
-            const char ch = line[lc.C];
-            const u32 seq_length = UTF8CharLength(ch);
-            if (ch == '\t') {
-                if (ShowWhitespaces) {
+        // Render colorized text, one draw call per run, trimmed to the visible columns.
+        // Runs of single-byte chars take one column per char, and multi-byte chars have their own single-column runs.
+        const auto column_pos = [&](u32 column) { return line_start_screen_pos + ImVec2{text_start_x + column * char_advance.x, 0}; };
+        const u32 first_visible_column = first_visible_coords.C, last_visible_column = last_visible_coords.C;
+        for (const auto &run : layout.Runs) {
+            if (run.EndColumn <= first_visible_column) continue;
+            if (run.StartColumn > last_visible_column) break;
+
+            const bool is_multibyte = run.EndColumn - run.StartColumn < run.Text.size();
+            const u32 start_column = is_multibyte ? run.StartColumn : std::max(run.StartColumn, first_visible_column);
+            const u32 end_column = is_multibyte ? run.EndColumn : std::min(run.EndColumn, last_visible_column + 1);
+            const char *run_start = run.Text.data() + (start_column - run.StartColumn);
+            const char *run_end = is_multibyte ? run.Text.data() + run.Text.size() : run_start + (end_column - start_column);
+            const auto &style = syntax.StyleByCaptureId.at(run.CaptureId);
+            const bool font_changed = Fonts::Push(FontFamily::Monospace, style.Font);
+            dl->AddText(column_pos(start_column), style.Color, run_start, run_end);
+            if (font_changed) Fonts::Pop();
+        }
+
+        const u32 start_ci = layout.CharIndexAtColumn(first_visible_column);
+        if (ShowWhitespaces) {
+            for (auto it = std::ranges::lower_bound(layout.WhitespaceCharIndices, start_ci); it != layout.WhitespaceCharIndices.end(); ++it) {
+                const u32 column = layout.Columns[*it];
+                if (column > last_visible_column) break;
+
+                const ImVec2 glyph_pos = column_pos(column);
+                if (line[*it] == '\t') {
                     const float gap = font_size * (ShortTabs ? 0.16f : 0.2f);
                     const ImVec2 p1{glyph_pos + ImVec2{char_advance.x * 0.3f, font_height * 0.5f}};
                     const ImVec2 p2{glyph_pos.x + char_advance.x * (ShortTabs ? (GTextBufferStyle.NumTabSpacesAtColumn(column) - 0.3f) : 1.f), p1.y};
@@ -565,43 +844,44 @@ std::optional<TextBuffer::ActionType> TextBuffer::Render(const TextBufferData &b
                     dl->AddLine(p1, p2, color);
                     dl->AddLine(p2, {p2.x - gap, p1.y - gap}, color);
                     dl->AddLine(p2, {p2.x - gap, p1.y + gap}, color);
-                }
-            } else if (ch == ' ') {
-                if (ShowWhitespaces) {
+                } else {
                     dl->AddCircleFilled(glyph_pos + ImVec2{font_width, font_size} * 0.5f, 1.5f, GetColor(PaletteIndex::ControlCharacter), 4);
                 }
-            } else {
-                if (seq_length == 1 && b.Cursors.size() == 1) {
-                    if (const auto matching_brackets = b.FindMatchingBrackets(b.Cursors.front())) {
-                        if (matching_brackets->Start == lc || matching_brackets->End == lc) {
-                            const ImVec2 start{glyph_pos + ImVec2{0, font_height + 1.0f}};
-                            dl->AddRectFilled(start, start + ImVec2{char_advance.x, 1.0f}, GetColor(PaletteIndex::Cursor));
-                        }
-                    }
-                }
-                // Render the current character.
-                const auto &char_style = State->Syntax->StyleByCaptureId.at(*transition_it);
-                const bool font_changed = Fonts::Push(FontFamily::Monospace, char_style.Font);
-                const char *seq_begin = &line[ci];
-                dl->AddText(glyph_pos, char_style.Color, seq_begin, seq_begin + seq_length);
-                if (font_changed) Fonts::Pop();
             }
-            if (ShowStyleTransitionPoints && !transition_it.IsEnd() && transition_it.ByteIndex == byte_index) {
-                const auto color = SetAlpha(State->Syntax->StyleByCaptureId.at(*transition_it).Color, 40);
-                dl->AddRectFilled(glyph_pos, glyph_pos + char_advance, color);
+        }
+        if (matching_brackets) {
+            for (const u32 bracket_byte : {matching_brackets->first, matching_brackets->second}) {
+                if (bracket_byte < byte_index || bracket_byte >= byte_index + line.size()) continue;
+
+                const ImVec2 start{column_pos(layout.Columns[bracket_byte - byte_index]) + ImVec2{0, font_height + 1.0f}};
+                dl->AddRectFilled(start, start + ImVec2{char_advance.x, 1.0f}, GetColor(PaletteIndex::Cursor));
             }
-            if (ShowChangedCaptureRanges) {
-                for (const auto &range : State->Syntax->ChangedCaptureRanges) {
-                    if (byte_index >= range.Start && byte_index < range.End) {
-                        dl->AddRectFilled(glyph_pos, glyph_pos + char_advance, Col32(255, 255, 255, 20));
+        }
+        if (ShowStyleTransitionPoints || ShowChangedCaptureRanges) {
+            auto transition_it = syntax.CaptureIdTransitions.Find(byte_index + start_ci);
+            for (u32 ci = start_ci; ci < line.size() && layout.Columns[ci] <= last_visible_column; ci += UTF8CharLength(line[ci])) {
+                const u32 char_byte_index = byte_index + ci;
+                const ImVec2 glyph_pos = column_pos(layout.Columns[ci]);
+                transition_it.MoveForwardTo(char_byte_index);
+                if (ShowStyleTransitionPoints && transition_it.IsAt(char_byte_index)) {
+                    const auto color = SetAlpha(syntax.StyleByCaptureId.at(*transition_it).Color, 40);
+                    dl->AddRectFilled(glyph_pos, glyph_pos + char_advance, color);
+                }
+                if (ShowChangedCaptureRanges) {
+                    for (const auto &range : syntax.ChangedCaptureRanges) {
+                        if (char_byte_index >= range.Start && char_byte_index < range.End) {
+                            dl->AddRectFilled(glyph_pos, glyph_pos + char_advance, Col32(255, 255, 255, 20));
+                        }
                     }
                 }
             }
-            std::tie(ci, column) = b.NextCharIndexAndColumn(line, ci, column);
-            byte_index += seq_length;
-            transition_it.MoveForwardTo(byte_index);
         }
-        byte_index = line_start_byte_index + line.size() + 1; // + 1 for the newline character.
+        byte_index += line.size() + 1; // + 1 for the newline character.
+    }
+
+    // Drop cached layouts no longer used by any visible line.
+    if (State->LineLayouts.size() > 4 * visible_layout_keys.size()) {
+        std::erase_if(State->LineLayouts, [&](const auto &entry) { return !visible_layout_keys.contains(entry.first); });
     }
 
     State->CurrentSpaceDims = {
@@ -631,7 +911,11 @@ void TextBuffer::Refresh() {
     if (!IsChanged()) return;
 
     const auto b = GetBuffer();
-    State->Syntax->ApplyEdits(b.Edits);
+    // Texts committed by this buffer share structure with the syntax text, so this is cheap unless the text was restored.
+    if (b.Text != State->SyntaxText) {
+        State->Syntax->Reparse(b.Text);
+        State->SyntaxText = b.Text;
+    }
     // todo only mark changed cursors. need a way to compare with previous.
     for (u32 i = 0; i < b.Cursors.size(); ++i) {
         State->StartEdited.insert(i);
@@ -640,6 +924,7 @@ void TextBuffer::Refresh() {
 }
 
 void TextBuffer::Render() const {
+    ProfileZone("TextBuffer::Render");
     static std::string PrevSelectedPath = "";
     auto &file_dialog = Ctx.FileDialog;
     if (file_dialog.Data.OwnerId == Id && PrevSelectedPath != file_dialog.SelectedFilePath) {
@@ -660,7 +945,8 @@ void TextBuffer::Render() const {
         editing_file.c_str()
     );
 
-    const bool is_parent_focused = IsWindowFocused();
+    const bool is_find_active = State->ShowFind && RenderFindReplace();
+    const bool is_parent_focused = IsWindowFocused() && !is_find_active;
     PushStyleColor(ImGuiCol_ChildBg, GetColor(PaletteIndex::Background));
     PushStyleVar(ImGuiStyleVar_ItemSpacing, {0, 0});
     BeginChild("TextBuffer", {}, false, ImGuiWindowFlags_HorizontalScrollbar | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoNavInputs);
@@ -675,6 +961,7 @@ void TextBuffer::Render() const {
         // Process regular text input (before we check for Return because using some IME will effectively send a Return?)
         // We ignore CTRL inputs, but need to allow ALT+CTRL as some keyboards (e.g. German) use AltGR (which _is_ Alt+Ctrl) to input certain characters.
         const bool ignore_char_inputs = (io.KeyCtrl && !io.KeyAlt) || (io.ConfigMacOSXBehaviors && io.KeyCtrl);
+        if (IsPressed(ImGuiMod_Ctrl | ImGuiKey_F)) OpenFind(b);
         if (auto action = ProduceKeyboardAction(); action && CanApply(*action)) {
             Q(std::move(*action));
         } else if (!io.InputQueueCharacters.empty() && !ignore_char_inputs && !ReadOnly) {
@@ -693,6 +980,46 @@ void TextBuffer::Render() const {
     PopStyleColor();
 }
 
+void TextBuffer::OpenFind(const TextBufferData &b) const {
+    State->ShowFind = State->FocusFind = true;
+    // Search for the selected text, if it's on a single line.
+    if (const auto &c = b.LastAddedCursor(); c.IsRange() && !c.IsMultiline()) {
+        const auto selected = b.GetText(c);
+        State->FindPattern.fill('\0');
+        selected.copy(State->FindPattern.data(), State->FindPattern.size() - 1);
+    }
+}
+
+bool TextBuffer::RenderFindReplace() const {
+    using namespace Action::TextBuffer;
+
+    auto &find_pattern = State->FindPattern, &replace_text = State->ReplaceText;
+    const float input_width = GetFontSize() * 16;
+    SetNextItemWidth(input_width);
+    if (std::exchange(State->FocusFind, false)) SetKeyboardFocusHere();
+    InputTextWithHint("##Find", "Find", find_pattern.data(), find_pattern.size());
+    bool is_active = IsItemActive();
+    SameLine();
+    Checkbox("Aa", &State->FindCaseSensitive);
+    SameLine();
+    Checkbox(".*", &State->FindRegex);
+    SameLine();
+    BeginDisabled(find_pattern[0] == '\0');
+    if (Button("Select all")) Q(SelectAllMatches{Id, find_pattern.data(), State->FindCaseSensitive, State->FindRegex});
+    EndDisabled();
+    SameLine();
+    if (Button("Close")) State->ShowFind = false;
+
+    SetNextItemWidth(input_width);
+    InputTextWithHint("##Replace", "Replace", replace_text.data(), replace_text.size());
+    is_active |= IsItemActive();
+    SameLine();
+    BeginDisabled(find_pattern[0] == '\0' || ReadOnly);
+    if (Button("Replace all")) Q(ReplaceAll{Id, find_pattern.data(), State->FindCaseSensitive, State->FindRegex, replace_text.data()});
+    EndDisabled();
+    return is_active;
+}
+
 void TextBuffer::RenderMenu() const {
     FileMenu.Draw();
 
@@ -702,6 +1029,8 @@ void TextBuffer::RenderMenu() const {
         if (const auto a = Action::TextBuffer::Paste{Id}; MenuItem("Paste", "cmd+v", nullptr, CanApply(a))) Q(a);
         Separator();
         if (MenuItem("Select all", nullptr, nullptr)) Q(Action::TextBuffer::SelectAll{Id});
+        if (MenuItem("Select all occurrences", "cmd+shift+l")) Q(Action::TextBuffer::SelectAllOccurrences{Id});
+        if (MenuItem("Find/replace", "cmd+f")) OpenFind(GetBuffer());
         EndMenu();
     }
     if (BeginMenu("Config")) {
@@ -724,6 +1053,7 @@ void TextBuffer::RenderMenu() const {
 void TextBuffer::RenderDebug() const {
     const auto b = GetBuffer();
     if (CollapsingHeader("Editor state")) {
+        ImGui::Text("Last open: %.2f MB in %.1f ms", State->LastOpenBytes / float(1 << 20), State->LastOpenMs);
         ImGui::Text("Cursor count: %lu", b.Cursors.size());
         for (const auto &c : b.Cursors) {
             const auto &start = c.Start, &end = c.End;
@@ -739,6 +1069,87 @@ void TextBuffer::RenderDebug() const {
     }
 
     if (CollapsingHeader("Tree-Sitter")) {
+        const auto &syntax = *State->Syntax;
+        ImGui::Text("Version: %u, Parsed version: %u%s", syntax.Version, syntax.ParsedVersion, syntax.IsParsing() ? " (parsing)" : "");
         ImGui::Text("S-expression:\n%s", State->Syntax->GetSExp().c_str());
+        if (TreeNode("Parse benchmark")) {
+            TextWrapped("Parses the text (repeated to at least 10 MB) from scratch, reading it from the line chunks and from a contiguous string.");
+            BeginDisabled(State->Syntax->GetLanguage().TsLanguage == nullptr || State->ParseBenchmarkResults.IsRunning());
+            if (Button("Run")) Q(Action::TextBuffer::BenchmarkParse{Id});
+            EndDisabled();
+            if (const auto results = State->ParseBenchmarkResults.Get(); results && !results->empty() && BeginTable("Parse benchmark results", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_SizingFixedFit)) {
+                TableSetupColumn("Input");
+                TableSetupColumn("Bytes");
+                TableSetupColumn("Reads");
+                TableSetupColumn("Bytes per read");
+                TableSetupColumn("Parse");
+                TableHeadersRow();
+                for (const auto &result : *results) {
+                    TableNextRow();
+                    TableNextColumn();
+                    TextUnformatted(result.Input.c_str());
+                    TableNextColumn();
+                    ImGui::Text("%u", result.ByteCount);
+                    TableNextColumn();
+                    ImGui::Text("%u", result.ReadCount);
+                    TableNextColumn();
+                    ImGui::Text("%.1f", float(result.ByteCount) / float(std::max(result.ReadCount, 1u)));
+                    TableNextColumn();
+                    ImGui::Text("%.1f ms", result.ParseMs);
+                }
+                EndTable();
+            }
+            TreePop();
+        }
+    }
+    if (CollapsingHeader("Edit log benchmark")) {
+        TextWrapped("Types a few lines at the end of the text, and compares saving them as typed commands, as the full text after each command, and as merged edits.");
+        BeginDisabled(State->EditLogBenchmarkResults.IsRunning());
+        if (Button("Run")) Q(Action::TextBuffer::BenchmarkEditLog{Id});
+        EndDisabled();
+        if (const auto results = State->EditLogBenchmarkResults.Get(); results && !results->empty() && BeginTable("Edit log benchmark results", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_SizingFixedFit)) {
+            TableSetupColumn("Format");
+            TableSetupColumn("Actions");
+            TableSetupColumn("JSON size");
+            TableSetupColumn("Replay");
+            TableHeadersRow();
+            for (const auto &result : *results) {
+                TableNextRow();
+                TableNextColumn();
+                TextUnformatted(result.Format.c_str());
+                TableNextColumn();
+                ImGui::Text("%u", result.ActionCount);
+                TableNextColumn();
+                ImGui::Text("%u bytes", result.JsonBytes);
+                TableNextColumn();
+                ImGui::Text("%.2f ms", result.ReplayMs);
+            }
+            EndTable();
+        }
+    }
+    if (CollapsingHeader("Multi-cursor edit benchmark")) {
+        TextWrapped("Applies edits with 1000 cursors to 10k lines of generated text, one cursor at a time and batched over all cursors, and applies the batched edits' saved deltas (as when replaying).");
+        BeginDisabled(State->MultiCursorBenchmarkResults.IsRunning());
+        if (Button("Run")) Q(Action::TextBuffer::BenchmarkMultiCursorEdits{Id});
+        EndDisabled();
+        if (const auto results = State->MultiCursorBenchmarkResults.Get(); results && !results->empty() && BeginTable("Multi-cursor edit benchmark results", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_SizingFixedFit)) {
+            TableSetupColumn("Edit");
+            TableSetupColumn("Per cursor");
+            TableSetupColumn("Batched");
+            TableSetupColumn("Apply edits");
+            TableHeadersRow();
+            for (const auto &result : *results) {
+                TableNextRow();
+                TableNextColumn();
+                TextUnformatted(result.Edit.c_str());
+                TableNextColumn();
+                ImGui::Text("%.2f ms", result.PerCursorMs);
+                TableNextColumn();
+                ImGui::Text("%.2f ms", result.BatchedMs);
+                TableNextColumn();
+                ImGui::Text("%.2f ms", result.ApplyEditsMs);
+            }
+            EndTable();
+        }
     }
 }
@@ -15,7 +15,7 @@
 
 struct TextBufferState;
 
-struct TextBuffer : Component, Actionable<Action::TextBuffer::Any> {
+struct TextBuffer : Component, Actionable<Action::TextBuffer::Any>, TickListener {
     using Line = TextBufferLine;
     using Lines = TextBufferLines;
     using Cursor = LineCharRange;
@@ -29,8 +29,12 @@ struct TextBuffer : Component, Actionable<Action::TextBuffer::Any> {
     TextBufferData GetBuffer() const;
     std::string GetText() const;
     bool Empty() const;
+    // `std::nullopt` while the latest text is being parsed.
+    std::optional<bool> HasSyntaxErrors() const;
 
     void Refresh() override;
+    void OnTick() override; // Adopt finished syntax parses.
+    bool IsBusy() const override;
     void Render() const override;
     void RenderMenu() const;
     void RenderDebug() const override;
@@ -52,10 +56,22 @@ struct TextBuffer : Component, Actionable<Action::TextBuffer::Any> {
     Prop(Float, LineSpacing, 1);
     Prop(Enum, PaletteId, {"Dark", "Light", "Mariana", "RetroBlue"}, int(TextBufferPaletteId::Dark));
 
+    // Evaluates buffer commands against the current buffer, once, right before they're applied.
+    // Returns the action to apply in the command's place, or `std::nullopt` if it can't be applied:
+    // The `ApplyEdits` action holding the edits made by edit commands, so the edits (rather than the commands) are saved,
+    // or else the command itself. Either way, the following `Apply` commits the evaluated buffer without evaluating the command again.
+    // Legacy commands resolve as the command they hold.
+    std::optional<ActionType> Resolve(const ActionType &) const;
+
 private:
+    // Returns the buffer after applying the command, or `std::nullopt` if the action isn't a buffer command.
+    std::optional<TextBufferData> ApplyCommand(const TextBufferData &, const ActionType &) const;
     void Commit(TransientStore &, TextBufferData) const;
 
     std::optional<TextBuffer::ActionType> Render(const TextBufferData &, bool is_focused) const;
+    void OpenFind(const TextBufferData &) const;
+    // Returns true if any of its inputs are active.
+    bool RenderFindReplace() const;
     std::optional<TextBuffer::ActionType> HandleMouseInputs(const TextBufferData &, ImVec2 char_advance, float text_start_x) const;
 
     // Returns the range of all edited cursor starts/ends since cursor edits were last cleared.
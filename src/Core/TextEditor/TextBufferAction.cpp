@@ -0,0 +1,39 @@
+#include "TextBufferAction.h"
+
+#include <unordered_set>
+
+namespace Action {
+std::variant<TextBuffer::ApplyEdits, bool> TextBuffer::ApplyEdits::Merge(const TextBuffer::ApplyEdits &other) const {
+    // Keep edits to different buffers separate.
+    if (component_id != other.component_id) return false;
+
+    auto merged = deltas;
+    for (const auto &delta : other.deltas) AddDelta(merged, delta);
+    return TextBuffer::ApplyEdits{component_id, std::move(merged), other.cursors};
+}
+} // namespace Action
+
+namespace Action::TextBuffer {
+std::optional<LegacyCommand> ToLegacyCommand(const json &j) {
+    static const std::unordered_set<fs::path, PathHash> LegacyCommandPaths{
+        SetText::GetPath(),
+        Cut::GetPath(),
+        Paste::GetPath(),
+        Delete::GetPath(),
+        Backspace::GetPath(),
+        DeleteCurrentLines::GetPath(),
+        ChangeCurrentLinesIndentation::GetPath(),
+        MoveCurrentLines::GetPath(),
+        ToggleLineComment::GetPath(),
+        EnterChar::GetPath(),
+    };
+    if (!LegacyCommandPaths.contains(j[0].get<fs::path>())) return {};
+    return LegacyCommand{j[1]["component_id"].get<ID>(), j.dump()};
+}
+
+Any ParseLegacyCommand(const LegacyCommand &a) {
+    Any command;
+    Any::from_json(json::parse(a.command), command);
+    return command;
+}
+} // namespace Action::TextBuffer
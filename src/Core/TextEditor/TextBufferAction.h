@@ -1,10 +1,14 @@
 #pragma once
 
+#include <optional>
+
 #include "Core/Action/DefineAction.h"
 #include "LineChar.h"
+#include "TextBufferDelta.h"
 
 Json(LineChar, L, C);
 Json(LineCharRange, Start, End);
+Json(TextBufferDelta, StartByte, OldEndByte, Text);
 
 DefineActionType(
     TextBuffer,
@@ -24,19 +28,34 @@ DefineActionType(
     DefineComponentAction(MoveCursorsEndLine, Unsaved, Merge, "", bool select;);
     DefineComponentAction(SelectAll, Unsaved, Merge, "");
     DefineComponentAction(SelectNextOccurrence, Unsaved, Merge, "");
+    DefineComponentAction(SelectAllOccurrences, Unsaved, Merge, "");
+    DefineComponentAction(SelectAllMatches, Unsaved, NoMerge, "", std::string pattern; bool case_sensitive; bool regex;);
+
+    // The saved form of all text edits: The edits' deltas, and the cursors after the edits.
+    // Consecutive edits merge into a single delta per contiguous edited range.
+    DefineComponentAction(ApplyEdits, Saved, CustomMerge, "", TextBufferDeltas deltas; std::vector<LineCharRange> cursors;);
 
-    DefineComponentAction(SetText, Saved, SameIdMerge, "", std::string value;);
+    // An edit command loaded from a log saved before edits were saved as `ApplyEdits`, as its `[path, data]` JSON.
+    // It applies as the `ApplyEdits` action holding the edits its command makes, which is saved in its place.
+    DefineComponentAction(LegacyCommand, Saved, NoMerge, "", std::string command;);
 
+    // Edit commands. Applied as the `ApplyEdits` action holding the edits they make (see `TextBuffer::Resolve`).
+    DefineComponentAction(SetText, Unsaved, NoMerge, "", std::string value;);
     DefineComponentAction(Copy, Unsaved, NoMerge, "");
-    DefineComponentAction(Cut, Saved, NoMerge, "");
-    DefineComponentAction(Paste, Saved, NoMerge, "");
-    DefineComponentAction(Delete, Saved, NoMerge, "", bool word;);
-    DefineComponentAction(Backspace, Saved, NoMerge, "", bool word;);
-    DefineComponentAction(DeleteCurrentLines, Saved, NoMerge, "");
-    DefineComponentAction(ChangeCurrentLinesIndentation, Saved, NoMerge, "", bool increase;);
-    DefineComponentAction(MoveCurrentLines, Saved, NoMerge, "", bool up;);
-    DefineComponentAction(ToggleLineComment, Saved, NoMerge, "");
-    DefineComponentAction(EnterChar, Saved, NoMerge, "", unsigned short value;); // Corresponds to `ImWchar`
+    DefineComponentAction(Cut, Unsaved, NoMerge, "");
+    DefineComponentAction(Paste, Unsaved, NoMerge, "");
+    DefineComponentAction(Delete, Unsaved, NoMerge, "", bool word;);
+    DefineComponentAction(Backspace, Unsaved, NoMerge, "", bool word;);
+    DefineComponentAction(DeleteCurrentLines, Unsaved, NoMerge, "");
+    DefineComponentAction(ChangeCurrentLinesIndentation, Unsaved, NoMerge, "", bool increase;);
+    DefineComponentAction(MoveCurrentLines, Unsaved, NoMerge, "", bool up;);
+    DefineComponentAction(ToggleLineComment, Unsaved, NoMerge, "");
+    DefineComponentAction(EnterChar, Unsaved, NoMerge, "", unsigned short value;); // Corresponds to `ImWchar`
+    DefineComponentAction(ReplaceAll, Unsaved, NoMerge, "", std::string pattern; bool case_sensitive; bool regex; std::string replacement;);
+
+    DefineComponentAction(BenchmarkParse, Unsaved, NoMerge, "");
+    DefineComponentAction(BenchmarkEditLog, Unsaved, NoMerge, "");
+    DefineComponentAction(BenchmarkMultiCursorEdits, Unsaved, NoMerge, "");
 
     ComponentActionJson(Open, file_path);
     ComponentActionJson(Save, file_path);
@@ -52,7 +71,11 @@ DefineActionType(
     ComponentActionJson(MoveCursorsEndLine, select);
     ComponentActionJson(SelectAll);
     ComponentActionJson(SelectNextOccurrence);
+    ComponentActionJson(SelectAllOccurrences);
+    ComponentActionJson(SelectAllMatches, pattern, case_sensitive, regex);
 
+    ComponentActionJson(ApplyEdits, deltas, cursors);
+    ComponentActionJson(LegacyCommand, command);
     ComponentActionJson(SetText, value);
 
     ComponentActionJson(Copy);
@@ -65,10 +88,22 @@ DefineActionType(
     ComponentActionJson(MoveCurrentLines, up);
     ComponentActionJson(ToggleLineComment);
     ComponentActionJson(EnterChar, value);
+    ComponentActionJson(ReplaceAll, pattern, case_sensitive, regex, replacement);
+
+    ComponentActionJson(BenchmarkParse);
+    ComponentActionJson(BenchmarkEditLog);
+    ComponentActionJson(BenchmarkMultiCursorEdits);
 
     using Any = ActionVariant<
-        ShowOpenDialog, ShowSaveDialog, Save, Open, SetText,
+        ShowOpenDialog, ShowSaveDialog, Save, Open, ApplyEdits, LegacyCommand, SetText,
         SetCursor, SetCursorRange, MoveCursorsLines, PageCursorsLines, MoveCursorsChar, MoveCursorsTop, MoveCursorsBottom, MoveCursorsStartLine, MoveCursorsEndLine,
-        SelectAll, SelectNextOccurrence, Copy, Cut, Paste, Delete, Backspace, DeleteCurrentLines, ChangeCurrentLinesIndentation,
-        MoveCurrentLines, ToggleLineComment, EnterChar>;
+        SelectAll, SelectNextOccurrence, SelectAllOccurrences, SelectAllMatches, Copy, Cut, Paste, Delete, Backspace, DeleteCurrentLines, ChangeCurrentLinesIndentation,
+        MoveCurrentLines, ToggleLineComment, EnterChar, ReplaceAll, BenchmarkParse, BenchmarkEditLog, BenchmarkMultiCursorEdits>;
 );
+
+namespace Action::TextBuffer {
+// Edit commands were saved as-is before edits were saved as `ApplyEdits`.
+// Returns the `LegacyCommand` holding the saved `[path, data]` action JSON if it's one of these commands.
+std::optional<LegacyCommand> ToLegacyCommand(const json &);
+Any ParseLegacyCommand(const LegacyCommand &);
+} // namespace Action::TextBuffer
@@ -0,0 +1,43 @@
+#include "TextBufferBrackets.h"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+
+#include "immer/algorithm.hpp"
+
+TextBufferBrackets::TextBufferBrackets(TextBufferLines text) : Text(std::move(text)) {
+    static constexpr u32 Unmatched = std::numeric_limits<u32>::max();
+    static constexpr std::array<char, 3> OpenChars{'(', '[', '{'}, CloseChars{')', ']', '}'};
+
+    // Brackets are visited in order, so they stay sorted.
+    // Open brackets are added unmatched and updated when their close bracket is found.
+    std::array<std::vector<u32>, 3> open_indices; // Per bracket type, indices of open brackets waiting for a match.
+    u32 byte_index = 0;
+    for (const auto &line : Text) {
+        immer::for_each_chunk(line, [&](const char *first, const char *last) {
+            for (const char *ch = first; ch != last; ++ch, ++byte_index) {
+                if (const auto open = std::ranges::find(OpenChars, *ch); open != OpenChars.end()) {
+                    open_indices[open - OpenChars.begin()].push_back(Brackets.size());
+                    Brackets.push_back({byte_index, Unmatched});
+                } else if (const auto close = std::ranges::find(CloseChars, *ch); close != CloseChars.end()) {
+                    auto &indices = open_indices[close - CloseChars.begin()];
+                    if (indices.empty()) continue;
+
+                    auto &open_bracket = Brackets[indices.back()];
+                    indices.pop_back();
+                    open_bracket.MatchByte = byte_index;
+                    Brackets.push_back({byte_index, open_bracket.Byte});
+                }
+            }
+        });
+        ++byte_index; // Newline
+    }
+    std::erase_if(Brackets, [](const auto &bracket) { return bracket.MatchByte == Unmatched; });
+}
+
+std::optional<u32> TextBufferBrackets::FindMatch(u32 byte_index) const {
+    const auto it = std::ranges::lower_bound(Brackets, byte_index, {}, &Bracket::Byte);
+    if (it == Brackets.end() || it->Byte != byte_index) return {};
+    return it->MatchByte;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <optional>
+#include <vector>
+
+#include "TextBufferData.h"
+
+// The matching bracket pairs (`()`, `[]`, `{}`) in a text, indexed by byte.
+// Found with a single stack scan per bracket type, so each bracket matches the nearest bracket of its own type
+// that balances the brackets of that type between them (brackets of other types are ignored).
+struct TextBufferBrackets {
+    TextBufferBrackets() = default;
+    explicit TextBufferBrackets(TextBufferLines);
+
+    // Returns the byte index of the bracket matching the bracket at `byte_index`,
+    // or `std::nullopt` if there's no matched bracket there. O(log n).
+    std::optional<u32> FindMatch(u32 byte_index) const;
+
+    TextBufferLines Text{}; // The indexed text.
+
+private:
+    struct Bracket {
+        u32 Byte, MatchByte;
+    };
+    std::vector<Bracket> Brackets{}; // Matched brackets, sorted by byte.
+};
@@ -1,12 +1,16 @@
 #include "TextBufferData.h"
 
+#include <algorithm>
 #include <ranges>
 #include <set>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 
 #include "immer/flex_vector_transient.hpp"
 
+#include "TextBufferReader.h"
+
 using std::ranges::any_of, std::ranges::all_of, std::ranges::find_if, std::ranges::find_if_not, std::ranges::fold_left, std::ranges::subrange,
     std::views::filter, std::views::transform, std::ranges::reverse_view, std::ranges::to;
 
@@ -165,81 +169,198 @@ LineChar TextBufferData::FindWordBoundary(LineChar from, bool is_start) const {
     return {from.L, ci};
 }
 
-// Returns a cursor containing the start/end positions of the next occurrence of `text` at or after `start`, or `std::nullopt` if not found.
-std::optional<Cursor> TextBufferData::FindNextOccurrence(std::string_view text, LineChar start, bool case_sensitive) const {
-    if (text.empty()) return {};
-    auto find_lci = LinesIter{Text, start, BeginLC(), EndLC()};
-    do {
-        auto match_lci = find_lci;
-        for (u32 i = 0; i < text.size(); ++i) {
-            const auto &match_lc = *match_lci;
-            if (match_lc.C == Text[match_lc.L].size()) {
-                if (text[i] != '\n' || match_lc.L + 1 >= Text.size()) break;
-            } else if (ToLower(match_lci, case_sensitive) != ToLower(text[i], case_sensitive)) {
-                break;
-            }
+namespace {
+// Converts ascending byte indices to line/chars, in a single pass over the lines.
+struct ByteToLineChar {
+    const Lines &Text;
+    u32 L{0}, LineStartByte{0};
 
-            ++match_lci;
-            if (i == text.size() - 1) return Cursor{*find_lci, *match_lci};
-        }
+    LineChar operator()(u32 byte_index) {
+        while (L < Text.size() - 1 && byte_index > LineStartByte + Text[L].size()) LineStartByte += Text[L++].size() + 1;
+        return {L, std::min(byte_index - LineStartByte, u32(Text[L].size()))};
+    }
+};
 
-        ++find_lci;
-        if (find_lci.IsEnd()) find_lci.Reset();
-    } while (*find_lci != start);
+// Returns the first match of the literal `pattern` (which may span lines) in bytes `[start_byte, end_byte)` of the text.
+// Reads the text straight from the lines' chunks, without copying it, and matches with Knuth-Morris-Pratt, so each byte is read once.
+std::optional<TextBufferMatch> FindFirstLiteral(const Lines &text, std::string_view pattern, bool case_sensitive, u32 start_byte, u32 end_byte) {
+    const u32 m = pattern.size();
+    if (m == 0 || end_byte < start_byte + m) return {};
+
+    std::string folded(m, '\0');
+    for (u32 i = 0; i < m; ++i) folded[i] = ToLower(pattern[i], case_sensitive);
+    // `prefix[i]`: Length of the longest proper prefix of `folded[0..i]` that's also its suffix.
+    std::vector<u32> prefix(m, 0);
+    for (u32 i = 1, k = 0; i < m; ++i) {
+        while (k > 0 && folded[i] != folded[k]) k = prefix[k - 1];
+        if (folded[i] == folded[k]) ++k;
+        prefix[i] = k;
+    }
 
+    TextBufferReader reader{text};
+    u32 matched = 0;
+    for (u32 byte = start_byte; byte < end_byte;) {
+        u32 chunk_size = 0;
+        const char *chunk = TextBufferReader::Read(&reader, byte, {}, &chunk_size);
+        if (!chunk || chunk_size == 0) break;
+
+        chunk_size = std::min(chunk_size, end_byte - byte);
+        for (u32 i = 0; i < chunk_size; ++i) {
+            const char ch = ToLower(chunk[i], case_sensitive);
+            while (matched > 0 && ch != folded[matched]) matched = prefix[matched - 1];
+            if (ch == folded[matched] && ++matched == m) return TextBufferMatch{byte + i + 1 - m, byte + i + 1};
+        }
+        byte += chunk_size;
+    }
     return {};
 }
+} // namespace
 
-std::optional<Cursor> TextBufferData::FindMatchingBrackets(const Cursor &c) const {
-    static const std::unordered_map<char, char>
-        OpenToCloseChar{{'{', '}'}, {'(', ')'}, {'[', ']'}},
-        CloseToOpenChar{{'}', '{'}, {')', '('}, {']', '['}};
+// Returns a cursor containing the start/end positions of the next occurrence of `text` at or after `start`, or `std::nullopt` if not found.
+std::optional<Cursor> TextBufferData::FindNextOccurrence(std::string_view text, LineChar start, bool case_sensitive) const {
+    if (text.empty()) return {};
 
-    const u32 li = c.Line();
-    const auto &line = Text[li];
-    if (c.IsRange() || line.empty()) return {};
+    const u32 start_byte = ToByteIndex(start);
+    auto match = FindFirstLiteral(Text, text, case_sensitive, start_byte, EndByteIndex());
+    // Wrap around, allowing matches that start before `start` and end after it.
+    if (!match) match = FindFirstLiteral(Text, text, case_sensitive, 0, start_byte + text.size() - 1);
+    if (!match) return {};
+
+    ByteToLineChar to_lc{Text};
+    const auto match_start = to_lc(match->Start);
+    return Cursor{match_start, to_lc(match->End)};
+}
+
+std::vector<Cursor> TextBufferData::FindAll(const TextBufferSearch &search) const {
+    const auto matches = search.FindAll(GetText());
+    std::vector<Cursor> cursors;
+    cursors.reserve(matches.size());
+    // Matches are sorted, so convert their bytes to line/chars in a single pass.
+    ByteToLineChar to_lc{Text};
+    for (const auto &match : matches) {
+        const auto start = to_lc(match.Start);
+        cursors.push_back({start, to_lc(match.End)});
+    }
+    return cursors;
+}
 
-    u32 ci = c.CharIndex();
-    // Considered on bracket if cursor is to the left or right of it.
-    if (ci > 0 && (CloseToOpenChar.contains(line[ci - 1]) || OpenToCloseChar.contains(line[ci - 1]))) --ci;
+// Each line is built directly from its byte range, only copying char-by-char to drop carriage returns.
+static Lines ToLinesSerial(std::string_view text) {
+    TransientLines transient_lines{};
+    for (size_t start = 0;;) {
+        const size_t end = std::min(text.find('\n', start), text.size());
+        const auto line_text = text.substr(start, end - start);
+        if (line_text.contains('\r')) {
+            TransientLine line{};
+            for (const char ch : line_text) {
+                if (ch != '\r') line.push_back(ch);
+            }
+            transient_lines.push_back(line.persistent());
+        } else {
+            transient_lines.push_back(TextBufferLine(line_text.begin(), line_text.end()));
+        }
+        if (end == text.size()) break;
+        start = end + 1;
+    }
+    return transient_lines.persistent();
+}
 
-    const char ch = line[ci];
-    const bool is_close_char = CloseToOpenChar.contains(ch), is_open_char = OpenToCloseChar.contains(ch);
-    if (!is_close_char && !is_open_char) return {};
+Lines TextBufferData::ToLines(std::string_view text) {
+    // Large texts are split into chunks at newlines, converted in parallel, and concatenated.
+    static constexpr size_t MinChunkSize = 4 << 20;
+    const auto chunk_count = std::clamp(u32(text.size() / MinChunkSize), 1u, std::max(std::thread::hardware_concurrency(), 1u));
+    if (chunk_count == 1) return ToLinesSerial(text);
 
-    const LineChar lc{li, ci};
-    const char other_ch = is_close_char ? CloseToOpenChar.at(ch) : OpenToCloseChar.at(ch);
-    u32 match_count = 0;
-    for (auto lci = LinesIter{Text, lc, BeginLC(), EndLC()};
-         is_close_char ? !lci.IsBegin() : !lci.IsEnd(); is_close_char ? --lci : ++lci) {
-        const char ch_inner = lci;
-        if (ch_inner == ch) ++match_count;
-        else if (ch_inner == other_ch && (match_count == 0 || --match_count == 0)) return Cursor{lc, *lci};
+    std::vector<std::string_view> chunks;
+    for (size_t start = 0;;) {
+        const size_t split = chunks.size() + 1 < chunk_count ? text.find('\n', start + text.size() / chunk_count) : std::string_view::npos;
+        if (split == std::string_view::npos) {
+            chunks.push_back(text.substr(start));
+            break;
+        }
+        chunks.push_back(text.substr(start, split - start)); // The newline at `split` separates the chunks' lines.
+        start = split + 1;
     }
 
-    return {};
+    std::vector<Lines> chunk_lines(chunks.size());
+    {
+        std::vector<std::jthread> workers;
+        for (u32 i = 0; i < chunks.size(); ++i) workers.emplace_back([&chunk_lines, &chunks, i] { chunk_lines[i] = ToLinesSerial(chunks[i]); });
+    } // Workers are joined here.
+    Lines lines = chunk_lines.front();
+    for (const auto &chunk : chunk_lines | std::views::drop(1)) lines = lines + chunk;
+    return lines;
+}
+
+// Byte count of the longest common prefix of two texts, or of their longest common suffix if `reverse` is true.
+// Compares line by line, without joining either text.
+static u32 CommonAffixBytes(const Lines &a, const Lines &b, bool reverse) {
+    u32 bytes = 0;
+    for (u32 i = 0; i < a.size() && i < b.size(); ++i) {
+        const auto &line_a = a[reverse ? a.size() - 1 - i : i], &line_b = b[reverse ? b.size() - 1 - i : i];
+        if (line_a != line_b) {
+            // Lines don't hold line breaks, so the common part ends in this line.
+            if (reverse) return bytes + u32(std::mismatch(line_a.rbegin(), line_a.rend(), line_b.rbegin(), line_b.rend()).first - line_a.rbegin());
+            return bytes + u32(std::mismatch(line_a.begin(), line_a.end(), line_b.begin(), line_b.end()).first - line_a.begin());
+        }
+        bytes += line_a.size();
+        if (i + 1 == a.size() || i + 1 == b.size()) break;
+        ++bytes; // Both texts continue with a line break.
+    }
+    return bytes;
 }
 
-TextBufferData TextBufferData::SetText(const std::string &text) const {
-    const u32 old_end_byte = EndByteIndex();
+TextBufferData TextBufferData::SetText(std::string_view text) const {
+    TextBufferData b = *this;
+    b.Text = ToLines(text);
+
+    // Only record the changed range between the common prefix and suffix.
+    // Compare the old and new lines directly, so neither text is copied into a contiguous string.
+    const u32 old_size = EndByteIndex(), new_size = b.EndByteIndex(); // Carriage returns were dropped from the new lines.
+    const u32 prefix = CommonAffixBytes(Text, b.Text, false);
+    const u32 suffix = std::min(CommonAffixBytes(Text, b.Text, true), std::min(old_size, new_size) - prefix);
+    if (prefix != old_size || prefix != new_size) {
+        b.Edits = b.Edits.push_back({prefix, old_size - suffix, new_size - suffix});
+    }
+    return b;
+}
 
-    TransientLines transient_lines{};
-    TransientLine current_line{};
-    for (auto ch : text) {
-        if (ch == '\r') continue; // Ignore the carriage return character.
-        if (ch == '\n') {
-            transient_lines.push_back(current_line.persistent());
-            current_line = {};
-        } else {
-            current_line.push_back(ch);
-        }
+LineChar TextBufferData::ToLineChar(u32 byte_index) const {
+    u32 li = 0;
+    for (; li < Text.size() - 1 && byte_index > Text[li].size(); ++li) byte_index -= Text[li].size() + 1;
+    return {li, std::min(byte_index, u32(Text[li].size()))};
+}
+
+TextBufferDeltas TextBufferData::GetDeltas() const {
+    TextBufferDeltas deltas;
+    // Compose the edits with placeholder text, and then read each delta's text, which is contiguous in this buffer.
+    for (const auto &edit : Edits) AddDelta(deltas, {edit.StartByte, edit.OldEndByte, std::string(edit.NewEndByte - edit.StartByte, '\0')});
+    // Deltas are sorted, so convert their bytes to line/chars in a single pass.
+    ByteToLineChar to_lc{Text};
+    for (auto &delta : deltas) {
+        const auto start = to_lc(delta.StartByte);
+        delta.Text = GetText(start, to_lc(delta.NewEndByte()));
+    }
+    return deltas;
+}
+
+TextBufferData TextBufferData::ApplyDeltas(const TextBufferDeltas &deltas) const {
+    // Each delta's bytes are relative to the text after the deltas before it are applied.
+    // Convert them to sorted replacements of ranges in the current text, and apply them in a single pass.
+    std::vector<TextBufferReplacement> replacements;
+    replacements.reserve(deltas.size());
+    ByteToLineChar to_lc{Text};
+    long long byte_change = 0; // Change in byte count from the deltas applied before each delta.
+    for (const auto &delta : deltas) {
+        const auto start = to_lc(u32(delta.StartByte - byte_change));
+        const auto end = to_lc(u32(delta.OldEndByte - byte_change));
+        replacements.push_back({{start, end}, delta.Text.empty() ? Lines{} : ToLines(delta.Text)});
+        byte_change += (long long)delta.Text.size() - (long long)(delta.OldEndByte - delta.StartByte);
     }
-    transient_lines.push_back(current_line.persistent());
 
     TextBufferData b = *this;
-    b.Text = transient_lines.persistent();
-    b.Edits = b.Edits.push_back({0, old_end_byte, b.EndByteIndex()});
-    return b;
+    b.Edits = {};
+    return b.Replace(replacements, false);
 }
 
 TextBufferData TextBufferData::MergeCursors() const {
@@ -384,16 +505,89 @@ std::pair<TextBufferData, LineChar> TextBufferData::Insert(Lines text, LineChar
     return {b, {at.L + num_new_lines, u32(text.size() == 1 ? at.C + text.front().size() : text.back().size())}};
 }
 
-TextBufferData TextBufferData::Paste(Lines lines) const {
-    auto b = *this;
-    for (int c = b.Cursors.size() - 1; c > -1; --c) b = b.DeleteSelection(c);
-    if (b.Cursors.size() > 1 && lines.size() == b.Cursors.size()) {
-        // Paste each line at the corresponding cursor.
-        for (int c = b.Cursors.size() - 1; c > -1; --c) b = b.InsertAtCursor({lines[c]}, c);
-    } else {
-        for (int c = b.Cursors.size() - 1; c > -1; --c) b = b.InsertAtCursor(lines, c);
+TextBufferData TextBufferData::Replace(const std::vector<TextBufferReplacement> &replacements, bool update_cursors) const {
+    if (replacements.empty()) return *this;
+
+    static constexpr auto ByteCount = [](const Lines &lines) {
+        return fold_left(lines, u32(lines.size()) - 1, [](u32 sum, const auto &line) { return sum + line.size(); });
+    };
+    // Byte count between two positions in the current text, with `from <= to`.
+    const auto ByteDistance = [this](LineChar from, LineChar to) {
+        if (from.L == to.L) return to.C - from.C;
+
+        u32 distance = Text[from.L].size() - from.C + 1 + to.C;
+        for (u32 li = from.L + 1; li < to.L; ++li) distance += Text[li].size() + 1;
+        return distance;
+    };
+
+    // Build the new text by concatenating the unchanged slices between replacements with the replacement texts,
+    // and keep track of each replaced range's end before and after replacing.
+    std::vector<std::pair<LineChar, LineChar>> old_and_new_ends;
+    old_and_new_ends.reserve(replacements.size());
+    auto edits = Edits.transient();
+    Lines text{};
+    Line line{}; // The last line of the new text, still being built.
+    LineChar prev_end{0, 0};
+    u32 prev_end_byte = 0;
+    int byte_change = 0; // Change in byte count from all replacements so far.
+    for (const auto &[range, insert] : replacements) {
+        const auto start = range.Min(), end = range.Max();
+        const u32 start_byte = prev_end_byte + ByteDistance(prev_end, start), end_byte = start_byte + ByteDistance(start, end);
+        if (start.L == prev_end.L) {
+            line = line + Text[start.L].take(start.C).drop(prev_end.C);
+        } else {
+            text = text.push_back(line + Text[prev_end.L].drop(prev_end.C)) + Text.take(start.L).drop(prev_end.L + 1);
+            line = Text[start.L].take(start.C);
+        }
+        if (!insert.empty()) {
+            line = line + insert.front();
+            if (insert.size() > 1) {
+                text = text.push_back(line) + insert.take(insert.size() - 1).drop(1);
+                line = insert.back();
+            }
+        }
+
+        // Edits are applied in order, so each edit's bytes are offset by the changes of the edits before it.
+        const u32 insert_byte_count = insert.empty() ? 0 : ByteCount(insert);
+        if (start_byte != end_byte || insert_byte_count != 0) {
+            const u32 edit_start_byte = start_byte + byte_change;
+            edits.push_back({edit_start_byte, edit_start_byte + (end_byte - start_byte), edit_start_byte + insert_byte_count});
+        }
+        byte_change += int(insert_byte_count) - int(end_byte - start_byte);
+        old_and_new_ends.emplace_back(end, LineChar{u32(text.size()), u32(line.size())});
+        prev_end = end;
+        prev_end_byte = end_byte;
     }
-    return b;
+
+    auto b = *this;
+    b.Text = text.push_back(line + Text[prev_end.L].drop(prev_end.C)) + Text.drop(prev_end.L + 1);
+    b.Edits = edits.persistent();
+    if (!update_cursors) return b;
+
+    // Cursors are sorted and non-overlapping, so their positions can be moved in a single pass along with the replacements.
+    u32 ri = 0;
+    const auto move_lc = [&](LineChar lc) {
+        while (ri < replacements.size() && replacements[ri].Range.Max() < lc) ++ri;
+        if (ri < replacements.size() && replacements[ri].Range.Min() <= lc) return old_and_new_ends[ri].second;
+        if (ri == 0) return lc;
+
+        const auto &[old_end, new_end] = old_and_new_ends[ri - 1];
+        if (lc.L == old_end.L) return LineChar{new_end.L, new_end.C + lc.C - old_end.C};
+        return LineChar{lc.L + new_end.L - old_end.L, lc.C};
+    };
+    return b.EditCursors([&move_lc](const auto &c) {
+        const auto min = move_lc(c.Min()), max = move_lc(c.Max());
+        return c.Start <= c.End ? Cursor{min, max} : Cursor{max, min};
+    });
+}
+
+TextBufferData TextBufferData::Paste(Lines lines) const {
+    // Paste each line at the corresponding cursor if there's a line for each cursor.
+    const bool line_per_cursor = Cursors.size() > 1 && lines.size() == Cursors.size();
+    std::vector<TextBufferReplacement> replacements;
+    replacements.reserve(Cursors.size());
+    for (u32 i = 0; i < Cursors.size(); ++i) replacements.push_back({Cursors[i], line_per_cursor ? Lines{lines[i]} : lines});
+    return Replace(replacements);
 }
 
 TextBufferData TextBufferData::DeleteRange(LineCharRange lcr, bool update_cursors, std::optional<Cursor> exclude_cursor) const {
@@ -440,27 +634,27 @@ TextBufferData TextBufferData::DeleteSelection(u32 i) const {
 }
 
 TextBufferData TextBufferData::DeleteSelections() const {
-    auto b = *this;
-    for (int c = b.Cursors.size() - 1; c > -1; --c) b = b.DeleteSelection(c);
-    return b;
+    std::vector<TextBufferReplacement> replacements;
+    for (const auto &c : Cursors) {
+        if (c.IsRange()) replacements.push_back({c});
+    }
+    return Replace(replacements);
 }
 
 TextBufferData TextBufferData::EnterChar(ImWchar ch, bool auto_indent) const {
-    auto b = *this;
-    for (int c = Cursors.size() - 1; c > -1; --c) b = b.DeleteSelection(c);
-
-    // Order is important here when typing '\n' in the same line with multiple cursors.
-    for (int i = b.Cursors.size() - 1; i > -1; --i) {
-        const auto &c = b.Cursors[i];
+    // Replace each cursor's selection with the char.
+    std::vector<TextBufferReplacement> replacements;
+    replacements.reserve(Cursors.size());
+    for (const auto &c : Cursors) {
         TransientLine insert_line_trans{};
         if (ch == '\n') {
-            if (auto_indent && c.CharIndex() != 0) {
+            if (auto_indent && c.Min().C != 0) {
                 // Match the indentation of the current or next line, whichever has more indentation.
                 // todo use tree-sitter fold queries
-                const u32 li = c.Line();
-                const u32 indent_li = li < b.Text.size() - 1 && b.NumStartingSpaceColumns(li + 1) > b.NumStartingSpaceColumns(li) ? li + 1 : li;
-                const auto &indent_line = b.Text[indent_li];
-                for (u32 i = 0; i < insert_line_trans.size() && isblank(indent_line[i]); ++i) insert_line_trans.push_back(indent_line[i]);
+                const u32 li = c.Min().L;
+                const u32 indent_li = li < Text.size() - 1 && NumStartingSpaceColumns(li + 1) > NumStartingSpaceColumns(li) ? li + 1 : li;
+                const auto &indent_line = Text[indent_li];
+                for (u32 i = 0; i < indent_line.size() && isblank(indent_line[i]); ++i) insert_line_trans.push_back(indent_line[i]);
             }
         } else {
             char buf[5];
@@ -468,10 +662,9 @@ TextBufferData TextBufferData::EnterChar(ImWchar ch, bool auto_indent) const {
             for (u32 i = 0; i < 5 && buf[i] != '\0'; ++i) insert_line_trans.push_back(buf[i]);
         }
         auto insert_line = insert_line_trans.persistent();
-        b = b.InsertAtCursor(ch == '\n' ? Lines{{}, insert_line} : Lines{insert_line}, i);
+        replacements.push_back({c, ch == '\n' ? Lines{{}, insert_line} : Lines{insert_line}});
     }
-
-    return b;
+    return Replace(replacements);
 }
 
 TextBufferData TextBufferData::Backspace(bool is_word_mode) const {
@@ -484,8 +677,7 @@ TextBufferData TextBufferData::Backspace(bool is_word_mode) const {
         }
         b = b.MergeCursors();
     }
-    for (int c = b.Cursors.size() - 1; c > -1; --c) b = b.DeleteSelection(c);
-    return b;
+    return b.DeleteSelections();
 }
 
 TextBufferData TextBufferData::Delete(bool is_word_mode) const {
@@ -498,8 +690,7 @@ TextBufferData TextBufferData::Delete(bool is_word_mode) const {
         }
         b = b.MergeCursors();
     }
-    for (int c = b.Cursors.size() - 1; c > -1; --c) b = b.DeleteSelection(c);
-    return b;
+    return b.DeleteSelections();
 }
 
 TextBufferData TextBufferData::MoveCurrentLines(bool up) const {
@@ -571,25 +762,39 @@ TextBufferData TextBufferData::DeleteCurrentLines() const {
 }
 
 TextBufferData TextBufferData::ChangeCurrentLinesIndentation(bool increase) const {
-    auto b = *this;
-    for (const auto &c : reverse_view(b.Cursors)) {
+    std::vector<TextBufferReplacement> replacements;
+    std::unordered_map<u32, int> char_change_for_line;
+    for (const auto &c : Cursors) {
         for (u32 li = c.Min().L; li <= c.Max().L; ++li) {
             // Check if selection ends at line start.
             if (c.IsRange() && c.Max() == LineChar{li, 0}) continue;
+            if (char_change_for_line.contains(li)) continue; // Already changed for a previous cursor on the same line.
 
-            const auto &line = b.Text[li];
+            const auto &line = Text[li];
             if (increase) {
-                if (!line.empty()) b = b.Insert({{'\t'}}, {li, 0}).first;
+                if (!line.empty()) {
+                    replacements.push_back({{{li, 0}, {li, 0}}, Lines{{'\t'}}});
+                    char_change_for_line[li] = 1;
+                }
             } else {
-                auto ci = int(b.GetCharIndex(line, GTextBufferStyle.NumTabSpaces)) - 1;
+                const u32 indent_end = GetCharIndex(line, GTextBufferStyle.NumTabSpaces);
+                auto ci = int(indent_end) - 1;
                 while (ci > -1 && isblank(line[ci])) --ci;
-                if (const bool only_space_chars_found = ci == -1; only_space_chars_found) {
-                    b = b.DeleteRange({{li, 0}, {li, b.GetCharIndex(line, GTextBufferStyle.NumTabSpaces)}});
+                if (const bool only_space_chars_found = ci == -1; only_space_chars_found && indent_end > 0) {
+                    replacements.push_back({{{li, 0}, {li, indent_end}}});
+                    char_change_for_line[li] = -int(indent_end);
                 }
             }
         }
     }
-    return b;
+
+    // Keep cursors at line starts in place, and move the rest with their line's text.
+    const auto move_lc = [&char_change_for_line](LineChar lc) {
+        const auto it = char_change_for_line.find(lc.L);
+        if (lc.C == 0 || it == char_change_for_line.end()) return lc;
+        return LineChar{lc.L, u32(std::max(int(lc.C) + it->second, 0))};
+    };
+    return Replace(replacements, false).EditCursors([&move_lc](const auto &c) { return Cursor{move_lc(c.Start), move_lc(c.End)}; });
 }
 
 TextBufferData TextBufferData::SelectNextOccurrence(bool case_sensitive) const {
@@ -599,3 +804,26 @@ TextBufferData TextBufferData::SelectNextOccurrence(bool case_sensitive) const {
     }
     return *this;
 }
+
+TextBufferData TextBufferData::SelectAllOccurrences(bool case_sensitive) const {
+    const auto &c = LastAddedCursor();
+    if (!c.IsRange()) return *this;
+
+    return SelectAll({GetText(c), case_sensitive});
+}
+
+TextBufferData TextBufferData::SelectAll(const TextBufferSearch &search) const {
+    const auto cursors = FindAll(search);
+    if (cursors.empty()) return *this;
+
+    auto b = SetCursors({cursors.begin(), cursors.end()});
+    b.LastAddedCursorIndex = b.Cursors.size() - 1;
+    return b;
+}
+
+TextBufferData TextBufferData::ReplaceAll(const TextBufferSearch &search, const std::string &replacement) const {
+    const auto replacement_lines = ToLines(replacement);
+    std::vector<TextBufferReplacement> replacements;
+    for (const auto &c : FindAll(search)) replacements.push_back({c, replacement_lines});
+    return Replace(replacements);
+}
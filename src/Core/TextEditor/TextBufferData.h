@@ -5,6 +5,8 @@
 #include "immer/vector_transient.hpp"
 
 #include "LineChar.h"
+#include "TextBufferDelta.h"
+#include "TextBufferSearch.h"
 #include "TextBufferStyle.h"
 #include "TextInputEdit.h"
 
@@ -15,6 +17,12 @@ using TextBufferCursors = immer::vector<TextBufferCursor>;
 
 using ImWchar = unsigned short;
 
+// Replaces the text in `Range` with `Text` (which may be empty).
+struct TextBufferReplacement {
+    LineCharRange Range;
+    TextBufferLines Text{};
+};
+
 // Represents a character coordinate from the user's point of view,
 // i. e. consider a uniform grid (assuming fixed-width font) on the screen as it is rendered, and each cell has its own coordinate, starting from 0.
 // Tabs are counted as [1..NumTabSpaces] u32 empty spaces, depending on how many space is necessary to reach the next tab stop.
@@ -82,6 +90,7 @@ struct TextBufferData {
     LineChar EndLC() const { return LineMaxLC(Text.size() - 1); }
 
     u32 ToByteIndex(LineChar) const;
+    LineChar ToLineChar(u32 byte_index) const;
     u32 EndByteIndex() const { return ToByteIndex(EndLC()); }
 
     Cursor Clamped(LineChar start, LineChar end) const {
@@ -119,11 +128,6 @@ struct TextBufferData {
         while (ci < char_index && ci < line.size()) std::tie(ci, column) = NextCharIndexAndColumn(line, ci, column);
         return column;
     }
-    static u32 GetFirstVisibleCharIndex(const Line &line, u32 first_visible_column) {
-        u32 ci = 0, column = 0;
-        while (column < first_visible_column && ci < line.size()) std::tie(ci, column) = NextCharIndexAndColumn(line, ci, column);
-        return column > first_visible_column && ci > 0 ? ci - 1 : ci;
-    }
 
     static u32 GetLineMaxColumn(const Line &line) {
         u32 ci = 0, column = 0;
@@ -150,9 +154,17 @@ struct TextBufferData {
     LineChar FindWordBoundary(LineChar from, bool is_start = false) const;
     // Returns a cursor containing the start/end positions of the next occurrence of `text` at or after `start`, or `std::nullopt` if not found.
     std::optional<Cursor> FindNextOccurrence(std::string_view text, LineChar start, bool case_sensitive) const;
-    std::optional<Cursor> FindMatchingBrackets(const Cursor &) const;
+    // Returns a cursor for each match of the search, in order.
+    std::vector<Cursor> FindAll(const TextBufferSearch &) const;
+
+    // Large texts are split into lines on multiple threads.
+    static Lines ToLines(std::string_view);
+    TextBufferData SetText(std::string_view) const;
 
-    TextBufferData SetText(const std::string &) const;
+    // The edits in `Edits`, with the text they insert.
+    TextBufferDeltas GetDeltas() const;
+    // Apply the deltas without moving cursors, replacing `Edits` with the resulting edits.
+    TextBufferData ApplyDeltas(const TextBufferDeltas &) const;
     // Assumes cursors are sorted (on `Min()`).
     TextBufferData MergeCursors() const;
 
@@ -193,6 +205,12 @@ struct TextBufferData {
     std::pair<TextBufferData, LineChar> Insert(Lines text, LineChar at, bool update_cursors = true) const;
     TextBufferData Paste(Lines) const;
 
+    // Apply all replacements in a single pass over the text, recording one edit per replacement.
+    // Replacements must be sorted and non-overlapping, with ranges in the current text.
+    // If `update_cursors`, cursors move with the text around them, and cursor positions in (or at either end of) a replaced range
+    // move to the end of its new text.
+    TextBufferData Replace(const std::vector<TextBufferReplacement> &, bool update_cursors = true) const;
+
     TextBufferData InsertAtCursor(Lines text, u32 i) const {
         if (text.empty()) return *this;
         const auto [b, insertion_end] = Insert(text, Cursors[i].Min());
@@ -214,4 +232,9 @@ struct TextBufferData {
     TextBufferData ChangeCurrentLinesIndentation(bool increase) const;
 
     TextBufferData SelectNextOccurrence(bool case_sensitive = true) const;
+    // Select all occurrences of the last added cursor's selected text.
+    TextBufferData SelectAllOccurrences(bool case_sensitive = true) const;
+    TextBufferData SelectAll(const TextBufferSearch &) const;
+    // Replace all matches of the search with `replacement`, as a single batch of edits.
+    TextBufferData ReplaceAll(const TextBufferSearch &, const std::string &replacement) const;
 };
@@ -0,0 +1,28 @@
+#include "TextBufferDelta.h"
+
+#include <algorithm>
+
+void AddDelta(TextBufferDeltas &deltas, TextBufferDelta delta) {
+    const long long size_change = (long long)delta.Text.size() - (long long)(delta.OldEndByte - delta.StartByte);
+    auto first = std::ranges::find_if(deltas, [&delta](const auto &d) { return d.NewEndByte() >= delta.StartByte; });
+    const auto last = std::find_if(first, deltas.end(), [&delta](const auto &d) { return d.StartByte > delta.OldEndByte; });
+    if (first != last) {
+        // Merge with the touched deltas. The new delta covers everything between them, so only their outer parts remain.
+        const auto &front = *first, &back = *(last - 1);
+        const u32 start_byte = std::min(front.StartByte, delta.StartByte);
+        long long old_byte_count = std::max(back.NewEndByte(), delta.OldEndByte) - start_byte;
+        for (auto it = first; it != last; ++it) old_byte_count -= (long long)it->Text.size() - (long long)(it->OldEndByte - it->StartByte);
+
+        std::string text;
+        if (delta.StartByte > front.StartByte) text += front.Text.substr(0, delta.StartByte - front.StartByte);
+        text += delta.Text;
+        if (delta.OldEndByte < back.NewEndByte()) text += back.Text.substr(delta.OldEndByte - back.StartByte);
+        delta = {start_byte, u32(start_byte + old_byte_count), std::move(text)};
+        first = deltas.erase(first, last);
+    }
+    for (auto it = first; it != deltas.end(); ++it) {
+        it->StartByte += size_change;
+        it->OldEndByte += size_change;
+    }
+    if (delta.StartByte != delta.OldEndByte || !delta.Text.empty()) deltas.insert(first, std::move(delta));
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+using u32 = unsigned int;
+
+// Replaces bytes `[StartByte, OldEndByte)` with `Text`.
+// Unlike `TextInputEdit`, holds the new text, so it can be applied to a buffer.
+struct TextBufferDelta {
+    u32 StartByte{0}, OldEndByte{0};
+    std::string Text{};
+
+    u32 NewEndByte() const { return StartByte + Text.size(); }
+
+    bool operator==(const TextBufferDelta &) const = default;
+};
+
+// Sorted, non-overlapping deltas, applied in order.
+// Each delta's bytes are relative to the text after the deltas before it are applied,
+// which (since they're sorted) are also its bytes in the text after all deltas are applied.
+using TextBufferDeltas = std::vector<TextBufferDelta>;
+
+// Compose a delta relative to the text after all `deltas` are applied into `deltas`,
+// merging it with any deltas it overlaps or touches.
+// E.g. adding each char typed in a row results in a single delta inserting all of them.
+void AddDelta(TextBufferDeltas &, TextBufferDelta);
@@ -0,0 +1,62 @@
+#include "TextBufferLineLayout.h"
+
+#include <algorithm>
+#include <tuple>
+
+#include "immer/algorithm.hpp"
+
+size_t TextBufferLineLayout::HashTransitions(const ByteTransitions<u32> &transitions, u32 start_byte, u32 end_byte) {
+    auto it = transitions.Find(start_byte);
+    size_t hash = *it;
+    while (it.HasNext() && it.NextByteIndex() < end_byte) {
+        ++it;
+        for (const size_t value : {size_t(it.ByteIndex - start_byte), size_t(*it)}) hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    }
+    return hash;
+}
+
+size_t TextBufferLineLayout::HashLine(const TextBufferLine &line) {
+    // FNV-1a, char by char, so equal lines hash equally however their chunks are split.
+    size_t hash = 14695981039346656037ull;
+    immer::for_each_chunk(line, [&hash](const char *begin, const char *end) {
+        for (const char *ch = begin; ch != end; ++ch) hash = (hash ^ (unsigned char)*ch) * 1099511628211ull;
+    });
+    return hash;
+}
+
+TextBufferLineLayout::TextBufferLineLayout(TextBufferLine line, u32 start_byte, const ByteTransitions<u32> &transitions)
+    : Line(std::move(line)), TransitionsHash(HashTransitions(transitions, start_byte, start_byte + Line.size())) {
+    Columns.reserve(Line.size() + 1);
+    auto transition_it = transitions.Find(start_byte);
+    bool is_run_open = false; // Whether the next char can extend the last run.
+    u32 ci = 0, column = 0;
+    while (ci < Line.size()) {
+        const char ch = Line[ci];
+        const u32 seq_length = std::min(UTF8CharLength(ch), u32(Line.size()) - ci);
+        Columns.insert(Columns.end(), seq_length, column);
+        if (ch == '\t') {
+            WhitespaceCharIndices.push_back(ci);
+            is_run_open = false;
+        } else {
+            if (ch == ' ') WhitespaceCharIndices.push_back(ci);
+            transition_it.MoveForwardTo(start_byte + ci);
+            if (const u32 capture_id = *transition_it; !is_run_open || seq_length > 1 || capture_id != Runs.back().CaptureId) {
+                Runs.push_back({column, column, capture_id, {}});
+            }
+            auto &run = Runs.back();
+            for (u32 i = 0; i < seq_length; ++i) run.Text += Line[ci + i];
+            ++run.EndColumn;
+            is_run_open = seq_length == 1;
+        }
+        std::tie(ci, column) = TextBufferData::NextCharIndexAndColumn(Line, ci, column);
+    }
+    Columns.push_back(column);
+}
+
+u32 TextBufferLineLayout::CharIndexAtColumn(u32 column) const {
+    const auto char_columns = std::ranges::subrange(Columns.begin(), Columns.end() - 1);
+    const u32 ci = std::ranges::lower_bound(char_columns, column) - Columns.begin();
+    // Step back to the start of a wide char (tab) covering the column.
+    if (ci > 0 && Columns[ci] > column) return std::ranges::lower_bound(char_columns, Columns[ci - 1]) - Columns.begin();
+    return ci;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "ByteTransitions.h"
+#include "TextBufferData.h"
+
+// A line's chars laid out on the column grid, and its text split into runs of the same style.
+// Only depends on the line's text and the style transitions in its byte range (relative to the line start), not on where the line is,
+// so it's cached across frames by content, and shared by all lines with the same text and styles.
+struct TextBufferLineLayout {
+    // Consecutive single-byte chars with the same capture ID, drawn as a single text run.
+    // Tabs end runs, and multi-byte chars get runs of their own, so each run is aligned to the column grid.
+    struct Run {
+        u32 StartColumn, EndColumn, CaptureId;
+        std::string Text;
+    };
+
+    // `start_byte` is only used to find the line's transitions.
+    TextBufferLineLayout(TextBufferLine, u32 start_byte, const ByteTransitions<u32> &);
+
+    // Hash of the style the line starts with, and the transitions (relative to the line start) in the line's bytes.
+    // Layouts only depend on these, so edits and parses that don't change the line's styles keep its cached layout.
+    static size_t HashTransitions(const ByteTransitions<u32> &, u32 start_byte, u32 end_byte);
+    // Hash of the line's chars, independent of how its chars are split into chunks.
+    static size_t HashLine(const TextBufferLine &);
+    // Cache key for a line's layout: Lines with equal keys usually have the same layout, which `IsFor` confirms.
+    static size_t Key(size_t line_hash, size_t transitions_hash) { return line_hash ^ (transitions_hash + 0x9e3779b9 + (line_hash << 6) + (line_hash >> 2)); }
+
+    bool IsFor(const TextBufferLine &line, size_t transitions_hash) const { return TransitionsHash == transitions_hash && Line == line; }
+
+    u32 MaxColumn() const { return Columns.back(); }
+    // Index of the char covering `column`, or the line's size if the line ends before it.
+    u32 CharIndexAtColumn(u32 column) const;
+
+    TextBufferLine Line;
+    size_t TransitionsHash;
+    std::vector<u32> Columns{}; // Start column of each byte, followed by the line's end column.
+    std::vector<Run> Runs{};
+    std::vector<u32> WhitespaceCharIndices{}; // Tabs and spaces
+};
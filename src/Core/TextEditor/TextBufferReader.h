@@ -0,0 +1,61 @@
+#pragma once
+
+#include <tree_sitter/api.h>
+
+#include "immer/algorithm.hpp"
+
+#include "TextBufferData.h"
+
+// Hands tree-sitter the text of a snapshot of the buffer's lines, directly from the lines' leaf chunks, without copying.
+// Each read returns the longest contiguous span starting at the requested byte: The rest of the leaf chunk containing it,
+// or a single line break (lines don't store their line breaks).
+// Reads are by byte rather than by point, since edits passed to `ts_tree_edit` only have byte positions.
+// Tree-sitter reads mostly sequentially, so we keep the line containing the last read byte to start searching from.
+struct TextBufferReader {
+    explicit TextBufferReader(TextBufferLines text) : Text(std::move(text)) {}
+
+    TSInput GetInput() { return {this, Read, TSInputEncodingUTF8, nullptr}; }
+
+    static const char *Read(void *payload, u32 byte_index, TSPoint, u32 *bytes_read) {
+        static constexpr char newline = '\n';
+
+        auto &reader = *static_cast<TextBufferReader *>(payload);
+        ++reader.ReadCount;
+        *bytes_read = 0;
+
+        const auto &text = reader.Text;
+        if (text.empty()) return nullptr;
+
+        // Each line but the last is followed by a line break.
+        while (reader.Li > 0 && byte_index < reader.LineStartByte) {
+            --reader.Li;
+            reader.LineStartByte -= text[reader.Li].size() + 1;
+        }
+        while (reader.Li + 1 < text.size() && byte_index > reader.LineStartByte + text[reader.Li].size()) {
+            reader.LineStartByte += text[reader.Li].size() + 1;
+            ++reader.Li;
+        }
+
+        const auto &line = text[reader.Li];
+        const u32 column = byte_index - reader.LineStartByte;
+        if (column > line.size()) return nullptr; // Past the end of the text.
+        if (column == line.size()) {
+            if (reader.Li + 1 == text.size()) return nullptr; // End of the text.
+
+            *bytes_read = 1;
+            return &newline;
+        }
+
+        const char *chunk = nullptr;
+        immer::for_each_chunk_p(line.begin() + column, line.end(), [&chunk, bytes_read](const char *first, const char *last) {
+            chunk = first;
+            *bytes_read = last - first;
+            return false; // Only the first chunk.
+        });
+        return chunk;
+    }
+
+    const TextBufferLines Text;
+    u32 Li{0}, LineStartByte{0}; // The line containing the last read byte, and the byte index of its start.
+    u32 ReadCount{0};
+};
@@ -0,0 +1,67 @@
+#include "TextBufferSearch.h"
+
+#include <array>
+#include <regex>
+
+namespace {
+constexpr char ToLower(char ch) { return ch >= 'A' && ch <= 'Z' ? ch - 'A' + 'a' : ch; }
+
+std::vector<TextBufferMatch> FindAllLiteral(std::string_view text, std::string pattern, bool case_sensitive, u32 start_byte, u32 max_count) {
+    std::vector<TextBufferMatch> matches;
+    const u32 n = text.size(), m = pattern.size();
+    if (m == 0 || m > n) return matches;
+
+    const auto fold = [case_sensitive](char ch) { return case_sensitive ? ch : ToLower(ch); };
+    if (!case_sensitive) {
+        for (auto &ch : pattern) ch = ToLower(ch);
+    }
+    // Shift for each byte, based on the window's last byte: The distance from its last occurrence in the pattern
+    // (excluding the pattern's last byte) to the pattern's end.
+    std::array<u32, 256> shift;
+    shift.fill(m);
+    for (u32 i = 0; i < m - 1; ++i) {
+        const auto ch = (unsigned char)pattern[i];
+        shift[ch] = m - 1 - i;
+        if (!case_sensitive && ch >= 'a' && ch <= 'z') shift[ch - 'a' + 'A'] = m - 1 - i;
+    }
+
+    const char last = pattern[m - 1];
+    for (u32 i = start_byte; i + m <= n && matches.size() < max_count;) {
+        const char ch = text[i + m - 1];
+        if (fold(ch) == last) {
+            u32 j = 0;
+            while (j < m - 1 && fold(text[i + j]) == pattern[j]) ++j;
+            if (j == m - 1) {
+                matches.push_back({i, i + m});
+                i += m;
+                continue;
+            }
+        }
+        i += shift[(unsigned char)ch];
+    }
+    return matches;
+}
+
+std::vector<TextBufferMatch> FindAllRegex(std::string_view text, const std::string &pattern, bool case_sensitive, u32 start_byte, u32 max_count) {
+    std::vector<TextBufferMatch> matches;
+    if (pattern.empty() || start_byte > text.size()) return matches;
+
+    std::regex regex;
+    try {
+        regex = std::regex{pattern, case_sensitive ? std::regex::ECMAScript : std::regex::ECMAScript | std::regex::icase};
+    } catch (const std::regex_error &) {
+        return matches;
+    }
+    using Iterator = std::regex_iterator<std::string_view::const_iterator>;
+    for (auto it = Iterator{text.begin() + start_byte, text.end(), regex, std::regex_constants::match_not_null}; it != Iterator{} && matches.size() < max_count; ++it) {
+        const u32 start = it->position() + start_byte;
+        matches.push_back({start, start + u32(it->length())});
+    }
+    return matches;
+}
+} // namespace
+
+std::vector<TextBufferMatch> TextBufferSearch::FindAll(std::string_view text, u32 start_byte, u32 max_count) const {
+    if (Regex) return FindAllRegex(text, Pattern, CaseSensitive, start_byte, max_count);
+    return FindAllLiteral(text, Pattern, CaseSensitive, start_byte, max_count);
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using u32 = unsigned int;
+
+// Byte range `[Start, End)` of a search match.
+struct TextBufferMatch {
+    u32 Start, End;
+};
+
+// A literal or regex (ECMAScript) search for `Pattern`.
+// Literal patterns are matched with Boyer-Moore-Horspool, which skips ahead by up to the pattern length after a mismatch.
+struct TextBufferSearch {
+    std::string Pattern;
+    bool CaseSensitive{true}, Regex{false};
+
+    // Returns the non-empty, non-overlapping matches in `text` starting at or after `start_byte`, in order,
+    // stopping after `max_count` matches.
+    // An invalid regex has no matches.
+    std::vector<TextBufferMatch> FindAll(std::string_view text, u32 start_byte = 0, u32 max_count = std::numeric_limits<u32>::max()) const;
+};
@@ -11,6 +11,7 @@ TextEditor::~TextEditor() {}
 
 bool TextEditor::Empty() const { return Buffer.Empty(); }
 std::string TextEditor::GetText() const { return Buffer.GetText(); }
+std::optional<bool> TextEditor::HasSyntaxErrors() const { return Buffer.HasSyntaxErrors(); }
 
 using namespace ImGui;
 
@@ -11,6 +11,7 @@ struct TextEditor : Component {
 
     bool Empty() const;
     std::string GetText() const;
+    std::optional<bool> HasSyntaxErrors() const;
 
     fs::path _LastOpenedFilePath;
     Prop(TextBuffer, Buffer, _LastOpenedFilePath);
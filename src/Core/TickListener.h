@@ -0,0 +1,10 @@
+#pragma once
+
+struct TickListener {
+    // Called once per project tick, before queued actions are applied, whether or not any frame is rendered (e.g. in headless runs).
+    // Listeners poll background work here, and queue actions to adopt its results.
+    virtual void OnTick() = 0;
+    // Returns true while background work polled in `OnTick` is unfinished or not yet adopted,
+    // so headless runs can keep ticking until it's done.
+    virtual bool IsBusy() const { return false; }
+};
@@ -12,6 +12,7 @@
 #include <SDL3/SDL_vulkan.h>
 #include <vulkan/vulkan.h>
 
+#include "Core/Profiler.h"
 #include "Core/Scalar.h"
 
 #ifdef TRACING_ENABLED
@@ -380,6 +381,7 @@ void RenderFrame() {
 }
 
 bool UIContext::Tick() const {
+    ProfileZone("UIContext::Tick");
     // Poll and handle events (inputs, window resize, etc.)
     // You can read the io.WantCaptureMouse, io.WantCaptureKeyboard flags to tell if dear imgui wants to use your inputs.
     // - When io.WantCaptureMouse is true, do not dispatch mouse input data to your main application, or clear/overwrite your copy of the mouse data.
@@ -409,12 +411,18 @@ bool UIContext::Tick() const {
     Predraw();
 
     PrepareFrame();
+    {
+        ProfileZone("Draw");
 #ifdef ONLY_RENDER_METRICS_WINDOW
-    ImGui::ShowMetricsWindow();
+        ImGui::ShowMetricsWindow();
 #else
-    Draw(); // All project content drawing, initial dockspace setup, keyboard shortcuts.
+        Draw(); // All project content drawing, initial dockspace setup, keyboard shortcuts.
 #endif
-    RenderFrame();
+    }
+    {
+        ProfileZone("RenderFrame");
+        RenderFrame();
+    }
 
 #ifdef TRACING_ENABLED
     FrameMark;
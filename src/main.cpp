@@ -1,15 +1,30 @@
+#include <iostream>
+
 #include "imgui_internal.h"
 #include "implot.h"
 
 #include "Core/FileDialog/FileDialogManager.h"
+#include "Core/Profiler.h"
+#include "Core/Project/HeadlessRunner.h"
 #include "Core/Project/Project.h"
 #include "Core/UI/Fonts.h"
 #include "Core/UI/UIContext.h"
 
 #include "FlowGrid.h"
 
-int main() {
+int main(int argc, char **argv) {
+    ProfileThread("UI");
+    std::optional<HeadlessRunOptions> headless_options;
+    try {
+        headless_options = HeadlessRunOptions::Parse(argc, argv);
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+
     Project project{[](auto app_args) { return std::make_unique<FlowGrid>(std::move(app_args)); }};
+    if (headless_options) return RunHeadless(project, *headless_options);
+
     const auto &core = project.Core;
 
     auto predraw = [&core]() {
@@ -0,0 +1,140 @@
+#include <algorithm>
+#include <format>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "Core/TextEditor/ByteTransitions.h"
+
+/**
+Applies random sequences of `Insert`, `Delete`, and `Splice` to `ByteTransitions`, and checks after each operation that
+its transitions, size, and point lookups match a flat sorted vector with the same operations applied.
+Also checks that copies taken before an operation are unaffected by it.
+
+Usage: `flowgrid-byte-transitions-test`
+*/
+
+using Transition = std::pair<u32, int>; // (Byte, Value)
+using Transitions = ByteTransitions<int>;
+
+static constexpr int DefaultValue = -1, ValueCount = 4;
+static constexpr u32 SeedCount = 16, OperationCount = 2000, MaxByte = 256;
+
+static int FailureCount = 0;
+static bool Check(bool condition, std::string_view message) {
+    if (condition) return true;
+    std::cerr << "FAILED: " << message << '\n';
+    FailureCount++;
+    return false;
+}
+
+// Straightforward implementation of each operation's documented behavior, on sorted (byte, value) pairs.
+struct FlatTransitions {
+    std::vector<Transition> Items{};
+
+    int At(u32 byte_index) const {
+        int value = DefaultValue;
+        for (const auto &[byte, v] : Items) {
+            if (byte > byte_index) break;
+            value = v;
+        }
+        return value;
+    }
+
+    void Insert(u32 byte_index, int value) {
+        std::erase_if(Items, [byte_index](const auto &t) { return t.first == byte_index; });
+        Items.insert(std::ranges::lower_bound(Items, byte_index, {}, &Transition::first), {byte_index, value});
+    }
+
+    void Delete(u32 start_byte, u32 end_byte) {
+        std::erase_if(Items, [=](const auto &t) { return t.first >= start_byte && t.first < end_byte; });
+    }
+
+    void Splice(u32 start_byte, u32 old_end_byte, u32 new_end_byte) {
+        const int value_before = start_byte == 0 ? DefaultValue : At(start_byte - 1);
+        std::optional<int> last_replaced_value;
+        bool has_old_end_transition = false;
+        std::vector<Transition> items;
+        for (const auto &[byte, value] : Items) {
+            if (byte < start_byte) {
+                items.emplace_back(byte, value);
+            } else if (byte < old_end_byte) {
+                last_replaced_value = value;
+            } else {
+                if (byte == old_end_byte) has_old_end_transition = true;
+                items.emplace_back(byte - old_end_byte + new_end_byte, value);
+            }
+        }
+        Items = std::move(items);
+        if (last_replaced_value && !has_old_end_transition && *last_replaced_value != value_before) {
+            Items.insert(std::ranges::lower_bound(Items, new_end_byte, {}, &Transition::first), {new_end_byte, *last_replaced_value});
+        }
+    }
+};
+
+static std::vector<Transition> Collect(const Transitions &transitions) {
+    std::vector<Transition> items;
+    auto it = transitions.begin();
+    if (it.IsAt(0)) items.emplace_back(0, *it);
+    while (it.HasNext()) {
+        ++it;
+        items.emplace_back(it.ByteIndex, *it);
+    }
+    return items;
+}
+
+static bool CheckEqual(const Transitions &transitions, const FlatTransitions &expected, std::string_view operation) {
+    if (!Check(Collect(transitions) == expected.Items, std::format("Transitions differ after {}.", operation))) return false;
+    if (!Check(transitions.size() == expected.Items.size(), std::format("Size differs after {}.", operation))) return false;
+
+    // Sweep the expected values along with the bytes.
+    const u32 end_byte = expected.Items.empty() ? 0 : expected.Items.back().first + 1;
+    int expected_value = DefaultValue;
+    auto next = expected.Items.begin();
+    for (u32 byte = 0; byte <= end_byte; ++byte) {
+        if (next != expected.Items.end() && next->first == byte) expected_value = (next++)->second;
+        if (transitions.At(byte) != expected_value) return Check(false, std::format("Value at byte {} differs after {}.", byte, operation));
+    }
+    return true;
+}
+
+int main() {
+    for (u32 seed = 0; seed < SeedCount; ++seed) {
+        std::mt19937 rng{seed};
+        std::uniform_int_distribution<u32> op_dist{0, 2}, byte_dist{0, MaxByte}, length_dist{0, 16};
+        std::uniform_int_distribution<int> value_dist{0, ValueCount - 1};
+
+        Transitions transitions{DefaultValue};
+        FlatTransitions expected;
+        for (u32 i = 0; i < OperationCount; ++i) {
+            const Transitions before = transitions;
+            const auto expected_before = expected;
+            const u32 op = op_dist(rng), start = byte_dist(rng), end = start + length_dist(rng);
+            std::string operation;
+            if (op == 0) {
+                const int value = value_dist(rng);
+                operation = std::format("Insert({}, {})", start, value);
+                transitions.Insert(start, value);
+                expected.Insert(start, value);
+            } else if (op == 1) {
+                operation = std::format("Delete({}, {})", start, end);
+                transitions.Delete(start, end);
+                expected.Delete(start, end);
+            } else {
+                const u32 new_end = start + length_dist(rng);
+                operation = std::format("Splice({}, {}, {})", start, end, new_end);
+                transitions.Splice(start, end, new_end);
+                expected.Splice(start, end, new_end);
+            }
+
+            const auto context = std::format("{} (seed {}, operation {})", operation, seed, i);
+            if (!CheckEqual(transitions, expected, context)) break;
+            if (!CheckEqual(before, expected_before, std::format("{}, in a copy taken before it", context))) break;
+        }
+    }
+
+    if (FailureCount == 0) std::cerr << "All checks passed.\n";
+    return FailureCount == 0 ? 0 : 1;
+}
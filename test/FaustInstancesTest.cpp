@@ -0,0 +1,96 @@
+#include <format>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "Audio/Faust/FaustCompileProfile.h"
+#include "Audio/Faust/FaustInstance.h"
+#include "Audio/Faust/FaustLibraries.h"
+
+#include "faust/dsp/llvm-dsp.h"
+
+/**
+Compiles the same Faust program for 64 nodes, and checks that:
+- Only the first compile creates a factory, and all others share it.
+- Instances cloned from one prototype each have their own DSP state.
+- A detached param controls only its own instance.
+
+Usage: `flowgrid-faust-instances-test` (run from the build directory, so the Faust libraries are found).
+*/
+
+static constexpr unsigned InstanceCount = 64, SampleRate = 48000, BlockFrames = 16;
+// A stateful program (a running sum of its param), so instances sharing state would diverge from each other.
+static const std::string Code{"process = hslider(\"step\", 1, 0, 10, 1) : +~_;"};
+
+static int FailureCount = 0;
+static void Check(bool condition, std::string_view message) {
+    if (condition) return;
+    std::cerr << "FAILED: " << message << '\n';
+    FailureCount++;
+}
+
+static std::vector<Sample> ComputeBlock(dsp &instance) {
+    std::vector<Sample> output(BlockFrames);
+    Sample *outputs[]{output.data()};
+    instance.compute(BlockFrames, nullptr, outputs);
+    return output;
+}
+
+int main() {
+    FaustLibraries::Acquire();
+    {
+        std::vector<FaustCompileResult> results;
+        for (unsigned i = 0; i < InstanceCount; ++i) results.push_back(CompileFaust(Code, {}));
+
+        Check(results.front().Dsp != nullptr, std::format("Compile failed: {}", results.front().ErrorMessage));
+        if (!results.front().Dsp) return 1;
+
+        unsigned compile_count = 0;
+        for (const auto &result : results) {
+            if (!result.FromCache) compile_count++;
+            Check(result.DspFactory == results.front().DspFactory, "All compiles share one factory.");
+            Check(result.Box == results.front().Box, "All compiles share one box.");
+        }
+        Check(compile_count == 1, std::format("Expected 1 compile of {} identical programs, got {}.", InstanceCount, compile_count));
+
+        // Programs only share a compile if both their code and options are equal.
+        std::vector<FaustCompileResult> others{CompileFaust(Code + " ", {}), CompileFaust(Code, {.Mode = FaustCompileMode_Vector})};
+        Check(!others[0].FromCache, "Different code is compiled separately.");
+        Check(!others[1].FromCache, "Different options are compiled separately.");
+
+        auto *prototype = results.front().Dsp;
+        prototype->init(SampleRate);
+        std::vector<std::unique_ptr<FaustInstance>> instances;
+        for (unsigned i = 0; i < InstanceCount; ++i) {
+            auto &instance = instances.emplace_back(std::make_unique<FaustInstance>(prototype));
+            instance->instanceInit(SampleRate);
+        }
+
+        // Advance the first instance, and check the others still start from their initial state.
+        const auto first_block = ComputeBlock(*instances[0]);
+        ComputeBlock(*instances[0]);
+        for (unsigned i = 1; i < InstanceCount; ++i) Check(ComputeBlock(*instances[i]) == first_block, std::format("Instance {} has its own state.", i));
+        Check(first_block.back() == Sample(BlockFrames), "Instances follow the prototype's param value.");
+
+        // A detached param only affects its own instance.
+        const auto path = instances[1]->FindPath("step");
+        instances[1]->Detach(path);
+        *instances[1]->GetZone(path) = 2;
+        Check(ComputeBlock(*instances[1]).back() - first_block.back() == 2 * BlockFrames, "A detached param controls its own instance.");
+        Check(ComputeBlock(*instances[2]).back() - first_block.back() == BlockFrames, "Other instances keep following the prototype.");
+        instances[1]->Attach(path);
+        Check(*instances[1]->GetZone(path) == 2, "Attaching doesn't change the zone until the next compute.");
+
+        instances.clear();
+        for (auto *compiled : {&results, &others}) {
+            for (auto &result : *compiled) {
+                delete result.Dsp;
+                if (result.DspFactory) deleteDSPFactory(result.DspFactory);
+            }
+        }
+    }
+    FaustLibraries::Release();
+
+    if (FailureCount == 0) std::cerr << "All checks passed.\n";
+    return FailureCount == 0 ? 0 : 1;
+}
@@ -0,0 +1,99 @@
+#include <algorithm>
+#include <format>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "Core/TextEditor/TextBufferData.h"
+
+/**
+Applies random sequences of `Insert` and `DeleteRange` to `TextBufferData`, and checks after each operation that
+its text, line count, byte size, byte/line-char conversions, and recorded edit match a `std::string` with the same edits applied.
+Also checks that copies taken before an operation are unaffected by it.
+
+Usage: `flowgrid-text-buffer-data-test`
+*/
+
+TextBufferStyle GTextBufferStyle{}; // Defined by `TextBuffer`, which isn't linked into this test.
+
+static constexpr u32 SeedCount = 16, OperationCount = 1000, MaxInsertBytes = 24, MaxDeleteBytes = 48;
+
+static int FailureCount = 0;
+static bool Check(bool condition, std::string_view message) {
+    if (condition) return true;
+    std::cerr << "FAILED: " << message << '\n';
+    FailureCount++;
+    return false;
+}
+
+static u32 CountLines(const std::string &text) { return u32(std::ranges::count(text, '\n')) + 1; }
+
+// Short lines and frequent empty lines, so edits often join and split lines.
+static std::string RandomText(std::mt19937 &rng, u32 max_bytes) {
+    static constexpr std::string_view Alphabet{"abcxyz \t\n\n"};
+    std::string text(std::uniform_int_distribution<u32>{0, max_bytes}(rng), ' ');
+    for (auto &ch : text) ch = Alphabet[std::uniform_int_distribution<size_t>{0, Alphabet.size() - 1}(rng)];
+    return text;
+}
+
+static bool CheckMatches(const TextBufferData &buffer, const std::string &expected, std::string_view context) {
+    if (!Check(buffer.GetText() == expected, std::format("{}: text mismatch", context))) return false;
+    if (!Check(buffer.LineCount() == CountLines(expected), std::format("{}: {} lines, expected {}", context, buffer.LineCount(), CountLines(expected)))) return false;
+    if (!Check(buffer.EndByteIndex() == expected.size(), std::format("{}: {} bytes, expected {}", context, buffer.EndByteIndex(), expected.size()))) return false;
+
+    // Every byte index (including the end) maps to a line/char and back.
+    LineChar lc{0, 0};
+    for (u32 byte = 0; byte <= expected.size(); byte++) {
+        if (!Check(buffer.ToLineChar(byte) == lc, std::format("{}: byte {} -> ({}, {}), expected ({}, {})", context, byte, buffer.ToLineChar(byte).L, buffer.ToLineChar(byte).C, lc.L, lc.C))) return false;
+        if (!Check(buffer.ToByteIndex(lc) == byte, std::format("{}: ({}, {}) -> byte {}, expected {}", context, lc.L, lc.C, buffer.ToByteIndex(lc), byte))) return false;
+        if (byte < expected.size()) lc = expected[byte] == '\n' ? LineChar{lc.L + 1, 0} : LineChar{lc.L, lc.C + 1};
+    }
+    return true;
+}
+
+static bool CheckLastEdit(const TextBufferData &buffer, TextInputEdit expected, std::string_view context) {
+    if (!Check(!buffer.Edits.empty(), std::format("{}: no edit recorded", context))) return false;
+    const auto &edit = buffer.Edits.back();
+    return Check(
+        edit == expected,
+        std::format(
+            "{}: edit ({}, {}, {}), expected ({}, {}, {})", context, edit.StartByte, edit.OldEndByte, edit.NewEndByte,
+            expected.StartByte, expected.OldEndByte, expected.NewEndByte
+        )
+    );
+}
+
+int main() {
+    for (u32 seed = 0; seed < SeedCount; seed++) {
+        std::mt19937 rng{seed};
+        std::string expected = RandomText(rng, 256);
+        TextBufferData buffer = TextBufferData{}.SetText(expected);
+        if (!CheckMatches(buffer, expected, std::format("Seed {}: SetText", seed))) continue;
+
+        for (u32 op = 0; op < OperationCount; op++) {
+            const auto before = buffer;
+            const std::string expected_before = expected;
+            const u32 start = std::uniform_int_distribution<u32>{0, u32(expected.size())}(rng);
+            const bool insert = expected.empty() || std::bernoulli_distribution{0.5}(rng);
+            std::string context;
+            if (insert) {
+                const auto text = RandomText(rng, MaxInsertBytes);
+                context = std::format("Seed {}, op {}: Insert {} bytes at {}", seed, op, text.size(), start);
+                buffer = buffer.Insert(TextBufferData::ToLines(text), buffer.ToLineChar(start), false).first;
+                expected.insert(start, text);
+                if (!CheckLastEdit(buffer, {start, start, start + u32(text.size())}, context)) break;
+            } else {
+                const u32 end = std::min(u32(expected.size()), start + std::uniform_int_distribution<u32>{1, MaxDeleteBytes}(rng));
+                context = std::format("Seed {}, op {}: Delete [{}, {})", seed, op, start, end);
+                buffer = buffer.DeleteRange({buffer.ToLineChar(start), buffer.ToLineChar(end)}, false);
+                expected.erase(start, end - start);
+                if (start != end && !CheckLastEdit(buffer, {start, end, start}, context)) break;
+            }
+            if (!CheckMatches(buffer, expected, context)) break;
+            if (!Check(before.GetText() == expected_before, std::format("{}: copy changed", context))) break;
+        }
+    }
+
+    if (FailureCount == 0) std::cerr << "All checks passed.\n";
+    return FailureCount == 0 ? 0 : 1;
+}